@@ -0,0 +1,204 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+/** Count the heap allocations made by the solvers.
+ *
+ * Each benchmark solves repeatedly problems of the same size with the same solver
+ * instance. On top of the timings, the following counters are recorded:
+ *  - allocFirst: number of allocations during the first solve
+ *  - allocPerSolve: average number of allocations per solve for the subsequent ones
+ *
+ * allocPerSolve is expected to be 0: once a solver has been used for a given problem
+ * size, it should not allocate memory anymore.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/BlockGISolver.h>
+#include <jrl-qp/experimental/BoxAndSingleConstraintSolver.h>
+#include <jrl-qp/experimental/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/test/randomProblems.h>
+
+#include "AllocationCounter.h"
+
+using namespace Eigen;
+using namespace jrl::qp;
+using namespace jrl::qp::test;
+
+namespace
+{
+constexpr int NbPb = 10;
+
+void setCounters(benchmark::State & st, long long first, long long total, long long nbSolve)
+{
+  st.counters["allocFirst"] = static_cast<double>(first);
+  st.counters["allocPerSolve"] = nbSolve > 0 ? static_cast<double>(total) / static_cast<double>(nbSolve) : 0;
+}
+
+/** Dense problems with n variables, n inequality constraints (half of them active)
+ * and bounds, stored in the format expected by the jrl-qp dense solvers.
+ */
+struct DenseProblems
+{
+  DenseProblems(int n)
+  {
+    for(int i = 0; i < NbPb; ++i)
+    {
+      QPProblem qpp(randomProblem(ProblemCharacteristics(n, n, 0, n).nStrongActIneq(n / 2).bounds(true)));
+      G.push_back(qpp.G);
+      a.push_back(qpp.a);
+      C.push_back(qpp.C.transpose());
+      l.push_back(qpp.l);
+      u.push_back(qpp.u);
+      xl.push_back(qpp.xl);
+      xu.push_back(qpp.xu);
+    }
+  }
+
+  std::vector<MatrixXd> G, C;
+  std::vector<VectorXd> a, l, u, xl, xu;
+};
+
+template<typename Solver>
+void BM_Dense(benchmark::State & st, bool warmStart)
+{
+  int n = static_cast<int>(st.range(0));
+  DenseProblems pb(n);
+  MatrixXd G(n, n);
+  Solver solver(n, n, true);
+  SolverOptions opt;
+  opt.warmStart(warmStart);
+  solver.options(opt);
+
+  long long first = -1;
+  long long total = 0;
+  long long nbSolve = 0;
+  int i = 0;
+  for(auto _ : st)
+  {
+    st.PauseTiming();
+    G = pb.G[i];
+    st.ResumeTiming();
+    AllocationCounter counter;
+    solver.solve(G, pb.a[i], pb.C[i], pb.l[i], pb.u[i], pb.xl[i], pb.xu[i]);
+    if(first < 0)
+      first = counter.count();
+    else
+    {
+      total += counter.count();
+      ++nbSolve;
+    }
+    i = (i + 1) % NbPb;
+  }
+  setCounters(st, first, total, nbSolve);
+}
+
+void BM_GI(benchmark::State & st)
+{
+  BM_Dense<GoldfarbIdnaniSolver>(st, false);
+}
+
+void BM_GIExp(benchmark::State & st)
+{
+  BM_Dense<experimental::GoldfarbIdnaniSolver>(st, false);
+}
+
+void BM_GIExpWarm(benchmark::State & st)
+{
+  BM_Dense<experimental::GoldfarbIdnaniSolver>(st, true);
+}
+
+void BM_BoxAndSingleConstraint(benchmark::State & st)
+{
+  int n = static_cast<int>(st.range(0));
+  std::vector<LeastSquareProblem<>> pb;
+  for(int i = 0; i < NbPb; ++i) pb.push_back(generateBoxAndSingleConstraintProblem(n, i % 2));
+  experimental::BoxAndSingleConstraintSolver solver(n);
+
+  long long first = -1;
+  long long total = 0;
+  long long nbSolve = 0;
+  int i = 0;
+  for(auto _ : st)
+  {
+    AllocationCounter counter;
+    solver.solve(pb[i].b, pb[i].C, pb[i].l[0], pb[i].xl, pb[i].xu);
+    if(first < 0)
+      first = counter.count();
+    else
+    {
+      total += counter.count();
+      ++nbSolve;
+    }
+    i = (i + 1) % NbPb;
+  }
+  setCounters(st, first, total, nbSolve);
+}
+
+/** Tri-block-diagonal objective with blocks of size 5 and 3 constraints per block.*/
+void BM_BlockGI(benchmark::State & st)
+{
+  const int nb = static_cast<int>(st.range(0)) / 5;
+  const int n = 5 * nb;
+  const int m = 3 * nb;
+  MatrixXd A = MatrixXd::Zero(n, n);
+  for(int k = 0; k < nb; ++k)
+  {
+    A.block(5 * k, 5 * k, 5, 5).setRandom();
+    if(k + 1 < nb) A.block(5 * k + 5, 5 * k, 5, 5).setRandom();
+  }
+  const MatrixXd G0 = A * A.transpose() + MatrixXd::Identity(n, n);
+  MatrixXd GDense = G0;
+  std::vector<MatrixRef> D, S;
+  MatrixXd C0 = MatrixXd::Zero(n, m);
+  std::vector<MatrixConstRef> Cs;
+  for(int k = 0; k < nb; ++k)
+  {
+    D.push_back(GDense.block(5 * k, 5 * k, 5, 5));
+    if(k + 1 < nb) S.push_back(GDense.block(5 * k + 5, 5 * k, 5, 5));
+    C0.block(5 * k, 3 * k, 5, 3).setRandom();
+    Cs.push_back(C0.block(5 * k, 3 * k, 5, 3));
+  }
+  structured::StructuredG G(structured::StructuredG::Type::TriBlockDiagonal, D, S);
+  structured::StructuredC C(Cs);
+  VectorXd l = VectorXd::Constant(m, -1);
+  VectorXd u = VectorXd::Constant(m, 1);
+  VectorXd xl = VectorXd::Constant(n, -2);
+  VectorXd xu = VectorXd::Constant(n, 2);
+  std::vector<VectorXd> a;
+  for(int i = 0; i < NbPb; ++i) a.push_back(10 * VectorXd::Random(n));
+
+  experimental::BlockGISolver solver(n, m, true);
+  long long first = -1;
+  long long total = 0;
+  long long nbSolve = 0;
+  int i = 0;
+  for(auto _ : st)
+  {
+    st.PauseTiming();
+    GDense = G0;
+    st.ResumeTiming();
+    AllocationCounter counter;
+    solver.solve(G, a[i], C, l, u, xl, xu);
+    if(first < 0)
+      first = counter.count();
+    else
+    {
+      total += counter.count();
+      ++nbSolve;
+    }
+    i = (i + 1) % NbPb;
+  }
+  setCounters(st, first, total, nbSolve);
+}
+} // namespace
+
+BENCHMARK(BM_GI)->Unit(benchmark::kMicrosecond)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_GIExp)->Unit(benchmark::kMicrosecond)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_GIExpWarm)->Unit(benchmark::kMicrosecond)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_BoxAndSingleConstraint)->Unit(benchmark::kMicrosecond)->Arg(10)->Arg(50)->Arg(100);
+BENCHMARK(BM_BlockGI)->Unit(benchmark::kMicrosecond)->Arg(10)->Arg(50)->Arg(100);
+
+BENCHMARK_MAIN();
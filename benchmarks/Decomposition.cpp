@@ -1,11 +1,20 @@
 /* Copyright 2020 CNRS-AIST JRL */
 
+#include <algorithm>
+#include <vector>
+
 #include <Eigen/Cholesky>
 #include <Eigen/Core>
 #include <Eigen/QR>
 
 #include <benchmark/benchmark.h>
 
+#include <jrl-qp/decomposition/blockArrowLLT.h>
+#include <jrl-qp/decomposition/triBlockDiagLLT.h>
+#include <jrl-qp/internal/OrthonormalSequence.h>
+#include <jrl-qp/internal/ThreadPool.h>
+#include <jrl-qp/structured/StructuredQR.h>
+
 #include "common.h"
 
 using namespace Eigen;
@@ -123,4 +132,235 @@ static void BM_ColPivQR_Decomposition_Transpose(benchmark::State & state)
 }
 MAT_BENCHMARK(BM_ColPivQR_Decomposition_Transpose);
 
+// Product of a sequence of n/2 Householder reflectors (or its transpose) with a vector
+// having only 3 non-zero elements, starting at row n/4 (windowed) or with a dense
+// vector (full).
+static void BM_Householder_Apply(benchmark::State & state, bool transpose, bool windowed)
+{
+  using namespace jrl::qp::internal;
+  const int n = static_cast<int>(state.range(0));
+  const int k = n / 2;
+  ElemOrthonormalSequence H(OSeqType::Householder, n, k);
+  for(int j = 0; j < k; ++j)
+  {
+    VectorXd v = VectorXd::Random(n - j);
+    double tau, beta;
+    v.makeHouseholderInPlace(tau, beta);
+    H.add(v.tail(n - j - 1), tau);
+  }
+  const int start = windowed ? n / 4 : 0;
+  const int size = windowed ? 3 : n;
+  VectorXd u = VectorXd::Zero(n);
+  u.segment(start, size).setRandom();
+  VectorXd v(n);
+  for(auto _ : state)
+  {
+    v = u;
+    if(transpose)
+      H.applyTransposeToTheLeft(v, start, size);
+    else
+      H.applyToTheLeft(v, start, size);
+  }
+}
+BENCHMARK_CAPTURE(BM_Householder_Apply, Full, false, false)->Apply(testSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Householder_Apply, Windowed, false, true)->Apply(testSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Householder_Apply, TransposeFull, true, false)->Apply(testSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_Householder_Apply, TransposeWindowed, true, true)
+    ->Apply(testSizes)
+    ->Unit(benchmark::kMicrosecond);
+
+// Removal of all the columns of a QR decomposition, starting from the first one, with a
+// product by Q^T after each removal (as done by the solvers to compute the next step).
+// In the decoupled case, R is diagonal and the removals are permutations only.
+static void BM_StructuredQR_Remove(benchmark::State & state, bool decoupled)
+{
+  const int n = static_cast<int>(state.range(0));
+  const int m = n / 3;
+  std::vector<VectorXd> D;
+  for(int j = 0; j < m; ++j)
+  {
+    VectorXd d = VectorXd::Zero(n);
+    if(decoupled)
+      d.segment(m + 2 * j, 2).setRandom();
+    else
+      d.setRandom();
+    D.push_back(d);
+  }
+  VectorXd v = VectorXd::Random(n);
+  VectorXd w(n);
+  jrl::qp::structured::StructuredQR qr;
+  qr.resize(n);
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    qr.reset();
+    for(const auto & d : D)
+    {
+      w = d;
+      qr.getPartitionnedQ().Q().applyTransposeToTheLeft(w);
+      qr.add(w);
+    }
+    state.ResumeTiming();
+    for(int j = 0; j < m; ++j)
+    {
+      qr.remove(0);
+      w = v;
+      qr.getPartitionnedQ().Q().applyTransposeToTheLeft(w);
+    }
+  }
+}
+BENCHMARK_CAPTURE(BM_StructuredQR_Remove, Decoupled, true)->Apply(testSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_StructuredQR_Remove, Coupled, false)->Apply(testSizes)->Unit(benchmark::kMicrosecond);
+
+// Factorization of a block tri-diagonal matrix with state.range(0) blocks of size 10,
+// followed by a solve with L and L^T. The second argument is the number of threads, 0
+// meaning the sequential version.
+static void BM_TriBlockDiagLLT(benchmark::State & state)
+{
+  const int nb = static_cast<int>(state.range(0));
+  const int nbThreads = static_cast<int>(state.range(1));
+  const int bs = 10;
+  const int n = nb * bs;
+  MatrixXd A = MatrixXd::Zero(n, n);
+  for(int k = 0; k < nb; ++k)
+  {
+    A.block(bs * k, bs * k, bs, bs).setRandom();
+    if(k + 1 < nb) A.block(bs * k + bs, bs * k, bs, bs).setRandom();
+  }
+  const MatrixXd H0 = A * A.transpose() + MatrixXd::Identity(n, n);
+  MatrixXd H = H0;
+  std::vector<jrl::qp::MatrixRef> D, S;
+  for(int k = 0; k < nb; ++k)
+  {
+    D.push_back(H.block(bs * k, bs * k, bs, bs));
+    if(k + 1 < nb) S.push_back(H.block(bs * k + bs, bs * k, bs, bs));
+  }
+  VectorXd b = VectorXd::Random(n);
+  VectorXd x(n);
+
+  jrl::qp::internal::ThreadPool pool(std::max(1, nbThreads));
+  jrl::qp::decomposition::ParallelTriBlockDiagLLT llt(pool);
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    H = H0;
+    x = b;
+    state.ResumeTiming();
+    if(nbThreads == 0)
+    {
+      jrl::qp::decomposition::triBlockDiagLLT(D, S);
+      jrl::qp::decomposition::triBlockDiagLSolve(D, S, x);
+      jrl::qp::decomposition::triBlockDiagLTransposeSolve(D, S, x);
+    }
+    else
+    {
+      llt.compute(D, S);
+      llt.solveL(D, S, x);
+      llt.solveLTranspose(D, S, x);
+    }
+  }
+}
+BENCHMARK(BM_TriBlockDiagLLT)
+    ->ArgsProduct({{10, 50, 100, 200}, {0, 1, 2, 4, 8}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// Factorization of a down block arrow matrix with state.range(0) diagonal blocks of size
+// 10 and a tip of size 20, followed by a solve with L and L^T. The second argument is the
+// number of threads, 0 meaning the sequential version.
+static void BM_BlockArrowLLT(benchmark::State & state)
+{
+  const int nb = static_cast<int>(state.range(0));
+  const int nbThreads = static_cast<int>(state.range(1));
+  const int bs = 10;
+  const int nt = 20;
+  const int n = nb * bs + nt;
+  MatrixXd A = MatrixXd::Zero(n, n);
+  for(int k = 0; k < nb; ++k)
+  {
+    A.block(bs * k, bs * k, bs, bs).setRandom();
+    A.block(bs * k, n - nt, bs, nt).setRandom();
+  }
+  A.bottomRightCorner(nt, nt).setRandom();
+  const MatrixXd H0 = A.transpose() * A + MatrixXd::Identity(n, n);
+  MatrixXd H = H0;
+  std::vector<jrl::qp::MatrixRef> D, S;
+  for(int k = 0; k < nb; ++k)
+  {
+    D.push_back(H.block(bs * k, bs * k, bs, bs));
+    S.push_back(H.block(n - nt, bs * k, nt, bs));
+  }
+  D.push_back(H.bottomRightCorner(nt, nt));
+  VectorXd b = VectorXd::Random(n);
+  VectorXd x(n);
+
+  jrl::qp::internal::ThreadPool pool(std::max(1, nbThreads));
+  jrl::qp::internal::Workspace<> work;
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    H = H0;
+    x = b;
+    state.ResumeTiming();
+    if(nbThreads == 0)
+    {
+      jrl::qp::decomposition::blockArrowLLT(D, S, false);
+      jrl::qp::decomposition::blockArrowLSolve(D, S, false, x);
+      jrl::qp::decomposition::blockArrowLTransposeSolve(D, S, false, x);
+    }
+    else
+    {
+      jrl::qp::decomposition::blockArrowLLT(D, S, false, pool, work);
+      jrl::qp::decomposition::blockArrowLSolve(D, S, false, x, pool, work);
+      jrl::qp::decomposition::blockArrowLTransposeSolve(D, S, false, x, pool);
+    }
+  }
+}
+BENCHMARK(BM_BlockArrowLLT)
+    ->ArgsProduct({{10, 50, 100, 200}, {0, 1, 2, 4, 8}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// Factorization of block tri-diagonal and down block arrow matrices with 50 blocks of
+// size state.range(0). Sizes 6 and 12 use the fixed-size block kernels.
+static void BM_BlockSize(benchmark::State & state, bool arrow)
+{
+  const int nb = 50;
+  const int bs = static_cast<int>(state.range(0));
+  const int n = nb * bs;
+  MatrixXd A = MatrixXd::Zero(n, n);
+  for(int k = 0; k < nb; ++k)
+  {
+    A.block(bs * k, bs * k, bs, bs).setRandom();
+    if(arrow)
+      A.block(bs * k, n - bs, bs, bs).setRandom();
+    else if(k + 1 < nb)
+      A.block(bs * k + bs, bs * k, bs, bs).setRandom();
+  }
+  const MatrixXd H0 = arrow ? MatrixXd(A.transpose() * A) : MatrixXd(A * A.transpose());
+  MatrixXd H = H0;
+  std::vector<jrl::qp::MatrixRef> D, S;
+  for(int k = 0; k < nb; ++k)
+  {
+    D.push_back(H.block(bs * k, bs * k, bs, bs));
+    if(arrow && k + 1 < nb)
+      S.push_back(H.block(n - bs, bs * k, bs, bs));
+    else if(!arrow && k + 1 < nb)
+      S.push_back(H.block(bs * k + bs, bs * k, bs, bs));
+  }
+
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    H = H0;
+    state.ResumeTiming();
+    if(arrow)
+      jrl::qp::decomposition::blockArrowLLT(D, S, false);
+    else
+      jrl::qp::decomposition::triBlockDiagLLT(D, S);
+  }
+}
+BENCHMARK_CAPTURE(BM_BlockSize, TriBlockDiag, false)->DenseRange(4, 13)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_BlockSize, BlockArrow, true)->DenseRange(4, 13)->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_MAIN();
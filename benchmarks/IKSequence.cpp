@@ -0,0 +1,358 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+/** Replay of inverse kinematics QP sequences, with cold and warm start.
+ *
+ * The problems of tests/MultiIK.zip are single snapshots of a multi-robot IK. To
+ * reproduce the temporal coherence of a controller, each snapshot is turned into a
+ * sequence of nbSteps problems where the linear term and the constraint bounds drift
+ * smoothly, as they would when tracking a moving target. If the environment variable
+ * JRLQP_IK_SEQUENCE_DIR is set, the files it contains (in the format of
+ * arrowAllData.txt) are replayed in lexicographic order instead.
+ *
+ * One benchmark iteration replays a whole sequence. The reported time is the sum
+ * of the solve times, and the following counters are given:
+ *  - p50_us, p99_us, max_us: percentiles of the per-step solve time
+ *  - it, maxIt: average and maximum number of iterations per step
+ *  - churn: average number of constraints whose activation status changes from one
+ *    step to the next
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <optional>
+
+#include <benchmark/benchmark.h>
+
+#include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/BlockGISolver.h>
+#include <jrl-qp/experimental/GoldfarbIdnaniSolver.h>
+
+#include "IKmatReader.h"
+
+using namespace Eigen;
+using namespace jrl::qp;
+using namespace jrl::qp::structured;
+
+namespace
+{
+constexpr int nbSteps = 200;
+constexpr double Inf = std::numeric_limits<double>::infinity();
+constexpr double pi = 3.14159265358979323846;
+
+/** One QP of a sequence, with C given column-wise as expected by the solvers.*/
+struct IKProblem
+{
+  MatrixXd G;
+  VectorXd a;
+  MatrixXd C;
+  VectorXd l;
+  VectorXd u;
+  VectorXd xl;
+  VectorXd xu;
+};
+
+/** Block structure of the problems of a sequence, if known.*/
+struct IKStructure
+{
+  StructuredG::Type type;
+  int nDofs;
+  std::vector<int> nbCstr; // number of constraints per block
+};
+
+struct IKSequence
+{
+  std::vector<IKProblem> steps;
+  std::optional<IKStructure> structure;
+};
+
+/** Make a sequence of nbSteps problems out of \p pb, with a smooth drift of a and the bounds.*/
+std::vector<IKProblem> makeSequence(const IKProblem & pb)
+{
+  const double w = 2 * pi / 50; // pulsation of the drift
+  const double rho = 0.2; // relative amplitude of the drift
+  std::srand(42);
+  VectorXd phiA = pi * VectorXd::Random(pb.a.size());
+  VectorXd phiU = pi * VectorXd::Random(pb.u.size());
+  VectorXd phiX = pi * VectorXd::Random(pb.xu.size());
+  double sa = rho * pb.a.norm() / std::sqrt(static_cast<double>(pb.a.size()));
+
+  std::vector<IKProblem> seq(nbSteps, pb);
+  for(int k = 0; k < nbSteps; ++k)
+  {
+    auto & p = seq[k];
+    p.a += sa * (w * k + phiA.array()).sin().matrix();
+    for(int i = 0; i < p.u.size(); ++i)
+    {
+      if(std::isfinite(p.u[i])) p.u[i] += rho * std::max(std::abs(p.u[i]), 1e-3) * std::sin(w * k + phiU[i]);
+    }
+    for(int i = 0; i < p.xu.size(); ++i)
+    {
+      // We move the bound interval without changing its width
+      double d = rho * 0.5 * (p.xu[i] - p.xl[i]) * std::sin(w * k + phiX[i]);
+      if(std::isfinite(d))
+      {
+        p.xl[i] += d;
+        p.xu[i] += d;
+      }
+    }
+  }
+  return seq;
+}
+
+IKSequence triBlockSequence()
+{
+  const std::string dir = MULTIIK_DIR;
+  IKProblem pb;
+  pb.G = readMat(dir + "triBlockDiag_G.txt");
+  pb.C = readMat(dir + "triBlockDiag_C.txt").transpose();
+  pb.a = readMat(dir + "triBlockDiag_a.txt");
+  pb.u = readMat(dir + "triBlockDiag_u.txt");
+  pb.l = VectorXd::Constant(pb.u.size(), -Inf);
+
+  // Scan C to get the number of constraints per block
+  IKStructure s{StructuredG::Type::TriBlockDiagonal, 43, {}};
+  for(int i = 0; i < pb.C.cols(); ++i)
+  {
+    int j = 0;
+    while(pb.C(j, i) == 0) ++j;
+    if(j >= static_cast<int>(s.nbCstr.size()) * s.nDofs)
+      s.nbCstr.push_back(1);
+    else
+      ++s.nbCstr.back();
+  }
+  return {makeSequence(pb), s};
+}
+
+IKSequence arrowSequence()
+{
+  IKProblem pb;
+  MatrixXd E, C;
+  VectorXd f;
+  std::tie(pb.G, pb.a, E, f, C, pb.u, pb.xl, pb.xu) = readIKPbFile(std::string(MULTIIK_DIR) + "arrowAllData.txt");
+  pb.C = C.transpose();
+  pb.l = VectorXd::Constant(pb.u.size(), -Inf);
+  return {makeSequence(pb), IKStructure{StructuredG::Type::BlockArrowUp, 42, {5, 5, 5, 5, 5}}};
+}
+
+IKSequence recordedSequence(const std::string & dir)
+{
+  std::vector<std::string> files;
+  for(const auto & f : std::filesystem::directory_iterator(dir))
+  {
+    if(f.is_regular_file()) files.push_back(f.path().string());
+  }
+  std::sort(files.begin(), files.end());
+
+  IKSequence seq;
+  for(const auto & file : files)
+  {
+    IKProblem pb;
+    MatrixXd E, C;
+    VectorXd f, d;
+    std::tie(pb.G, pb.a, E, f, C, d, pb.xl, pb.xu) = readIKPbFile(file);
+    // Equality constraints are put first, as double-sided constraints with equal bounds
+    pb.C.resize(pb.G.rows(), E.rows() + C.rows());
+    pb.C << E.transpose(), C.transpose();
+    pb.l.resize(f.size() + d.size());
+    pb.l << f, VectorXd::Constant(d.size(), -Inf);
+    pb.u.resize(f.size() + d.size());
+    pb.u << f, d;
+    seq.steps.push_back(std::move(pb));
+  }
+  return seq;
+}
+
+const IKSequence & getSequence(const std::string & name)
+{
+  static std::map<std::string, IKSequence> sequences;
+  auto it = sequences.find(name);
+  if(it == sequences.end())
+  {
+    if(name == "tri")
+      it = sequences.emplace(name, triBlockSequence()).first;
+    else if(name == "arrow")
+      it = sequences.emplace(name, arrowSequence()).first;
+    else
+      it = sequences.emplace(name, recordedSequence(std::getenv("JRLQP_IK_SEQUENCE_DIR"))).first;
+  }
+  return it->second;
+}
+
+/** Per-step statistics accumulated over the replays.*/
+struct SequenceStats
+{
+  void reserve(size_t n)
+  {
+    latencies.reserve(n);
+  }
+
+  void add(double t, int it, int churn)
+  {
+    latencies.push_back(t);
+    totalIt += it;
+    maxIt = std::max(maxIt, it);
+    totalChurn += churn;
+  }
+
+  void setCounters(benchmark::State & st)
+  {
+    std::sort(latencies.begin(), latencies.end());
+    auto n = latencies.size();
+    if(n == 0) return;
+    st.counters["p50_us"] = 1e6 * latencies[n / 2];
+    st.counters["p99_us"] = 1e6 * latencies[static_cast<size_t>(std::ceil(0.99 * static_cast<double>(n))) - 1];
+    st.counters["max_us"] = 1e6 * latencies.back();
+    st.counters["it"] = static_cast<double>(totalIt) / static_cast<double>(n);
+    st.counters["maxIt"] = maxIt;
+    st.counters["churn"] = static_cast<double>(totalChurn) / static_cast<double>(n);
+  }
+
+  std::vector<double> latencies;
+  long totalIt = 0;
+  int maxIt = 0;
+  long totalChurn = 0;
+};
+
+/** Number of constraints whose activation status differ between \p prev and \p as.*/
+int churn(const std::vector<ActivationStatus> & prev, const std::vector<ActivationStatus> & as)
+{
+  int c = 0;
+  for(size_t i = 0; i < as.size(); ++i)
+  {
+    auto p = i < prev.size() ? prev[i] : ActivationStatus::INACTIVE;
+    c += (p != as[i]);
+  }
+  return c;
+}
+
+/** Replay the sequence, where \p prepare(k) is called before, and outside of the timing of,
+ * \p solveStep(k) that solves the k-th step.*/
+template<typename Solver, typename Prepare, typename Solve>
+void replay(benchmark::State & st, Solver & solver, int nbSteps, Prepare prepare, Solve solveStep)
+{
+  SequenceStats stats;
+  stats.reserve(static_cast<size_t>(nbSteps) * 16);
+  std::vector<ActivationStatus> prev;
+  for(auto _ : st)
+  {
+    double total = 0;
+    solver.resetActiveSet();
+    prev.clear();
+    for(int k = 0; k < nbSteps; ++k)
+    {
+      prepare(k);
+      auto t0 = std::chrono::high_resolution_clock::now();
+      auto ret = solveStep(k);
+      auto t1 = std::chrono::high_resolution_clock::now();
+      if(ret != TerminationStatus::SUCCESS)
+      {
+        st.SkipWithError("Failed to solve a step of the sequence");
+        return;
+      }
+      double t = std::chrono::duration<double>(t1 - t0).count();
+      total += t;
+      stats.add(t, solver.iterations(), churn(prev, solver.activeSet()));
+      prev = solver.activeSet();
+    }
+    st.SetIterationTime(total);
+  }
+  stats.setCounters(st);
+}
+
+template<typename Solver>
+void BM_Dense(benchmark::State & st, const std::string & name, bool warm)
+{
+  const auto & seq = getSequence(name);
+  const auto & pb0 = seq.steps.front();
+  int nbVar = static_cast<int>(pb0.G.rows());
+  Solver solver(nbVar, static_cast<int>(pb0.C.cols()), pb0.xl.size() > 0);
+  SolverOptions opt;
+  opt.warmStart(warm);
+  solver.options(opt);
+  MatrixXd G(nbVar, nbVar);
+  int n = static_cast<int>(seq.steps.size());
+  replay(
+      st, solver, n, [&](int k) { G = seq.steps[k].G; },
+      [&](int k)
+      {
+        const auto & p = seq.steps[k];
+        return solver.solve(G, p.a, p.C, p.l, p.u, p.xl, p.xu);
+      });
+}
+
+void BM_Block(benchmark::State & st, const std::string & name)
+{
+  const auto & seq = getSequence(name);
+  const auto & s = *seq.structure;
+  const auto & pb0 = seq.steps.front();
+  int nbVar = static_cast<int>(pb0.G.rows());
+  int nbBlocks = static_cast<int>(s.nbCstr.size());
+  MatrixXd G(nbVar, nbVar);
+
+  // Structured views on G and on the C of each step
+  std::vector<MatrixRef> D;
+  std::vector<MatrixRef> S;
+  for(int i = 0; i < nbBlocks; ++i)
+  {
+    D.push_back(G.block(i * s.nDofs, i * s.nDofs, s.nDofs, s.nDofs));
+    if(i > 0)
+    {
+      int c = s.type == StructuredG::Type::TriBlockDiagonal ? (i - 1) * s.nDofs : 0;
+      S.push_back(G.block(i * s.nDofs, c, s.nDofs, s.nDofs));
+    }
+  }
+  StructuredG GB(s.type, D, S);
+  std::vector<StructuredC> CB;
+  for(const auto & p : seq.steps)
+  {
+    std::vector<MatrixConstRef> Ci;
+    int k = 0;
+    for(int i = 0; i < nbBlocks; ++i)
+    {
+      Ci.push_back(p.C.block(i * s.nDofs, k, s.nDofs, s.nbCstr[i]));
+      k += s.nbCstr[i];
+    }
+    CB.emplace_back(Ci);
+  }
+
+  experimental::BlockGISolver solver(nbVar, static_cast<int>(pb0.C.cols()), pb0.xl.size() > 0);
+  int n = static_cast<int>(seq.steps.size());
+  replay(
+      st, solver, n, [&](int k) { G = seq.steps[k].G; },
+      [&](int k)
+      {
+        const auto & p = seq.steps[k];
+        return solver.solve(GB, p.a, CB[k], p.l, p.u, p.xl, p.xu);
+      });
+}
+
+void registerSequence(const std::string & name, bool structured)
+{
+  auto reg = [&name](const std::string & solver, auto fn, auto... args)
+  {
+    benchmark::RegisterBenchmark(("IK_" + name + "/" + solver).c_str(), fn, name, args...)
+        ->Unit(benchmark::kMicrosecond)
+        ->UseManualTime();
+  };
+  reg("GI/cold", BM_Dense<GoldfarbIdnaniSolver>, false);
+  reg("GIExp/cold", BM_Dense<experimental::GoldfarbIdnaniSolver>, false);
+  reg("GIExp/warm", BM_Dense<experimental::GoldfarbIdnaniSolver>, true);
+  if(structured) reg("BlockGI/cold", BM_Block);
+}
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  registerSequence("tri", true);
+  registerSequence("arrow", true);
+  if(std::getenv("JRLQP_IK_SEQUENCE_DIR")) registerSequence("recorded", false);
+
+  benchmark::Initialize(&argc, argv);
+  if(benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
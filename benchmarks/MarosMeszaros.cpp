@@ -0,0 +1,262 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+/** Benchmark of the solvers on the strictly convex problems of the Maros-Meszaros
+ * test set.
+ *
+ * Each problem is registered as a separate benchmark, named Solver/problemName.
+ * On top of the timings, the following counters are recorded:
+ *  - it: number of iterations (-1 if the solver does not report it)
+ *  - activeSetSize: number of active constraints and bounds at the solution
+ *  - status: termination status returned by the solver (0 means success)
+ *  - solved: 1 if the optimal objective value matches the reference one, 0 otherwise
+ *
+ * The results are meant to be written in json (--benchmark_out_format=json) and
+ * read with plot.read_bench.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#ifdef JRLQP_USE_LSSOL
+#  include <eigen-lssol/LSSOL_QP.h>
+#endif
+#ifdef JRLQP_USE_QUADPROG
+#  include <eigen-quadprog/QuadProg.h>
+#endif
+#ifdef JRLQP_USE_QLD
+#  include <eigen-qld/QLDDirect.h>
+#endif
+
+#include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/test/problems.h>
+
+#include "QPSProblems.h"
+#include "QPSReader.h"
+#include "eiquadprog.hpp"
+#include "problemAdaptors.h"
+
+using namespace Eigen;
+using namespace jrl::qp;
+using namespace jrl::qp::test;
+
+namespace
+{
+// Size limits, in line with the ones of the QPS tests. The solvers benchmarked are
+// dense, and bigger problems would take too much time or memory.
+constexpr int maxNbVar = 500;
+constexpr int maxNbCstr = 1000;
+
+// Problems the reader can't handle.
+const std::vector<std::string> excludedPb = {
+    "qforplan" // requires the QPS reader to handle names with spaces
+};
+
+/** A problem of the test set, with the representations needed by the different solvers.*/
+struct MMProblem
+{
+  MMProblem(const QPSPbData & data) : data(data)
+  {
+    QPSReader reader(true);
+    auto [p, prop] = reader.read(QPS_BENCH_DIR + data.name + ".QPS");
+    pb = std::move(p);
+    properties = prop;
+    C = pb.C.transpose();
+    QPProblem<true> spb(pb);
+    lssolPb = spb;
+    quadprogPb = spb;
+    eiquadprogPb = spb;
+    qldPb = spb;
+  }
+
+  /** Objective value at x*/
+  double objective(const VectorConstRef & x) const
+  {
+    return 0.5 * x.dot(pb.G * x) + pb.a.dot(x) + pb.objCst;
+  }
+
+  /** Check if x is optimal, based on the reference objective value.*/
+  bool optimal(const VectorConstRef & x) const
+  {
+    if(!x.allFinite()) return false;
+    return std::abs(objective(x) - data.fstar) <= 1e-6 * std::max(1., std::abs(data.fstar));
+  }
+
+  /** Number of constraints and bounds active at x (up to tolerance \p eps).*/
+  int activeSetSize(const VectorConstRef & x, double eps = 1e-8) const
+  {
+    auto act = [eps](double v, double b)
+    { return std::isfinite(b) && std::abs(v - b) <= eps * std::max(1., std::abs(b)); };
+    int n = 0;
+    VectorXd cx = pb.C * x;
+    for(int i = 0; i < cx.size(); ++i)
+    {
+      if(act(cx[i], pb.l[i]) || act(cx[i], pb.u[i])) ++n;
+    }
+    for(int i = 0; i < pb.xl.size(); ++i)
+    {
+      if(act(x[i], pb.xl[i]) || act(x[i], pb.xu[i])) ++n;
+    }
+    return n;
+  }
+
+  QPSPbData data;
+  QPProblem<> pb;
+  ProblemProperties properties;
+  MatrixXd C; // Transpose of pb.C, as expected by the jrl-qp solvers.
+  LssolPb lssolPb;
+  EigenQuadprogPb quadprogPb;
+  EiQuadprogPb eiquadprogPb;
+  QLDPb qldPb;
+};
+
+/** Load (once) and return the problem described by \p data.*/
+const MMProblem & getProblem(const QPSPbData & data)
+{
+  static std::map<std::string, std::unique_ptr<MMProblem>> problems;
+  auto & p = problems[data.name];
+  if(!p) p = std::make_unique<MMProblem>(data);
+  return *p;
+}
+
+void setCounters(benchmark::State & st, const MMProblem & p, int it, int activeSetSize, int status, bool solved)
+{
+  st.counters["nbVar"] = p.properties.nbVar;
+  st.counters["nbCstr"] = p.properties.nbCstr;
+  st.counters["it"] = it;
+  st.counters["activeSetSize"] = activeSetSize;
+  st.counters["status"] = status;
+  st.counters["solved"] = solved;
+}
+
+template<typename Solver>
+void BM_JrlQP(benchmark::State & st, const QPSPbData & data)
+{
+  const auto & p = getProblem(data);
+  const auto & pb = p.pb;
+  Solver solver(p.properties.nbVar, p.properties.nbCstr, p.properties.useBounds);
+  SolverOptions opt;
+  opt.maxIter_ = std::max(50, 10 * std::max(data.nbCstr, data.nbVar));
+  solver.options(opt);
+  MatrixXd G = pb.G;
+  TerminationStatus status = TerminationStatus::UNKNOWN;
+  for(auto _ : st)
+  {
+    st.PauseTiming();
+    G = pb.G;
+    st.ResumeTiming();
+    status = solver.solve(G, pb.a, p.C, pb.l, pb.u, pb.xl, pb.xu);
+  }
+  const auto & as = solver.activeSet();
+  int nAct = static_cast<int>(
+      std::count_if(as.begin(), as.end(), [](auto s) { return s != ActivationStatus::INACTIVE; }));
+  setCounters(st, p, solver.iterations(), nAct, static_cast<int>(status),
+              status == TerminationStatus::SUCCESS && p.optimal(solver.solution()));
+}
+
+void BM_EiQuadprog(benchmark::State & st, const QPSPbData & data)
+{
+  const auto & p = getProblem(data);
+  auto qp = p.eiquadprogPb;
+  VectorXd x(p.properties.nbVar);
+  double f = 0;
+  for(auto _ : st)
+  {
+    st.PauseTiming();
+    qp.G = p.eiquadprogPb.G;
+    st.ResumeTiming();
+    f = Eigen::solve_quadprog(qp.G, qp.g0, qp.CE, qp.ce0, qp.CI, qp.ci0, x);
+  }
+  setCounters(st, p, -1, p.activeSetSize(x), f < std::numeric_limits<double>::infinity() ? 0 : 1, p.optimal(x));
+}
+
+#ifdef JRLQP_USE_QUADPROG
+void BM_QuadProg(benchmark::State & st, const QPSPbData & data)
+{
+  const auto & p = getProblem(data);
+  const auto & qp = p.quadprogPb;
+  Eigen::QuadProgDense solver(static_cast<int>(qp.Q.rows()), static_cast<int>(qp.Aeq.rows()),
+                              static_cast<int>(qp.Aineq.rows()));
+  bool ok = false;
+  for(auto _ : st)
+  {
+    ok = solver.solve(qp.Q, qp.c, qp.Aeq, qp.beq, qp.Aineq, qp.bineq);
+  }
+  setCounters(st, p, -1, p.activeSetSize(solver.result()), ok ? 0 : 1, p.optimal(solver.result()));
+}
+#endif
+
+#ifdef JRLQP_USE_LSSOL
+void BM_Lssol(benchmark::State & st, const QPSPbData & data)
+{
+  const auto & p = getProblem(data);
+  const auto & qp = p.lssolPb;
+  Eigen::LSSOL_QP solver(static_cast<int>(qp.Q.rows()), static_cast<int>(qp.C.rows()), Eigen::lssol::QP2);
+  solver.optimalityMaxIter(std::max(50, 10 * std::max(data.nbCstr, data.nbVar)));
+  solver.feasibilityMaxIter(std::max(50, 10 * std::max(data.nbCstr, data.nbVar)));
+  bool ok = false;
+  for(auto _ : st)
+  {
+    ok = solver.solve(qp.Q, qp.p, qp.C, qp.l, qp.u);
+  }
+  setCounters(st, p, -1, p.activeSetSize(solver.result()), ok ? 0 : 1, p.optimal(solver.result()));
+}
+#endif
+
+#ifdef JRLQP_USE_QLD
+void BM_QLD(benchmark::State & st, const QPSPbData & data)
+{
+  const auto & p = getProblem(data);
+  const auto & qp = p.qldPb;
+  int nEq = static_cast<int>(p.quadprogPb.Aeq.rows());
+  Eigen::QLDDirect solver(static_cast<int>(qp.Q.rows()), nEq, static_cast<int>(qp.A.rows()) - nEq);
+  bool ok = false;
+  for(auto _ : st)
+  {
+    ok = solver.solve(qp.Q, qp.c, qp.A, qp.b, qp.xl, qp.xu, nEq);
+  }
+  setCounters(st, p, -1, p.activeSetSize(solver.result()), ok ? 0 : 1, p.optimal(solver.result()));
+}
+#endif
+
+/** Register all the benchmarks for the problem \p data*/
+void registerProblem(const QPSPbData & data)
+{
+  auto reg = [&data](const std::string & solver, auto fn) {
+    benchmark::RegisterBenchmark((solver + "/" + data.name).c_str(), fn, data)->Unit(benchmark::kMicrosecond);
+  };
+  reg("GI", BM_JrlQP<GoldfarbIdnaniSolver>);
+  reg("GIExp", BM_JrlQP<experimental::GoldfarbIdnaniSolver>);
+  reg("EIQP", BM_EiQuadprog);
+#ifdef JRLQP_USE_QUADPROG
+  reg("QuadProg", BM_QuadProg);
+#endif
+#ifdef JRLQP_USE_LSSOL
+  reg("Lssol", BM_Lssol);
+#endif
+#ifdef JRLQP_USE_QLD
+  reg("QLD", BM_QLD);
+#endif
+}
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  for(const auto & p : marosMeszarosPbList)
+  {
+    // We only keep strictly convex problems
+    if(p.cond == Inf) continue;
+    if(p.nbVar > maxNbVar || p.nbCstr > maxNbCstr) continue;
+    if(std::find(excludedPb.begin(), excludedPb.end(), p.name) != excludedPb.end()) continue;
+    registerProblem(p);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  if(benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,158 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <cstdlib>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/BlockGISolver.h>
+#include <jrl-qp/experimental/RiccatiSolver.h>
+#include <jrl-qp/test/optimalControlProblems.h>
+
+using namespace Eigen;
+using namespace jrl::qp;
+using namespace jrl::qp::test;
+
+// Linear-quadratic optimal control problems with states of size 6, controls of size 3
+// and 4 general constraints per stage, over a horizon of state.range(0) stages.
+// The same problems are solved by the Riccati-based solver, by the block solver (with
+// the dynamics as equality constraints) and by the dense solver. The two latter are
+// limited to 100 stages, as they take several seconds per solve for 200 stages.
+namespace
+{
+const int nx = 6;
+const int nu = 3;
+const int m = 4;
+
+template<typename T>
+std::vector<MatrixConstRef> toRefs(const std::vector<T> & M)
+{
+  return {M.begin(), M.end()};
+}
+
+// Enough iterations for the longest horizons
+const SolverOptions options = SolverOptions().maxIter(5000);
+
+// Same problem for a given horizon in all the benchmarks
+OptimalControlProblem problem(int N)
+{
+  std::srand(static_cast<unsigned>(N));
+  return randomOptimalControlProblem(nx, nu, N, m, true);
+}
+} // namespace
+
+static void BM_OptimalControl_Riccati(benchmark::State & state)
+{
+  const int N = static_cast<int>(state.range(0));
+  auto pb = problem(N);
+  auto H = toRefs(pb.H);
+  auto F = toRefs(pb.F);
+  auto C = toRefs(pb.C);
+
+  experimental::RiccatiSolver solver(nx, nu, N, (N + 1) * m, true);
+  solver.options(options);
+  for(auto _ : state)
+  {
+    solver.solve(H, pb.a, F, pb.c, pb.x0, C, pb.bl, pb.bu, pb.xl, pb.xu);
+  }
+  state.counters["iter"] = solver.iterations();
+}
+BENCHMARK(BM_OptimalControl_Riccati)->Arg(10)->Arg(25)->Arg(50)->Arg(100)->Arg(200)->Unit(benchmark::kMicrosecond);
+
+static void BM_OptimalControl_BlockGI(benchmark::State & state)
+{
+  const int N = static_cast<int>(state.range(0));
+  const int ns = nx + nu;
+  const int nbVar = N * ns + nx;
+  auto pb = problem(N);
+
+  // Block tri-diagonal Hessian with zero sub-diagonal blocks
+  MatrixXd G0 = MatrixXd::Zero(nbVar, nbVar);
+  for(int k = 0; k <= N; ++k) G0.block(k * ns, k * ns, pb.H[k].rows(), pb.H[k].cols()) = pb.H[k];
+  MatrixXd G = G0;
+  std::vector<MatrixRef> D, S;
+  for(int k = 0; k <= N; ++k)
+  {
+    int nk = k < N ? ns : nx;
+    D.push_back(G.block(k * ns, k * ns, nk, nk));
+    if(k > 0) S.push_back(G.block(k * ns, (k - 1) * ns, nk, ns));
+  }
+  structured::StructuredG SG(structured::StructuredG::Type::TriBlockDiagonal, D, S);
+
+  // Constraint group k: (x_0 = x0 for k = 0), x_{k+1} - F_k y_k = c_k, C_k^T y_k
+  std::vector<MatrixXd> Cd, Cs;
+  std::vector<VectorXd> bl, bu;
+  for(int k = 0; k <= N; ++k)
+  {
+    int nk = k < N ? ns : nx;
+    int e = k == 0 ? nx : 0;
+    int d = k < N ? nx : 0;
+    MatrixXd Ck = MatrixXd::Zero(nk, e + d + m);
+    VectorXd lk(e + d + m), uk(e + d + m);
+    if(k == 0)
+    {
+      Ck.topLeftCorner(e, e).setIdentity();
+      lk.head(e) = pb.x0;
+      uk.head(e) = pb.x0;
+    }
+    if(k < N)
+    {
+      Ck.middleCols(e, d) = -pb.F[k].transpose();
+      lk.segment(e, d) = pb.c.segment(k * nx, nx);
+      uk.segment(e, d) = pb.c.segment(k * nx, nx);
+      MatrixXd Sk = MatrixXd::Zero(k + 1 < N ? ns : nx, e + d + m);
+      Sk.middleCols(e, d).topRows(nx).setIdentity();
+      Cs.push_back(Sk);
+    }
+    Ck.rightCols(m) = pb.C[k];
+    lk.tail(m) = pb.bl.segment(k * m, m);
+    uk.tail(m) = pb.bu.segment(k * m, m);
+    Cd.push_back(Ck);
+    bl.push_back(lk);
+    bu.push_back(uk);
+  }
+  structured::StructuredC SC(structured::StructuredC::Type::BlockBidiagonal, toRefs(Cd), toRefs(Cs));
+  int nbCstr = 0;
+  for(const auto & l : bl) nbCstr += static_cast<int>(l.size());
+  VectorXd l(nbCstr), u(nbCstr);
+  for(int k = 0, s = 0; k <= N; s += static_cast<int>(bl[k].size()), ++k)
+  {
+    l.segment(s, bl[k].size()) = bl[k];
+    u.segment(s, bu[k].size()) = bu[k];
+  }
+
+  experimental::BlockGISolver solver(nbVar, nbCstr, true);
+  solver.options(options);
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    G = G0;
+    state.ResumeTiming();
+    solver.solve(SG, pb.a, SC, l, u, pb.xl, pb.xu);
+  }
+  state.counters["iter"] = solver.iterations();
+}
+BENCHMARK(BM_OptimalControl_BlockGI)->Arg(10)->Arg(25)->Arg(50)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+static void BM_OptimalControl_Dense(benchmark::State & state)
+{
+  const int N = static_cast<int>(state.range(0));
+  auto pb = problem(N);
+  auto qpp = pb.toDense();
+
+  MatrixXd G = qpp.G;
+  GoldfarbIdnaniSolver solver(static_cast<int>(qpp.G.rows()), static_cast<int>(qpp.C.cols()), true);
+  solver.options(options);
+  for(auto _ : state)
+  {
+    state.PauseTiming();
+    G = qpp.G;
+    state.ResumeTiming();
+    solver.solve(G, qpp.a, qpp.C, qpp.l, qpp.u, qpp.xl, qpp.xu);
+  }
+  state.counters["iter"] = solver.iterations();
+}
+BENCHMARK(BM_OptimalControl_Dense)->Arg(10)->Arg(25)->Arg(50)->Arg(100)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
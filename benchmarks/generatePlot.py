@@ -1,3 +1,4 @@
+import os
 from plot import *
 
 dataBasic = read_bench('out/BasicEigen.csv')
@@ -21,3 +22,8 @@ plot_relative_curves(dataBasic, '*Mult_MatrixXd*', baseline = 'BM_Mult_MatrixXd'
 plot_curves(dataDecomp, '*Decomposition*', title = 'Decomposition', logy=True, filename = 'out/decomp')
 plot_relative_curves(dataDecomp, '*Decomposition*', baseline = 'BM_Copy_MatrixXd', title = 'Decomposition relative to simple copy', filename = 'out/decomp_vsCopy')
 plot_relative_curves(dataDecomp, '*Decomposition*', baseline = 'BM_Mult_MatrixXd', title = 'Decomposition relative to simple mat-mat mult', filename = 'out/decomp_vsMult')
+
+#Maros-Meszaros test set (only if the benchmark was built and run)
+if os.path.exists('out/MarosMeszaros.json'):
+	dataMM = read_bench('out/MarosMeszaros.json')
+	plot_performance_profile(dataMM, '*', title = 'Maros-Meszaros performance profile', filename = 'out/mm_profile')
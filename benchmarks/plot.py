@@ -1,7 +1,9 @@
 import csv
+import json
+import math
 import matplotlib.pyplot as plt
 
-NUMERICAL_FIELDS = ['real_time', 'cpu_time', 'iterations']
+NUMERICAL_FIELDS = ['real_time', 'cpu_time', 'iterations', 'it', 'activeSetSize', 'status', 'solved', 'nbVar', 'nbCstr']
 
 def read_csv(filename):
 	with open(filename, mode='r') as csv_file:
@@ -23,10 +25,24 @@ def read_csv(filename):
 	return bench
 
 
+def read_json(filename):
+	"""Read a benchmark file written with --benchmark_out_format=json, and return a
+	dictionnary with the same layout as read_csv"""
+	with open(filename, mode='r') as json_file:
+		data = json.load(json_file)
+
+	bench = {}
+	for b in data['benchmarks']:
+		bench[b['name']] = {key:val for key,val in b.items() if key!='name'}
+
+	return bench
+
+
 def parse_name(name):
-	"""Parse the name of a benchmark"""
+	"""Parse the name of a benchmark. Parameters that are not integers (e.g. problem
+	names) are kept as strings."""
 	s = name.split('/')
-	return [s[0], [int(i) for i in s[1:]]]
+	return [s[0], [int(i) if i.lstrip('-').isdigit() else i for i in s[1:]]]
 
 
 def rearrange_by_name(dict):
@@ -61,8 +77,11 @@ def rearrange_by_name(dict):
 
 
 def read_bench(filename):
-	"""Read a CSV benchmark file."""
-	bench = read_csv(filename)
+	"""Read a CSV or json benchmark file."""
+	if filename.endswith('.json'):
+		bench = read_json(filename)
+	else:
+		bench = read_csv(filename)
 	return rearrange_by_name(bench)
 
 
@@ -144,3 +163,44 @@ def plot_relative_curves(data, names, baseline, category='cpu_time', title=None,
 		plt.savefig(filename+'.'+filetype, format=filetype)
 	else:
 		plt.show()
+
+def plot_performance_profile(data, names, category='cpu_time', title=None, maxRatio = 100, filename = None, filetype='png'):
+	"""
+	Plot the performance profiles (Dolan and More, 2002) of the benchmarks in names.
+	The benchmarks are expected to be parametrized by the same problems (e.g. the
+	ones of the Maros-Meszaros test set). If available, the field 'solved' is used
+	to discard the problems that were not solved correctly.
+	"""
+	l = sorted(match_all_names(names, data.keys()))
+
+	# time for each problem and each benchmark, inf if the problem is not solved
+	perf = {}
+	for n in l:
+		for i,p in enumerate(data[n]['param']):
+			t = data[n][category][i]
+			if 'solved' in data[n] and not data[n]['solved'][i]:
+				t = math.inf
+			perf.setdefault(str(p), {})[n] = t
+
+	plt.figure()
+	for n in l:
+		ratios = []
+		for p,v in perf.items():
+			best = min(v.values())
+			if n in v and best < math.inf:
+				ratios.append(v[n]/best)
+			else:
+				ratios.append(math.inf)
+		ratios.sort()
+		tau = [r for r in ratios if r <= maxRatio]
+		rho = [(i+1)/len(ratios) for i in range(len(tau))]
+		plt.step(tau, rho, label=n, where='post')
+	plt.xscale('log')
+	plt.xlabel('ratio to best ' + category)
+	plt.ylabel('fraction of problems')
+	plt.title(title if title else 'Performance profile')
+	plt.legend()
+	if filename:
+		plt.savefig(filename+'.'+filetype, format=filetype)
+	else:
+		plt.show()
@@ -0,0 +1,285 @@
+"""
+Performance regression harness.
+
+Runs a fixed subset of the benchmarks, stores the raw timings of each repetition
+in a json baseline, and compares a later run against it.
+
+	python regression.py baseline --build-dir <build>/benchmarks -o baseline.json
+	python regression.py run --build-dir <build>/benchmarks -o current.json
+	python regression.py compare baseline.json current.json
+	python regression.py check --build-dir <build>/benchmarks baseline.json
+
+A benchmark (i.e. a given function for a given problem size) is reported as a
+regression when its median time increased by more than the threshold *and* a
+one-sided Mann-Whitney U test on the repetitions rejects the hypothesis that the
+new timings are not larger than the baseline ones. Requiring both avoids flagging
+statistically significant but negligible changes, as well as large but noisy ones.
+
+compare and check return 1 if at least one regression is found, so that they can
+be used in scripts. Only the standard library is used, so that the harness runs on
+any Linux box where the benchmarks can be built.
+"""
+
+import argparse
+import datetime
+import json
+import math
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+
+# Fixed subset of benchmarks used to detect regressions: (executable, filter).
+# It is meant to cover the main code paths (decompositions, dense and structured
+# solvers, warm start) while keeping the run time of the whole suite reasonable.
+SUITE = [
+	('Decomposition_Bench', r'BM_(LLT|QR)_Decomposition/(10|50|100|200)$'),
+	('Solvers_Bench', r'test[1-3]/GI/(10|50|100)$'),
+	('SolversWarmStart_Bench', r'test1/GI(_EX)?/(10|50|100)$'),
+	('BoxAndSingleConstraintSolver_Bench', r'test[12]/(BSC|GI)_(IN)?ACTIVE/(10|50|100)$'),
+	('IKSequence_Bench', r'IK_(tri|arrow)/(GIExp|BlockGI)/'),
+]
+
+DEFAULT_REPETITIONS = 10
+DEFAULT_THRESHOLD = 0.05
+DEFAULT_ALPHA = 0.01
+
+
+def split_name(name):
+	"""Split a benchmark name into the benchmark itself and the problem size, i.e. the
+	integer parameters. Google benchmark suffixes such as manual_time are dropped.
+	For example Solvers:test1/GI/50 gives ('Solvers:test1/GI', '50')."""
+	s = [p for p in name.split('/') if p not in ('manual_time', 'real_time')]
+	base = [p for p in s if not p.lstrip('-').isdigit()]
+	size = [p for p in s if p.lstrip('-').isdigit()]
+	return '/'.join(base), '/'.join(size)
+
+
+def run_suite(build_dir, repetitions, min_time=None, only=None):
+	"""Run the benchmarks of SUITE found in build_dir and return the raw samples."""
+	results = {}
+	for exe, flt in SUITE:
+		path = os.path.join(build_dir, exe)
+		if not os.path.isfile(path):
+			print('Skipping {}: not found in {}'.format(exe, build_dir), file=sys.stderr)
+			continue
+		if only is not None:
+			# The regex engine of google benchmark has no lookahead, so we can't combine
+			# both filters in a single regex. We get the list of benchmarks instead.
+			names = subprocess.run([path, '--benchmark_list_tests=true', '--benchmark_filter=' + flt],
+				cwd=build_dir, check=True, stdout=subprocess.PIPE, text=True).stdout.split()
+			names = [n for n in names if re.search(only, n)]
+			if not names:
+				continue
+			flt = '^({})$'.format('|'.join(re.escape(n) for n in names))
+		with tempfile.TemporaryDirectory() as tmp:
+			out = os.path.join(tmp, 'out.json')
+			cmd = [path,
+				'--benchmark_filter=' + flt,
+				'--benchmark_repetitions={}'.format(repetitions),
+				'--benchmark_report_aggregates_only=false',
+				'--benchmark_out=' + out,
+				'--benchmark_out_format=json']
+			if min_time is not None:
+				cmd.append('--benchmark_min_time={}'.format(min_time))
+			print('Running ' + ' '.join(cmd), file=sys.stderr)
+			# Benchmarks reading data files use paths relative to the build dir.
+			subprocess.run(cmd, cwd=build_dir, check=True, stdout=subprocess.DEVNULL)
+			with open(out, mode='r') as f:
+				data = json.load(f)
+		for b in data['benchmarks']:
+			if b.get('run_type', 'iteration') != 'iteration' or 'error_occurred' in b:
+				continue
+			# With manual time, real_time is the measured time, cpu_time is meaningless.
+			metric = 'real_time' if 'manual_time' in b['name'] else 'cpu_time'
+			# Different executables can have benchmarks with the same name.
+			name = exe[:-len('_Bench')] + ':' + b.get('run_name', b['name'])
+			r = results.setdefault(name,
+				{'executable': exe, 'metric': metric, 'time_unit': b['time_unit'], 'samples': []})
+			r['samples'].append(b[metric])
+
+	return {'context': {'host': platform.node(), 'machine': platform.machine(),
+				'repetitions': repetitions, 'date': datetime.datetime.now().isoformat()},
+			'benchmarks': results}
+
+
+def mann_whitney_greater(x, y):
+	"""One-sided Mann-Whitney U test with alternative hypothesis 'y tends to be
+	greater than x'. Returns the p-value, computed with the normal approximation
+	(with tie and continuity corrections). This is accurate enough for the sample
+	sizes we use (>= 5 repetitions each)."""
+	n1 = len(x)
+	n2 = len(y)
+	if n1 == 0 or n2 == 0:
+		return 1.
+	# Ranks of the pooled samples, averaged over ties
+	pooled = sorted([(v, 0) for v in x] + [(v, 1) for v in y])
+	ranks = [0.] * len(pooled)
+	ties = 0.
+	i = 0
+	while i < len(pooled):
+		j = i
+		while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+			j += 1
+		for k in range(i, j + 1):
+			ranks[k] = (i + j) / 2. + 1
+		t = j - i + 1
+		ties += t**3 - t
+		i = j + 1
+	r2 = sum(r for r, (_, g) in zip(ranks, pooled) if g == 1)
+	u2 = r2 - n2 * (n2 + 1) / 2.
+	n = n1 + n2
+	mu = n1 * n2 / 2.
+	sigma2 = n1 * n2 / 12. * ((n + 1) - ties / (n * (n - 1)))
+	if sigma2 <= 0:
+		return 1.
+	z = (u2 - mu - 0.5) / math.sqrt(sigma2)
+	return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def median(v):
+	s = sorted(v)
+	n = len(s)
+	return s[n // 2] if n % 2 else 0.5 * (s[n // 2 - 1] + s[n // 2])
+
+
+def threshold_for(name, default, overrides):
+	"""Threshold for the benchmark name. overrides is a list of (regex, value), the
+	last match wins."""
+	t = default
+	for pattern, value in overrides:
+		if re.search(pattern, name):
+			t = value
+	return t
+
+
+def compare(baseline, current, threshold, alpha, overrides):
+	"""Compare two results as returned by run_suite. Returns a list of rows
+	(benchmark, size, base median, new median, relative change, p-value, verdict)."""
+	rows = []
+	bb = baseline['benchmarks']
+	cb = current['benchmarks']
+	for name in sorted(set(bb) | set(cb)):
+		bench, size = split_name(name)
+		if name not in bb or name not in cb:
+			rows.append((bench, size, None, None, None, None, 'missing in ' + ('baseline' if name not in bb else 'current')))
+			continue
+		x = bb[name]['samples']
+		y = cb[name]['samples']
+		m0 = median(x)
+		m1 = median(y)
+		change = (m1 - m0) / m0 if m0 > 0 else 0.
+		t = threshold_for(name, threshold, overrides)
+		if change > t and mann_whitney_greater(x, y) < alpha:
+			verdict = 'REGRESSION'
+			p = mann_whitney_greater(x, y)
+		elif change < -t and mann_whitney_greater(y, x) < alpha:
+			verdict = 'improvement'
+			p = mann_whitney_greater(y, x)
+		else:
+			verdict = ''
+			p = mann_whitney_greater(x, y) if change >= 0 else mann_whitney_greater(y, x)
+		rows.append((bench, size, m0, m1, change, p, verdict))
+	return rows
+
+
+def report(rows):
+	"""Print the comparison, grouped per benchmark, one line per problem size, followed
+	by a per-benchmark summary of the sizes with regressions."""
+	w = max([len(r[0]) for r in rows] + [9])
+	print('{:<{w}} {:>8} {:>12} {:>12} {:>8} {:>8}  {}'.format('benchmark', 'size', 'base', 'new', 'change', 'p', '', w=w))
+	for bench, size, m0, m1, change, p, verdict in rows:
+		if m0 is None:
+			print('{:<{w}} {:>8} {:>12} {:>12} {:>8} {:>8}  {}'.format(bench, size, '-', '-', '-', '-', verdict, w=w))
+			continue
+		print('{:<{w}} {:>8} {:>12.3f} {:>12.3f} {:>+7.1f}% {:>8.4f}  {}'.format(
+			bench, size, m0, m1, 100 * change, p, verdict, w=w))
+
+	regressed = {}
+	for bench, size, _, _, _, _, verdict in rows:
+		if verdict == 'REGRESSION':
+			regressed.setdefault(bench, []).append(size if size else '-')
+	print('')
+	if regressed:
+		print('Regressions:')
+		for bench, sizes in regressed.items():
+			print('  {}: size {}'.format(bench, ', '.join(sizes)))
+	else:
+		print('No regression detected.')
+	return len(regressed) > 0
+
+
+def load(filename):
+	with open(filename, mode='r') as f:
+		return json.load(f)
+
+
+def save(results, filename):
+	with open(filename, mode='w') as f:
+		json.dump(results, f, indent=1)
+
+
+def parse_overrides(values):
+	overrides = []
+	for v in values or []:
+		pattern, _, t = v.rpartition('=')
+		overrides.append((pattern, float(t)))
+	return overrides
+
+
+def main(argv):
+	parser = argparse.ArgumentParser(description='Benchmark regression harness')
+	sub = parser.add_subparsers(dest='command', required=True)
+
+	def add_run_args(p):
+		p.add_argument('--build-dir', default='.', help='directory containing the benchmark executables')
+		p.add_argument('-r', '--repetitions', type=int, default=DEFAULT_REPETITIONS)
+		p.add_argument('--min-time', type=float, help='forwarded as --benchmark_min_time')
+		p.add_argument('--filter', help='only run the benchmarks of the suite matching this regex')
+
+	def add_compare_args(p):
+		p.add_argument('-t', '--threshold', type=float, default=DEFAULT_THRESHOLD,
+			help='relative increase of the median above which a change is reported (default: %(default)s)')
+		p.add_argument('--threshold-for', action='append', metavar='REGEX=VALUE',
+			help='threshold for the benchmarks whose name matches REGEX (can be repeated, last match wins)')
+		p.add_argument('-a', '--alpha', type=float, default=DEFAULT_ALPHA,
+			help='significance level of the Mann-Whitney U test (default: %(default)s)')
+
+	for cmd in ['baseline', 'run']:
+		p = sub.add_parser(cmd, help='run the suite and store the results')
+		add_run_args(p)
+		p.add_argument('-o', '--output', default='baseline.json' if cmd == 'baseline' else 'current.json')
+
+	p = sub.add_parser('compare', help='compare two stored results')
+	p.add_argument('baseline')
+	p.add_argument('current')
+	add_compare_args(p)
+
+	p = sub.add_parser('check', help='run the suite and compare against a baseline')
+	p.add_argument('baseline')
+	p.add_argument('-o', '--output', help='also store the new results in this file')
+	add_run_args(p)
+	add_compare_args(p)
+
+	args = parser.parse_args(argv)
+
+	if args.command in ['baseline', 'run']:
+		save(run_suite(args.build_dir, args.repetitions, args.min_time, args.filter), args.output)
+		return 0
+
+	baseline = load(args.baseline)
+	if args.command == 'compare':
+		current = load(args.current)
+	else:
+		current = run_suite(args.build_dir, args.repetitions, args.min_time, args.filter)
+		if args.output:
+			save(current, args.output)
+
+	rows = compare(baseline, current, args.threshold, args.alpha, parse_overrides(args.threshold_for))
+	return 1 if report(rows) else 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,49 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <jrl-qp/api.h>
+#include <jrl-qp/defs.h>
+
+namespace jrl::qp::decomposition
+{
+/** Cholesky decomposition of a symmetric banded matrix given in lower band storage.
+ *
+ * For a n x n matrix \f$ A \f$ with bandwidth k (\f$ A_{ij} = 0 \f$ for
+ * \f$ |i-j| > k \f$), \p band is a (k+1) x n matrix such that
+ * \f$ band(i,j) = A_{i+j,j} \f$: the column j of \p band contains the diagonal
+ * element and the k elements below it in column j of \f$ A \f$. The last k columns of
+ * \p band thus have unused entries.
+ *
+ * Upon return, \p band contains the factor \f$ L \f$ such that \f$ A = L L^T \f$, in
+ * the same storage (L has the same bandwidth as A).
+ * The decomposition requires \f$ O(n k^2) \f$ operations.
+ *
+ * \param start If > 0, resume a previous decomposition: the columns j < \p start of
+ * \p band are assumed to already contain \f$ L \f$, while the other columns contain
+ * the original matrix. This allows to update the decomposition when only the columns
+ * j >= \p start of \f$ A \f$ (in band storage) are changed.
+ */
+JRLQP_DLLAPI bool bandLLT(MatrixRef band, int start = 0);
+
+/** Solve in place the system L X = M where L is the factor obtained from bandLLT.
+ *
+ * \param band factor L in lower band storage.
+ * \param M right hand side of the equation (matrix or vector). Contains the
+ * solution upon return.
+ * \param start First row of M that is not 0.
+ */
+JRLQP_DLLAPI void bandLSolve(const MatrixConstRef & band, MatrixRef M, int start = 0);
+
+/** Solve in place the system L^T X = M where L is the factor obtained from bandLLT.
+ *
+ * \param band factor L in lower band storage.
+ * \param M right hand side of the equation (matrix or vector). Contains the
+ * solution upon return.
+ * \param end First row of the terminal 0 block in M. If end < 0, M has no
+ * terminal 0 block.
+ */
+JRLQP_DLLAPI void bandLTransposeSolve(const MatrixConstRef & band, MatrixRef M, int end = -1);
+} // namespace jrl::qp::decomposition
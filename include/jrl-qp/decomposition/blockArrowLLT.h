@@ -8,6 +8,12 @@
 
 #include <jrl-qp/api.h>
 #include <jrl-qp/defs.h>
+#include <jrl-qp/internal/Workspace.h>
+
+namespace jrl::qp::internal
+{
+class ThreadPool;
+} // namespace jrl::qp::internal
 
 namespace jrl::qp::decomposition
 {
@@ -71,6 +77,25 @@ JRLQP_DLLAPI bool blockArrowLLT(const std::vector<MatrixRef> & diag,
                                 const std::vector<MatrixRef> & side,
                                 bool up = false);
 
+/** Parallel version of blockArrowLLT.
+ *
+ * The decompositions of the blocks \f$ D_i \f$, i < b, and the computations of the
+ * \f$ B_i \f$ are independent. They are split into groups of consecutive blocks, one
+ * per thread of \p pool. Each group accumulates its part of
+ * \f$ \sum B_i B_i^T \f$ separately, and the partial sums are added to \f$ D_b \f$
+ * before its decomposition.
+ *
+ * \param pool Threads used for the computations.
+ * \param work Workspace for the partial sums. Resized if needed.
+ *
+ * The result is the same as for blockArrowLLT, up to rounding errors.
+ */
+JRLQP_DLLAPI bool blockArrowLLT(const std::vector<MatrixRef> & diag,
+                                const std::vector<MatrixRef> & side,
+                                bool up,
+                                internal::ThreadPool & pool,
+                                internal::Workspace<> & work);
+
 /** Solve in place the system P L X = M where L is the triangular factor
  * obtained from blockArrowLLT and P is a permutation depending on \p up.
  *
@@ -90,6 +115,19 @@ JRLQP_DLLAPI void blockArrowLSolve(const std::vector<MatrixRef> & diag,
                                    int start = 0,
                                    int end = -1);
 
+/** Parallel version of blockArrowLSolve, where the solves with the blocks \f$ L_i \f$,
+ * i < b, are run by groups on the threads of \p pool. Workspace \p work is used to
+ * accumulate the contributions of each group to the last block row of M.
+ */
+JRLQP_DLLAPI void blockArrowLSolve(const std::vector<MatrixRef> & diag,
+                                   const std::vector<MatrixRef> & side,
+                                   bool up,
+                                   MatrixRef M,
+                                   internal::ThreadPool & pool,
+                                   internal::Workspace<> & work,
+                                   int start = 0,
+                                   int end = -1);
+
 /** Solve in place the system L^T P^T X = M where L is the triangular factor
  * obtained from blockArrowLLT and P is a permutation depending on \p up.
  *
@@ -108,4 +146,16 @@ JRLQP_DLLAPI void blockArrowLTransposeSolve(const std::vector<MatrixRef> & diag,
                                             MatrixRef M,
                                             int start = 0,
                                             int end = -1);
+
+/** Parallel version of blockArrowLTransposeSolve: once the last block row of X is
+ * computed, the solves with the blocks \f$ L_i^T \f$, i < b, are run by groups on the
+ * threads of \p pool.
+ */
+JRLQP_DLLAPI void blockArrowLTransposeSolve(const std::vector<MatrixRef> & diag,
+                                            const std::vector<MatrixRef> & side,
+                                            bool up,
+                                            MatrixRef M,
+                                            internal::ThreadPool & pool,
+                                            int start = 0,
+                                            int end = -1);
 } // namespace jrl::qp::decomposition
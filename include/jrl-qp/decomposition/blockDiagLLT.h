@@ -0,0 +1,76 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <jrl-qp/api.h>
+#include <jrl-qp/defs.h>
+
+namespace jrl::qp::internal
+{
+class ThreadPool;
+} // namespace jrl::qp::internal
+
+namespace jrl::qp::decomposition
+{
+/** Cholesky decomposition of a block diagonal matrix
+ *
+ * \f$ \begin{bmatrix}
+ *    D_1  &       &       \\
+ *         &\ddots &       \\
+ *         &       &  D_b  \\
+ * \end{bmatrix}\f$
+ *
+ * Upon return \f$ D_i \f$ contains \f$ L_i \f$, such that \f$ D_i = L_i L_i^T \f$.
+ * Only the lower triangular part of \f$ D_i \f$ is used to store \f$ L_i \f$.
+ * Its upper part remains whatever was there originally.
+ *
+ * \param diag blocks on the diagonal. Only the lower triangular part is used.
+ * \param start If > 0, the blocks \f$ D_i \f$, i < \p start, are assumed to be
+ * already decomposed.
+ */
+JRLQP_DLLAPI bool blockDiagLLT(const std::vector<MatrixRef> & diag, int start = 0);
+
+/** Parallel version of blockDiagLLT, where the blocks are decomposed by the threads of
+ * \p pool.
+ */
+JRLQP_DLLAPI bool blockDiagLLT(const std::vector<MatrixRef> & diag, internal::ThreadPool & pool);
+
+/** Solve in place the system L X = M where L is the factor obtained from blockDiagLLT.
+ *
+ * \param diag blocks on the diagonal of L. Only the lower triangular part is used.
+ * \param M right hand side of the equation (matrix or vector). Contains the
+ * solution upon return.
+ * \param start First row of M that is not 0.
+ * \param end First row of the terminal 0 block in M. If end < 0, M has no
+ * terminal 0 block.
+ *
+ * Only the blocks intersecting the rows [start, end) are processed.
+ */
+JRLQP_DLLAPI void blockDiagLSolve(const std::vector<MatrixRef> & diag, MatrixRef M, int start = 0, int end = -1);
+
+/** Parallel version of blockDiagLSolve.*/
+JRLQP_DLLAPI void blockDiagLSolve(const std::vector<MatrixRef> & diag,
+                                  MatrixRef M,
+                                  internal::ThreadPool & pool,
+                                  int start = 0,
+                                  int end = -1);
+
+/** Solve in place the system L^T X = M where L is the factor obtained from
+ * blockDiagLLT. The parameters are the same as for blockDiagLSolve.
+ */
+JRLQP_DLLAPI void blockDiagLTransposeSolve(const std::vector<MatrixRef> & diag,
+                                           MatrixRef M,
+                                           int start = 0,
+                                           int end = -1);
+
+/** Parallel version of blockDiagLTransposeSolve.*/
+JRLQP_DLLAPI void blockDiagLTransposeSolve(const std::vector<MatrixRef> & diag,
+                                           MatrixRef M,
+                                           internal::ThreadPool & pool,
+                                           int start = 0,
+                                           int end = -1);
+} // namespace jrl::qp::decomposition
@@ -0,0 +1,62 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <jrl-qp/api.h>
+#include <jrl-qp/defs.h>
+#include <jrl-qp/internal/Workspace.h>
+
+namespace jrl::qp::decomposition
+{
+/** Factorization of a symmetric positive definite matrix \f$ A = D + U U^T \f$ where
+ * \f$ D \f$ is diagonal positive definite and \f$ U \f$ is n x k, with k <= n.
+ *
+ * Writing \f$ D^{-1/2} U = Z \Lambda^{1/2} E^T \f$ (thin QR of \f$ D^{-1/2} U \f$
+ * followed by the eigendecomposition of the k x k matrix \f$ R R^T \f$), we have
+ * \f$ A = D^{1/2} (I + Z \Lambda Z^T) D^{1/2} \f$ with \f$ Z^T Z = I \f$. Since
+ * \f$ F = I + Z S Z^T \f$ with \f$ S = (I + \Lambda)^{1/2} - I \f$ is a symmetric square
+ * root of \f$ I + Z \Lambda Z^T \f$, \f$ L = D^{1/2} F \f$ verifies \f$ A = L L^T \f$.
+ * L is not triangular, but products with \f$ L^{-1} \f$ and \f$ L^{-T} \f$ are
+ * obtained in O(nk) with the Woodbury identity
+ * \f$ F^{-1} = I - Z S (I+S)^{-1} Z^T \f$.
+ *
+ * The decomposition requires \f$ O(n k^2) \f$ operations, and no n x n matrix is
+ * formed. It does not allocate memory once \p work is large enough.
+ *
+ * \param d 1 x n matrix with the diagonal of D (i.e. D in lower band storage, see
+ * bandLLT). Contains the diagonal of \f$ D^{1/2} \f$ upon return.
+ * \param U n x k matrix. Contains Z upon return.
+ * \param s vector of size k. Contains the diagonal of S upon return.
+ * \param work Workspace of size \f$ 2k^2 + 5k \f$. Resized if needed.
+ * \return false if D is not positive definite or if the eigendecomposition failed.
+ */
+JRLQP_DLLAPI bool lowRankLLT(MatrixRef d, MatrixRef U, VectorRef s, internal::Workspace<> & work);
+
+/** Solve in place the system L X = M where L is the factor obtained from lowRankLLT.
+ *
+ * \param d, Z, s factor L, as given by lowRankLLT.
+ * \param M right hand side of the equation (matrix or vector). Contains the
+ * solution upon return.
+ * \param work k x M.cols() workspace.
+ */
+JRLQP_DLLAPI void lowRankLSolve(const MatrixConstRef & d,
+                                const MatrixConstRef & Z,
+                                const VectorConstRef & s,
+                                MatrixRef M,
+                                MatrixRef work);
+
+/** Solve in place the system L^T X = M where L is the factor obtained from lowRankLLT.
+ *
+ * \param d, Z, s factor L, as given by lowRankLLT.
+ * \param M right hand side of the equation (matrix or vector). Contains the
+ * solution upon return.
+ * \param work k x M.cols() workspace.
+ */
+JRLQP_DLLAPI void lowRankLTransposeSolve(const MatrixConstRef & d,
+                                         const MatrixConstRef & Z,
+                                         const VectorConstRef & s,
+                                         MatrixRef M,
+                                         MatrixRef work);
+} // namespace jrl::qp::decomposition
@@ -8,6 +8,12 @@
 
 #include <jrl-qp/api.h>
 #include <jrl-qp/defs.h>
+#include <jrl-qp/internal/Workspace.h>
+
+namespace jrl::qp::internal
+{
+class ThreadPool;
+} // namespace jrl::qp::internal
 
 namespace jrl::qp::decomposition
 {
@@ -37,8 +43,16 @@ namespace jrl::qp::decomposition
  * \f$ B_i \f$.
  * Only the lower triangular part of \f$ D_i \f$ is used to store \f$ L_i \f$.
  * Its upper part remains whatever was there originally.
+ *
+ * \param start If > 0, resume a previous decomposition: \f$ D_i \f$, i < \p start,
+ * and \f$ S_i \f$, i < \p start - 1, are assumed to already contain \f$ L_i \f$ and
+ * \f$ B_i \f$, while the other blocks contain the original matrix. This allows to
+ * update the decomposition when only the blocks \f$ D_i \f$, i >= \p start, and
+ * \f$ S_i \f$, i >= \p start - 1, are changed.
  */
-JRLQP_DLLAPI bool triBlockDiagLLT(const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & subDiag);
+JRLQP_DLLAPI bool triBlockDiagLLT(const std::vector<MatrixRef> & diag,
+                                  const std::vector<MatrixRef> & subDiag,
+                                  int start = 0);
 
 /** Solve in place the system L X = M where L is the triangular factor obtained
  * from triBlockDiagLLT.
@@ -70,4 +84,139 @@ JRLQP_DLLAPI void triBlockDiagLTransposeSolve(const std::vector<MatrixRef> & dia
                                               const std::vector<MatrixRef> & subDiag,
                                               MatrixRef M,
                                               int end = -1);
+
+/** Parallel Cholesky decomposition of the block tri-diagonal matrix described in
+ * triBlockDiagLLT.
+ *
+ * The \f$ b \f$ blocks are split into \f$ p \f$ chunks of consecutive blocks. The
+ * last block of each chunk but the last one is a separator. Putting the separators
+ * last with a permutation \f$ P \f$, we get
+ *
+ * \f$ P A P^T = \begin{bmatrix} A_I & A_{SI}^T \\ A_{SI} & A_S \end{bmatrix} \f$
+ *
+ * where \f$ A_I \f$ is block diagonal, with one block tri-diagonal block per chunk,
+ * and \f$ A_S \f$ is block diagonal. Then
+ * \f$ P A P^T = \tilde{L} \tilde{L}^T \f$ with
+ *
+ * \f$ \tilde{L} = \begin{bmatrix} L_I & 0 \\ W & L_S \end{bmatrix} \f$,
+ * \f$ L_I L_I^T = A_I \f$, \f$ W = A_{SI} L_I^{-T} \f$ and
+ * \f$ L_S L_S^T = A_S - W W^T \f$.
+ *
+ * The chunks of \f$ L_I \f$ and \f$ W \f$ are computed in parallel. The Schur
+ * complement \f$ A_S - W W^T \f$ is block tri-diagonal with \f$ p-1 \f$ blocks and
+ * is factorized sequentially.
+ *
+ * The factor \f$ L = P^T \tilde{L} P \f$ verifies \f$ A = L L^T \f$, but is not
+ * lower triangular. solveL and solveLTranspose solve systems with \f$ L \f$ and
+ * \f$ L^T \f$, and can be used in place of triBlockDiagLSolve and
+ * triBlockDiagLTransposeSolve.
+ *
+ * As with triBlockDiagLLT, the decomposition is done in place: the diagonal blocks of
+ * \f$ L_I \f$ and \f$ L_S \f$ are written in the corresponding \f$ D_i \f$, the
+ * sub-diagonal blocks of \f$ L_I \f$ and the non-zero block of \f$ W \f$ between a
+ * separator and the previous block are written in the corresponding \f$ S_i \f$. The
+ * rest of the factor is kept by this object.
+ *
+ * When there is a single chunk, this is the same as triBlockDiagLLT.
+ */
+class JRLQP_DLLAPI ParallelTriBlockDiagLLT
+{
+public:
+  /** \param pool Threads used for the computations. It must outlive this object.
+   * \param nbChunks Number of chunks to split the matrix into. If <= 0, the size of
+   * \p pool is used. The actual number of chunks can be smaller for matrices with
+   * less than twice this number of blocks.
+   */
+  ParallelTriBlockDiagLLT(internal::ThreadPool & pool, int nbChunks = 0);
+  /** Constructor without pool. One must be given by threadPool before calling compute.*/
+  ParallelTriBlockDiagLLT() = default;
+
+  /** Set the threads to use. \p pool must outlive this object.*/
+  void threadPool(internal::ThreadPool & pool)
+  {
+    pool_ = &pool;
+  }
+
+  /** Set the number of chunks for the next call to compute.*/
+  void nbChunks(int p);
+  /** Number of chunks used by the last call to compute.*/
+  int nbChunks() const
+  {
+    return p_;
+  }
+
+  /** Decomposition of the matrix. Same parameters as triBlockDiagLLT.
+   *
+   * Blocks \f$ S_i \f$ below a separator are read but not modified.
+   */
+  bool compute(const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & subDiag);
+
+  /** Solve in place the system L X = M, where L is the factor obtained by compute.
+   *
+   * \param diag Same blocks as passed to compute.
+   * \param subDiag Same blocks as passed to compute.
+   * \param M right hand side of the equation (matrix or vector). Contains the
+   * solution upon return.
+   * \param start First row of M that is not 0. Useful for optimizing computations.
+   */
+  void solveL(const std::vector<MatrixRef> & diag,
+              const std::vector<MatrixRef> & subDiag,
+              MatrixRef M,
+              int start = 0) const;
+
+  /** Solve in place the system L^T X = M, where L is the factor obtained by compute.
+   *
+   * \param diag Same blocks as passed to compute.
+   * \param subDiag Same blocks as passed to compute.
+   * \param M right hand side of the equation (matrix or vector). Contains the
+   * solution upon return.
+   */
+  void solveLTranspose(const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & subDiag, MatrixRef M) const;
+
+private:
+  /** First block of chunk c.*/
+  int first(int c) const
+  {
+    return chunk_[static_cast<size_t>(c)];
+  }
+  /** Index after the last block of the interior of chunk c.*/
+  int interiorEnd(int c) const
+  {
+    return c < p_ - 1 ? chunk_[static_cast<size_t>(c) + 1] - 1 : chunk_[static_cast<size_t>(c) + 1];
+  }
+  /** Separator at the end of chunk c (c < p-1).*/
+  int sep(int c) const
+  {
+    return chunk_[static_cast<size_t>(c) + 1] - 1;
+  }
+  /** First row of block i.*/
+  int row(int i) const
+  {
+    return rowStart_[static_cast<size_t>(i)];
+  }
+  /** Size of block i.*/
+  int size(int i) const
+  {
+    return row(i + 1) - row(i);
+  }
+  /** Block of W between the separator of chunk c-1 and the interior of chunk c (c>0),
+   * transposed.
+   */
+  Eigen::Map<Eigen::MatrixXd> F(int c) const;
+  /** Block of L_S between the separators of chunks c+1 and c (c < p-2).*/
+  Eigen::Map<Eigen::MatrixXd> G(int c) const;
+
+  internal::ThreadPool * pool_ = nullptr;
+  int requestedChunks_ = 0;
+  /** Number of chunks. */
+  int p_ = 0;
+  /** Chunk c is made of the blocks chunk_[c] to chunk_[c+1]-1.*/
+  std::vector<int> chunk_;
+  /** Row at which each block starts, with the total size as last element.*/
+  std::vector<int> rowStart_;
+  /** Offsets of the F(c) and G(c) in work_.*/
+  std::vector<int> offsetF_;
+  std::vector<int> offsetG_;
+  mutable internal::Workspace<> work_;
+};
 } // namespace jrl::qp::decomposition
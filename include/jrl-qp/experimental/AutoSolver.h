@@ -0,0 +1,204 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/BlockGISolver.h>
+#include <jrl-qp/experimental/BoxAndSingleConstraintSolver.h>
+#include <jrl-qp/structured/ProblemPattern.h>
+
+namespace jrl::qp::experimental
+{
+/** Front-end solving
+ *  min. 0.5 x^T G x + a^T x
+ *  s.t. bl <= C^T x <= bu
+ *       xl <=  x <= xu
+ * with the most appropriate solver, given the sparsity pattern of G and C.
+ *
+ * The pattern (non-zero entries) of G and C is analyzed to detect:
+ *  - a diagonal G with at most one one-sided general constraint and bounds, solved by
+ * BoxAndSingleConstraintSolver after scaling the variables,
+ *  - a block diagonal, block tri-diagonal, block arrow or scalar banded G, solved by
+ * BlockGISolver. The constraints are reordered by the first block of variables they
+ * act on, to form a structured::StructuredC,
+ *  - otherwise, the problem is solved by GoldfarbIdnaniSolver.
+ * A structure is only chosen if the estimated cost of the decomposition of G is
+ * sufficiently lower than for the dense matrix.
+ *
+ * The analysis is kept and reused by the next calls to solve, as long as the non-zero
+ * entries of the new G and C still fit in the detected structure and the sizes are
+ * the same. Otherwise, the problem is analyzed again.
+ *
+ * The results (solution, active set, ...) are given for the original problem, in the
+ * original order of the constraints.
+ */
+class JRLQP_DLLAPI AutoSolver
+{
+public:
+  /** Solver used for the problem.*/
+  enum class Backend
+  {
+    Dense,
+    Block,
+    BoxAndSingleConstraint
+  };
+
+  /** Result of the analysis.*/
+  struct Structure
+  {
+    Backend backend = Backend::Dense;
+    /** Type of G, for Backend::Block.*/
+    structured::StructuredG::Type gType = structured::StructuredG::Type::BlockDiagonal;
+    /** Size of the blocks of variables (a single block for a Banded G).*/
+    std::vector<int> blocks;
+    /** Bandwidth of G, for a Banded G.*/
+    int bandwidth = 0;
+    /** Type of C, for Backend::Block.*/
+    structured::StructuredC::Type cType = structured::StructuredC::Type::Diagonal;
+    /** Block bandwidth of C.*/
+    int cBandwidth = 0;
+    /** Number of constraints in each block of constraints.*/
+    std::vector<int> cstrBlocks;
+    /** The k-th constraint of the reordered problem is the constraint perm[k] of the
+     * original one.
+     */
+    std::vector<int> perm;
+  };
+
+  AutoSolver() = default;
+
+  /** Analyze the pattern of G and C (C being nbVar x nbCstr, as in the solve methods).
+   * Only the lower triangular part of G is considered. The bounds \p bl and \p bu are
+   * only used to check whether the constraints are one-sided.
+   */
+  const Structure & analyze(const MatrixConstRef & G,
+                            const MatrixConstRef & C,
+                            const VectorConstRef & bl,
+                            const VectorConstRef & bu,
+                            bool useBounds);
+
+  /** Solve the problem, analyzing G and C first if needed.*/
+  TerminationStatus solve(const MatrixConstRef & G,
+                          const VectorConstRef & a,
+                          const MatrixConstRef & C,
+                          const VectorConstRef & bl,
+                          const VectorConstRef & bu,
+                          const VectorConstRef & xl,
+                          const VectorConstRef & xu);
+
+  /** Same as above, for sparse G and C. The pattern is taken from the non-zero values
+   * of the matrices.
+   */
+  TerminationStatus solve(const Eigen::SparseMatrix<double> & G,
+                          const VectorConstRef & a,
+                          const Eigen::SparseMatrix<double> & C,
+                          const VectorConstRef & bl,
+                          const VectorConstRef & bu,
+                          const VectorConstRef & xl,
+                          const VectorConstRef & xu);
+
+  /** Options passed to the underlying solvers.*/
+  void options(const SolverOptions & opt);
+
+  const Structure & structure() const
+  {
+    return structure_;
+  }
+  /** Number of times the structure was analyzed.*/
+  int nbAnalyses() const
+  {
+    return nbAnalyses_;
+  }
+
+  const Eigen::VectorXd & solution() const
+  {
+    return x_;
+  }
+  double objectiveValue() const
+  {
+    return f_;
+  }
+  int iterations() const
+  {
+    return it_;
+  }
+  /** Activation status of the constraints (in their original order), then of the
+   * bounds.
+   */
+  const std::vector<ActivationStatus> & activeSet() const
+  {
+    return as_;
+  }
+
+private:
+  /** Whether the pattern of G and C fits in the current structure.*/
+  bool fits(const MatrixConstRef & G,
+            const MatrixConstRef & C,
+            const VectorConstRef & bl,
+            const VectorConstRef & bu,
+            bool useBounds) const;
+  /** Whether the problem has at most one general constraint, which is one-sided.*/
+  bool singleOneSided(const VectorConstRef & bl, const VectorConstRef & bu) const;
+  /** Build the structured storage and views for the current structure.*/
+  void buildViews();
+  TerminationStatus solveDense(const MatrixConstRef & G,
+                               const VectorConstRef & a,
+                               const MatrixConstRef & C,
+                               const VectorConstRef & bl,
+                               const VectorConstRef & bu,
+                               const VectorConstRef & xl,
+                               const VectorConstRef & xu);
+  TerminationStatus solveBlock(const MatrixConstRef & G,
+                               const VectorConstRef & a,
+                               const MatrixConstRef & C,
+                               const VectorConstRef & bl,
+                               const VectorConstRef & bu,
+                               const VectorConstRef & xl,
+                               const VectorConstRef & xu);
+  TerminationStatus solveBox(const MatrixConstRef & G,
+                             const VectorConstRef & a,
+                             const MatrixConstRef & C,
+                             const VectorConstRef & bl,
+                             const VectorConstRef & bu,
+                             const VectorConstRef & xl,
+                             const VectorConstRef & xu);
+
+  SolverOptions options_;
+  Structure structure_;
+  bool analyzed_ = false;
+  int nbAnalyses_ = 0;
+  int nbVar_ = 0;
+  int nbCstr_ = 0;
+  bool useBounds_ = false;
+  /** First row of each block of variables, and first column of each block of
+   * constraints, with the totals last.
+   */
+  std::vector<int> varStart_;
+  std::vector<int> cstrStart_;
+
+  GoldfarbIdnaniSolver dense_;
+  BlockGISolver block_;
+  BoxAndSingleConstraintSolver box_;
+
+  // Copies of the data used by the solvers, in the order of the structure.
+  structured::ProblemPattern pattern_;
+  Eigen::MatrixXd G_;
+  Eigen::VectorXd l_;
+  Eigen::VectorXd u_;
+  Eigen::VectorXd a_;
+  Eigen::VectorXd c_;
+  Eigen::VectorXd xl_;
+  Eigen::VectorXd xu_;
+  Eigen::VectorXd d_;
+
+  Eigen::VectorXd x_;
+  double f_ = 0;
+  int it_ = 0;
+  std::vector<ActivationStatus> as_;
+};
+} // namespace jrl::qp::experimental
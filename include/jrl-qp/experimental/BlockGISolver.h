@@ -29,6 +29,9 @@ public:
    *  min. 0.5 x^T G x + a^T x
    *  s.t. bl <= C^T x <= bu
    *       xl <=  x <= xu
+   *
+   * The blocks of \p G are overwritten by its decomposition. See reuseDecomposition
+   * to give \p G already decomposed instead.
    */
   TerminationStatus solve(const structured::StructuredG & G,
                           const VectorConstRef & a,
@@ -39,6 +42,54 @@ public:
                           const VectorConstRef & xu,
                           const std::vector<ActivationStatus> & as = {});
 
+  /** Prepare the warm start of the next problem in a receding-horizon scheme, where
+   * this problem is the previous one shifted by \p k stages.
+   *
+   * A stage is a block of variables of G, together with the block of constraints of C
+   * with the same index, and the bounds on these variables. The active set of the last
+   * solve is shifted accordingly: the status of the first \p k stages is dropped,
+   * stage i takes the status of stage i+k, and the last \p k stages are seeded with
+   * the status of the last stage of the previous problem. For BlockArrowUp (resp.
+   * BlockArrowDown) G, the first (resp. last) block is not a stage and keeps its status.
+   * Where the sizes of the stages differ, the constraints are made inactive. Equality
+   * constraints and fixed variables are made inactive as well, as they are detected
+   * from the data of the next problem.
+   *
+   * The shifted active set replaces the current one, and is used by the next call to
+   * solve if the warm start option is on and no active set is given. The
+   * Goldfarb-Idnani method computes its starting point from the active set, so that
+   * there is no primal or dual iterate to carry over.
+   *
+   * Must be called after solve, with the matrices of the last problem still valid (only
+   * their sizes are used).
+   */
+  void shift(int k = 1);
+
+  /** Compaction threshold of the orthonormal part of J, see
+   * internal::OrthonormalSequence::compactionRatio. With a non-positive value, Q is
+   * always kept in factored form and the solver needs no n x n storage, at the expense
+   * of a cost of applying Q growing with the number of active set changes. Default is 1.
+   */
+  void compactionRatio(double r);
+
+  /** Number of active constraints for which R and the orthonormal part of J are
+   * preallocated when the number of variables changes. Beyond it, their storage grows
+   * during the solve and is kept for the next ones. A negative value (default) means
+   * nbVar: no solve allocates memory, at the expense of an O(nbVar^2) storage.
+   */
+  void reserveHint(int nbActive);
+
+  /** If \p reuse is \a true, a G given to solve already decomposed (G.decomposed() is
+   * \a true, e.g. after G.lltInPlace() or G.refactorize()) is used as is, so that G can
+   * be updated between two solves with keepOriginal, updateDiag, updateOffDiag and
+   * refactorize. The caller is then responsible for the decomposition being up to date:
+   * it must call refactorize after updating blocks, and G.invalidateDecomposition()
+   * after writing directly into the blocks.
+   * Default is \a false: the blocks of G are assumed to contain the original matrix,
+   * and are always decomposed.
+   */
+  void reuseDecomposition(bool reuse);
+
 protected:
   /** Structure to gather the problem definition. */
   struct Problem
@@ -85,10 +136,10 @@ protected:
   mutable internal::Workspace<> work_d_;
   structured::StructuredJ J_;
   structured::StructuredQR QR_;
-  // internal::Workspace<> work_tmp_; // for multiplication by Householder transform
-  // internal::Workspace<> work_hCoeffs_; // for initial QR decomposition
   mutable internal::Workspace<> work_cx_;
   internal::Workspace<> work_bact_;
+  std::vector<ActivationStatus> shiftedAs_;
+  bool reuseDecomposition_ = false;
   Problem pb_;
 };
 
@@ -0,0 +1,55 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <Eigen/Core>
+
+#include <jrl-qp/experimental/BlockGISolver.h>
+
+namespace jrl::qp::experimental
+{
+/** A specialized solver for problems of the form
+ *  min. 0.5 x^T diag(g) x + a^T x
+ *  s.t. bl <= C^T x <= bu
+ *       xl <=  x <= xu
+ * with g > 0, such as weighted least-distance problems.
+ *
+ * This is BlockGISolver with G seen as a banded matrix of bandwidth 0: J = D^-1/2 Q is
+ * kept in factored form, with Q an orthonormal sequence, instead of being formed as a
+ * dense n x n matrix. The decomposition of G is in O(n), and the products with J in
+ * O(n) plus the cost of applying Q. The compaction of Q is disabled and R and Q are
+ * not preallocated (see BlockGISolver::compactionRatio and BlockGISolver::reserveHint),
+ * so that the memory used is in O(n) per active set change and O(q^2) for R, q being
+ * the number of active constraints, but never O(n^2). The storage grows during the
+ * first solves.
+ *
+ * Like BoxAndSingleConstraintSolver for G = I, this is a shortcut: AutoSolver selects
+ * the same path for a diagonal G given as a dense matrix.
+ */
+class JRLQP_DLLAPI DiagonalHessianSolver : public BlockGISolver
+{
+public:
+  DiagonalHessianSolver();
+  /** Pre-allocate the data for a problem with \p nbVar variables, \p nbCstr
+   * (general) constraints, and bounds if \p useBounds is \a true.*/
+  DiagonalHessianSolver(int nbVar, int nbCstr, bool useBounds);
+
+  /** Solve the problem above, where \p g is the diagonal of G. \p g is copied and left
+   * untouched.
+   */
+  TerminationStatus solve(const VectorConstRef & g,
+                          const VectorConstRef & a,
+                          const MatrixConstRef & C,
+                          const VectorConstRef & bl,
+                          const VectorConstRef & bu,
+                          const VectorConstRef & xl,
+                          const VectorConstRef & xu,
+                          const std::vector<ActivationStatus> & as = {});
+
+private:
+  /** Copy of g, in lower band storage. It is decomposed in place.*/
+  Eigen::MatrixXd d_;
+  structured::StructuredG G_;
+  structured::StructuredC C_;
+};
+} // namespace jrl::qp::experimental
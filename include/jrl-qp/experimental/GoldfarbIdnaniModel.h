@@ -0,0 +1,131 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <jrl-qp/experimental/GoldfarbIdnaniSolver.h>
+
+namespace jrl::qp::experimental
+{
+/** Persistent version of GoldfarbIdnaniSolver, for sequences of problems
+ *  min. 0.5 x^T G x + a^T x
+ *  s.t. bl <= C^T x <= bu
+ *       xl <=  x <= xu
+ * where G is fixed and the other data change partially from one problem to the next.
+ *
+ * The problem is given once with setProblem, then modified with the update methods,
+ * and solved with solve(). As the model knows what changed, it avoids recomputing what
+ * is still valid:
+ *  - the Cholesky decomposition of G is computed at the first solve only,
+ *  - with the warm start option (on by default), the active set of the last solution is
+ * kept, together with the factorization J = L^-T Q and R of the active constraints, if
+ * the last solve was successful. When only a, the bounds or inactive constraint columns
+ * changed, the new starting point is then computed in O(n^2), without any
+ * decomposition. A changed active constraint column is removed from the factorization
+ * and added back with its new value. Each such replacement costs O(n^2), to compare with
+ * the O(n^3) of a new factorization, so that it is only done for a limited number of
+ * columns (see maxColumnUpdates).
+ *  - when the active set cannot be kept as is (e.g. a bound of an active constraint
+ * became infinite, or the equality constraints changed), the factorization of the
+ * active constraints is recomputed from the last active set, still reusing the
+ * decomposition of G.
+ *
+ * The data are copied by the model, so that the arguments of setProblem and of the
+ * update methods do not need to outlive the calls.
+ */
+class JRLQP_DLLAPI GoldfarbIdnaniModel : public GoldfarbIdnaniSolver
+{
+public:
+  GoldfarbIdnaniModel();
+
+  /** Set the problem data. The decomposition of G is computed at the next solve.*/
+  void setProblem(const MatrixConstRef & G,
+                  const VectorConstRef & a,
+                  const MatrixConstRef & C,
+                  const VectorConstRef & bl,
+                  const VectorConstRef & bu,
+                  const VectorConstRef & xl,
+                  const VectorConstRef & xu);
+
+  /** Change the linear term a of the objective.*/
+  void updateLinearTerm(const VectorConstRef & a);
+  /** Change the bounds on the general constraints.*/
+  void updateBounds(const VectorConstRef & bl, const VectorConstRef & bu);
+  /** Change the bounds on the variables. The problem must have been set with bounds.*/
+  void updateVarBounds(const VectorConstRef & xl, const VectorConstRef & xu);
+  /** Change the columns idx[k] of C to cols.col(k).*/
+  void updateConstraintColumns(const std::vector<int> & idx, const MatrixConstRef & cols);
+  /** Low-rank modification G += U diag(s) U^T of the objective matrix, as given by
+   * quasi-Newton updates (a non-diagonal symmetric S can be diagonalized beforehand).
+   *
+   * If G was already factorized, its Cholesky factor and, when the last solve can be
+   * resumed, the factorization J, R of the active set are updated in O(k n^2) for a
+   * rank-k modification, instead of being recomputed in O(n^3). If the update of the
+   * Cholesky factor fails (G is not positive definite anymore, or is too badly
+   * conditioned), G is decomposed again at the next solve.
+   */
+  void updateHessian(const MatrixConstRef & U, const VectorConstRef & s);
+
+  /** Maximum number of changed active columns of C that are replaced in the
+   * factorization of the active set. If more active columns changed since the last
+   * solve, the factorization is recomputed. A negative value (default) corresponds to
+   * max(1, n/4), where n is the number of variables.
+   */
+  void maxColumnUpdates(int k)
+  {
+    maxColumnUpdates_ = k;
+  }
+
+  /** Solve the current problem.*/
+  TerminationStatus solve();
+
+protected:
+  internal::InitTermination init_() override;
+
+  /** Rebuild G in G_ from its strictly upper part and diagG_, after a failed
+   * decomposition.
+   */
+  void restoreG();
+  /** Whether the active set is still valid for the current bounds.*/
+  bool activeSetConsistent() const;
+  /** Replace the active constraints whose column changed in the factorization. Return
+   * false if there are too many of them, or if a column became linearly dependent of the
+   * other active constraints.
+   */
+  bool updateChangedColumns();
+  /** Update J and R for the modification G += sigma v v^T.
+   *
+   * With p = J^T v, J (I + beta p p^T) is a factor of the new G^-1 for a suitable beta.
+   * Multiplying by I + beta p p^T on the right makes J^T N = [R; 0] a rank-one
+   * modification of an upper triangular matrix, whose triangular form is restored by
+   * two sweeps of Givens rotations. Return false if G + sigma v v^T is not positive
+   * definite.
+   */
+  bool updateFactorization(const VectorConstRef & v, double sigma);
+
+  Eigen::MatrixXd G_;
+  Eigen::VectorXd a_;
+  Eigen::MatrixXd C_;
+  Eigen::VectorXd bl_;
+  Eigen::VectorXd bu_;
+  Eigen::VectorXd xl_;
+  Eigen::VectorXd xu_;
+
+  /** Whether G_ contains the Cholesky factor of G. The strictly upper part of G_ still
+   * contains G, and its diagonal is then kept in diagG_.
+   */
+  bool factorized_ = false;
+  Eigen::VectorXd diagG_;
+  /** Whether the active set and its factorization at the end of the last solve can be
+   * resumed.
+   */
+  bool resumable_ = false;
+  /** Constraints whose column changed since the last solve.*/
+  std::vector<int> changedCols_;
+  std::vector<bool> colChanged_;
+  int maxColumnUpdates_ = -1;
+};
+} // namespace jrl::qp::experimental
@@ -75,6 +75,12 @@ protected:
   virtual internal::TerminationType processInitialActiveSet();
   virtual internal::TerminationType initializeComputationData();
   virtual internal::TerminationType initializePrimalDualPoints();
+  /** Fill the right-hand side b_act of the active constraints, from the bounds.*/
+  void initializeActiveBounds();
+  /** Deactivate the inequality constraints with negative multipliers, after the
+   * initialization of the primal-dual point.
+   */
+  void deactivateNegativeMultipliers();
 
   mutable internal::Workspace<> work_d_;
   internal::Workspace<> work_J_;
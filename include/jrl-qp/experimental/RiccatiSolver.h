@@ -0,0 +1,185 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <jrl-qp/DualSolver.h>
+
+namespace jrl::qp::experimental
+{
+/** Dual active-set solver for linear-quadratic optimal control problems
+ *
+ *  min.  sum_{k=0}^{N} 0.5 y_k^T H_k y_k + a^T y
+ *  s.t.  x_0 = x0
+ *        x_{k+1} = F_k y_k + c_k,     k = 0..N-1
+ *        bl_k <= C_k^T y_k <= bu_k,  k = 0..N
+ *        xl <= y <= xu
+ *
+ * where y_k = [x_k; u_k] for k < N, y_N = x_N and y = [y_0; ...; y_N]. The states
+ * x_k have size nx and the controls u_k size nu. F_k = [A_k B_k] is nx x (nx+nu).
+ *
+ * This is the Goldfarb-Idnani method, where the dynamics are not part of the active
+ * set but are eliminated. The role of G^-1 is played by the operator P such that
+ * P g is the solution of min. 0.5 y^T H y - g^T y subject to the homogeneous dynamics
+ * (x0 = 0 and c_k = 0). It is applied by a Riccati recursion, whose factorization is
+ * computed once per solve in O(N (nx+nu)^3), and each application costs
+ * O(N (nx+nu)^2).
+ *
+ * For the active set given by the (signed) constraint normals N, the solver maintains
+ * the Cholesky factor of N^T P N. Activating a constraint appends a row to this
+ * factor, and deactivating one is a rank-one update of its trailing part, so that an
+ * iteration costs two applications of P and O(q^2) operations for q active constraints.
+ *
+ * The constraints are given in the same form as for the other solvers: general
+ * constraints first (stage by stage), then bounds, in the active set. Constraints
+ * acting on x_0 only are fixed by the initial state: the solver returns INFEASIBLE if
+ * x0 violates one of them, and they are otherwise never part of the active set.
+ */
+class JRLQP_DLLAPI RiccatiSolver : public DualSolver
+{
+public:
+  RiccatiSolver();
+  /** Pre-allocate the data for a problem with \p N stages, states of size \p nx,
+   * controls of size \p nu, \p nbCstr general constraints and bounds if \p useBounds is
+   * \a true.
+   */
+  RiccatiSolver(int nx, int nu, int N, int nbCstr, bool useBounds);
+
+  virtual ~RiccatiSolver() = default;
+
+  /** Solve the problem described above.
+   *
+   * \param H N+1 stage Hessian matrices. H_k is (nx+nu) x (nx+nu) for k < N, and
+   * H_N is nx x nx.
+   * \param a Linear term.
+   * \param F N dynamics matrices [A_k B_k].
+   * \param c Stacked dynamics offsets c_k (size N*nx).
+   * \param x0 Initial state.
+   * \param C N+1 stage constraint matrices, C_k having as many rows as y_k.
+   * \param bl Stacked lower bounds of the stage constraints.
+   * \param bu Stacked upper bounds of the stage constraints.
+   * \param xl Lower bounds on y (can be of size 0 if there is no bounds).
+   * \param xu Upper bounds on y (can be of size 0 if there is no bounds).
+   * \param as Initial active set, for warm start.
+   */
+  TerminationStatus solve(const std::vector<MatrixConstRef> & H,
+                          const VectorConstRef & a,
+                          const std::vector<MatrixConstRef> & F,
+                          const VectorConstRef & c,
+                          const VectorConstRef & x0,
+                          const std::vector<MatrixConstRef> & C,
+                          const VectorConstRef & bl,
+                          const VectorConstRef & bu,
+                          const VectorConstRef & xl,
+                          const VectorConstRef & xu,
+                          const std::vector<ActivationStatus> & as = {});
+
+protected:
+  /** Structure to gather the problem definition. */
+  struct Problem
+  {
+  public:
+    Problem()
+    : a(Eigen::VectorXd(0)), c(Eigen::VectorXd(0)), x0(Eigen::VectorXd(0)), bl(Eigen::VectorXd(0)),
+      bu(Eigen::VectorXd(0)), xl(Eigen::VectorXd(0)), xu(Eigen::VectorXd(0))
+    {
+    }
+
+    // See BlockGISolver::Problem
+    Problem & operator=(const Problem &) = delete;
+    std::vector<MatrixConstRef> H;
+    VectorConstRef a;
+    std::vector<MatrixConstRef> F;
+    VectorConstRef c;
+    VectorConstRef x0;
+    std::vector<MatrixConstRef> C;
+    VectorConstRef bl;
+    VectorConstRef bu;
+    VectorConstRef xl;
+    VectorConstRef xu;
+    std::vector<ActivationStatus> as;
+  };
+
+  internal::InitTermination init_() override;
+  internal::SelectedConstraint selectViolatedConstraint_(const VectorConstRef & x) const override;
+  void computeStep_(VectorRef z, VectorRef r, const internal::SelectedConstraint & sc) const override;
+  StepLength computeStepLength_(const internal::SelectedConstraint & sc,
+                                const VectorConstRef & x,
+                                const VectorConstRef & u,
+                                const VectorConstRef & z,
+                                const VectorConstRef & r) const override;
+  bool addConstraint_(const internal::SelectedConstraint & sc) override;
+  bool removeConstraint_(int l) override;
+  double dot_(const internal::SelectedConstraint & sc, const VectorConstRef & z) override;
+  void resize_(int nbVar, int nbCstr, bool useBounds) override;
+
+  virtual internal::TerminationType processInitialActiveSet();
+  virtual internal::TerminationType initializeComputationData();
+  virtual internal::TerminationType initializePrimalDualPoints();
+
+  /** Resize the data depending on the stage sizes.*/
+  void resizeStages(int nx, int nu, int N);
+  /** Riccati factorization of the problem. Returns \c false if the Hessian is not
+   * positive definite on the space of the dynamics.
+   */
+  bool factorize();
+  /** y = argmin 0.5 y^T H y + l^T y subject to the dynamics. If \p affine is \c false,
+   * x0 and the c_k are taken to be 0.
+   */
+  void riccatiSolve(VectorRef y, const VectorConstRef & l, bool affine) const;
+  /** Whether constraint \p i (general constraint or bound) acts on x_0 only. Its value
+   * is then fixed by the initial state, and P maps its normal to 0: it is checked
+   * against x0 and never activated.
+   */
+  bool onInitialStateOnly(int i) const;
+  /** Dot product of \p y with the normal of constraint \p i, signed according to
+   * \p status.
+   */
+  double cstrDot(int i, ActivationStatus status, const VectorConstRef & y) const;
+  /** y += s * normal of constraint \p i, signed according to \p status.*/
+  void addCstr(VectorRef y, int i, ActivationStatus status, double s) const;
+  /** Objective value at \p y.*/
+  double objective(const VectorConstRef & y) const;
+  /** Append a row to the Cholesky factor of N^T P N, given l = L^-1 N^T w and
+   * delta = n^T w, with w = P n for the new constraint normal n. The factor has q rows
+   * before the call.
+   */
+  bool appendToFactor(int q, const VectorConstRef & l, double delta);
+  /** Lower triangular Cholesky factor of N^T P N, for q active constraints.*/
+  auto getL(int q) const
+  {
+    return work_L_.asMatrix(q, q, maxActive_).template triangularView<Eigen::Lower>();
+  }
+
+  int nx_ = 0;
+  int nu_ = 0;
+  int N_ = 0;
+  /** Maximum number of linearly independent active constraints: N*nu.*/
+  int maxActive_ = 0;
+  /** First constraint of each stage, with the total number of constraints last.*/
+  std::vector<int> cstrStart_;
+  /** Stage of each constraint.*/
+  std::vector<int> toStage_;
+
+  // Riccati factorization: P_k (nx x nx), Cholesky factor L_k of the reduced Hessian on
+  // u_k (nu x nu) and Y_k = L_k^-1 (S_k + B_k^T P_{k+1} A_k) (nu x nx)
+  internal::Workspace<> work_P_;
+  internal::Workspace<> work_Lk_;
+  internal::Workspace<> work_Y_;
+  internal::Workspace<> work_tmp_;
+  mutable internal::Workspace<> work_p_;
+
+  mutable internal::Workspace<> work_L_;
+  mutable internal::Workspace<> work_g_;
+  mutable internal::Workspace<> work_w_;
+  mutable internal::Workspace<> work_l_;
+  mutable double delta_ = 0;
+  internal::Workspace<> work_xunc_;
+  internal::Workspace<> work_bact_;
+  mutable internal::Workspace<> work_cx_;
+  Problem pb_;
+};
+} // namespace jrl::qp::experimental
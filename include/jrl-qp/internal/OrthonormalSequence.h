@@ -23,11 +23,24 @@ enum class OSeqType
 
 /** Represents a matrix diag(I, Q, I) where Q is an orthonormal matrix
  * described as a sequence of elementary orthonormal matrices.
+ *
+ * The data of the sequence are stored in a single buffer. It is either owned by the
+ * object, or provided by the user (typically an OrthonormalSequence storing all its
+ * elements in a common arena).
  */
 class JRLQP_DLLAPI ElemOrthonormalSequence
 {
 public:
+  /** Sequence of type \p type on a matrix of size \p n, able to hold \p size
+   * elementary transformations, and managing its own memory.*/
   ElemOrthonormalSequence(OSeqType type, int n, int size);
+  /** Same as above, but using the memory pointed to by \p buffer, that must be at least
+   * of size storageSize(type, n, size).*/
+  ElemOrthonormalSequence(OSeqType type, int n, int size, double * buffer);
+
+  /** Number of doubles needed to store a sequence of \p size transformations of type
+   * \p type on a matrix of size \p n.*/
+  static int storageSize(OSeqType type, int n, int size);
 
   /** Adding a sequence of Householder rotations*/
   template<typename VectorType, typename CoeffType>
@@ -36,10 +49,16 @@ public:
   void add(const Givens & Q);
   /** Adding a Householder reflector.*/
   void add(const VectorConstRef & essential, double tau);
+  /** Adding the transposition of the elements \p i and \p j (permutation sequence only).*/
+  void add(int i, int j);
 
   void applyToTheLeft(VectorRef v, int start, int size) const;
   void applyTransposeToTheLeft(VectorRef v, int start, int size) const;
 
+  /** Change the buffer used by a sequence not managing its memory, e.g. after the
+   * data have been moved.*/
+  void rebase(double * buffer);
+
   OSeqType type() const
   {
     return type_;
@@ -64,14 +83,30 @@ public:
   Eigen::MatrixXd toDense() const;
 
 private:
+  double * data()
+  {
+    return buffer_ ? buffer_ : work_.asVector(work_.size(), {}).data();
+  }
+
+  const double * data() const
+  {
+    return buffer_ ? buffer_ : work_.asVector(work_.size()).data();
+  }
+
   OSeqType type_;
   int n_; // Size of the matrix represented by the sequence
+  int capacity_; // Maximum number of elementary transformation
   int size_; // Number of elementary transformation
-  Workspace<> work1_;
-  Workspace<> work2_;
-  Workspace<> tmp_;
+  double * buffer_ = nullptr; // External memory, if any
+  Workspace<> work_; // Memory, if not external
 };
 
+/** Represents an orthonormal matrix as a product of sequences diag(I, Q_i, I).
+ *
+ * The data of all the sequences are stored contiguously in an arena that is kept
+ * across calls to clear(). Once the arena is large enough, adding sequences does not
+ * allocate memory anymore.
+ */
 class JRLQP_DLLAPI OrthonormalSequence
 {
 public:
@@ -81,30 +116,80 @@ public:
   void add(int start, const Givens & Q);
   /** Adding a Householder reflector.*/
   void add(int start, const VectorConstRef & essential, double tau);
+  /** Adding the transposition of the elements \p i and \p j of a permutation sequence
+   * starting at \p start. \p i and \p j are relative to \p start.*/
+  void add(int start, int i, int j);
 
   void prepare(OSeqType type, int n, int seqSize);
 
   void clear();
   void resize(int n);
+  /** Preallocate memory for \p nbElem calls to prepare for a single Householder
+   * reflector or a sequence of Givens rotations.*/
+  void reserve(int nbElem);
 
   int size() const;
 
   void applyToTheLeft(VectorRef v) const;
   void applyTransposeToTheLeft(VectorRef v) const;
 
+  /** Same as applyToTheLeft(v), for a vector \p v known to be zero outside of the
+   * segment [start, start+size). The elements acting only on the zero part of \p v are
+   * skipped.*/
+  void applyToTheLeft(VectorRef v, int start, int size) const;
+  /** Same as applyTransposeToTheLeft(v), for a vector \p v known to be zero outside of
+   * the segment [start, start+size).*/
+  void applyTransposeToTheLeft(VectorRef v, int start, int size) const;
+
   void applyToTheLeft(VectorRef v, const SingleNZSegmentVector & in) const;
   void applyTransposeToTheLeft(VectorRef out, const SingleNZSegmentVector & in) const;
 
+  /** Set the threshold for the compaction of the sequence.
+   *
+   * The sequence represents Q = D H_0 ... H_k, where D is an optional dense matrix.
+   * When the estimated cost of applying H_0 ... H_k exceeds \p r times the cost of a
+   * dense matrix-vector product, the elements are merged into D upon the next call to
+   * prepare. This bounds the cost of applying Q when many elements are added.
+   * A non-positive value disables the compaction, so that no n x n storage is needed.
+   * Default is 1.
+   */
+  void compactionRatio(double r);
+  /** Merge all the current elements into the dense part.*/
+  void compact();
+
 private:
   struct EmbeddedSeq
   {
-    EmbeddedSeq(int start, OSeqType type, int n, int size) : start(start), H(type, n, size) {}
+    EmbeddedSeq(int start, int offset, OSeqType type, int n, int size, double * buffer)
+    : start(start), offset(offset), H(type, n, size, buffer)
+    {
+    }
     int start;
+    int offset; // Position of the data in the arena
     ElemOrthonormalSequence H;
   };
 
+  /** Make sure the arena can store \p size more elements.*/
+  void growArena(int size);
+  /** Apply H_0 ... H_k, i.e. the elements only, without the dense part.*/
+  void applySeqToTheLeft(VectorRef v) const;
+  /** Apply (H_0 ... H_k)^T, i.e. the elements only, without the dense part.*/
+  void applySeqTransposeToTheLeft(VectorRef v) const;
+  /** Approximate number of flops to apply an element.*/
+  static double applicationCost(OSeqType type, int n, int seqSize);
+  /** Approximate number of flops to apply the dense part.*/
+  double denseCost() const;
+
   int n_; // Size of the matrix represented by the sequence.
+  int nbSeq_ = 0; // Number of elements of seq_ in use. The others are kept to reuse their memory.
+  int used_ = 0; // Number of elements of arena_ in use.
   std::vector<EmbeddedSeq> seq_;
+  Workspace<> arena_;
+  Workspace<> dense_; // Dense part D, n_ x n_.
+  mutable Workspace<> tmp_; // Temporary vector for the products with D.
+  bool hasDense_ = false;
+  double seqCost_ = 0; // Estimated cost of applying the elements in use.
+  double compactionRatio_ = 1;
 };
 
 /** Wrapper class representing an orthonormal matrix Q partitioned as Q = [Q1 Q2].*/
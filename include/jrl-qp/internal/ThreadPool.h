@@ -0,0 +1,77 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <jrl-qp/api.h>
+
+namespace jrl::qp::internal
+{
+/** A fixed set of worker threads to run parallel loops.
+ *
+ * The thread calling parallelFor takes part in the computations, so that a pool of
+ * size \a n has \a n-1 worker threads. Dispatching a loop does not allocate memory.
+ *
+ * A pool runs one loop at a time: parallelFor must not be called concurrently from
+ * several threads, nor from within a task.
+ */
+class JRLQP_DLLAPI ThreadPool
+{
+public:
+  /** Create a pool of \p nbThreads threads, including the calling thread. If
+   * \p nbThreads <= 0, the number of hardware threads is used.
+   */
+  explicit ThreadPool(int nbThreads = 0);
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+  ~ThreadPool();
+
+  /** Number of threads, including the calling thread.*/
+  int size() const
+  {
+    return static_cast<int>(workers_.size()) + 1;
+  }
+
+  /** Call f(i) for i = 0 to n-1, distributing the calls over the threads of the pool.
+   * Returns when all calls are done. The order of the calls is unspecified.
+   */
+  template<typename F>
+  void parallelFor(int n, F && f)
+  {
+    using Fun = std::remove_reference_t<F>;
+    run(
+        n, [](void * data, int i) { (*static_cast<Fun *>(data))(i); },
+        const_cast<void *>(static_cast<const void *>(&f)));
+  }
+
+private:
+  using Task = void (*)(void *, int);
+
+  void run(int n, Task task, void * data);
+  /** Loop of the worker threads.*/
+  void work();
+  /** Take and run indices until the loop is exhausted.*/
+  void process();
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+
+  Task task_ = nullptr;
+  void * data_ = nullptr;
+  int n_ = 0;
+  std::atomic<int> next_ = 0;
+  /** Number of workers that did not finish the current loop yet.*/
+  int busy_ = 0;
+  /** Incremented at each new loop.*/
+  unsigned generation_ = 0;
+  bool stop_ = false;
+};
+} // namespace jrl::qp::internal
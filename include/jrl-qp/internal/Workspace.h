@@ -42,6 +42,17 @@ public:
     }
   }
 
+  /** Grow the buffer to the given size, keeping its content. Does nothing if the buffer
+   * is already large enough.
+   */
+  void conservativeResize(int size)
+  {
+    if(size > buffer_.size())
+    {
+      buffer_.conservativeResize(size);
+    }
+  }
+
   /** Get the size of the buffer.*/
   int size() const
   {
@@ -0,0 +1,34 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <jrl-qp/api.h>
+#include <jrl-qp/defs.h>
+
+namespace jrl::qp::internal
+{
+/* Operations on the small blocks of the structured decompositions.
+ *
+ * When the blocks have size 6 or 12, the computations are done by kernels with
+ * compile-time sizes, working on a local copy of the blocks. Other sizes are handled by
+ * the generic Eigen routines. The choice is made at each call, so that matrices with
+ * blocks of mixed sizes are supported.
+ */
+
+/** In-place Cholesky decomposition of the lower part of the square matrix \p A.
+ * The upper part is left untouched. Returns \c false if \p A is not positive definite.
+ */
+JRLQP_DLLAPI bool blockLLT(MatrixRef A);
+
+/** X = X L^-T where L is the lower triangular part of \p L.*/
+JRLQP_DLLAPI void blockSolveLTransposeRight(const MatrixConstRef & L, MatrixRef X);
+
+/** X = L^-1 X where L is the lower triangular part of \p L.*/
+JRLQP_DLLAPI void blockSolveLLeft(const MatrixConstRef & L, MatrixRef X);
+
+/** D = D - X X^T, computing only the lower part of \p D.*/
+JRLQP_DLLAPI void blockRankUpdate(MatrixRef D, const MatrixConstRef & X);
+
+/** D = D - X^T X, computing only the lower part of \p D.*/
+JRLQP_DLLAPI void blockRankUpdateTranspose(MatrixRef D, const MatrixConstRef & X);
+} // namespace jrl::qp::internal
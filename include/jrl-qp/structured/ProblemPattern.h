@@ -0,0 +1,146 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <jrl-qp/api.h>
+#include <jrl-qp/defs.h>
+#include <jrl-qp/structured/StructuredC.h>
+#include <jrl-qp/structured/StructuredG.h>
+
+namespace jrl::qp::structured
+{
+/** Storage and structured views for problems with a fixed block structure.
+ *
+ * Everything that only depends on the sizes and the sparsity pattern is computed once,
+ * by the constructor or reset: the storage of the blocks of G and C, and the
+ * StructuredG and StructuredC referring to it, with their block partitions and index
+ * tables. Between two solves, only the numeric values are written into the blocks,
+ * and the same G() and C() are given to BlockGISolver::solve. Neither the views nor
+ * the storage are then rebuilt, and no memory is allocated.
+ *
+ * G can have any StructuredG type. For the block types, block i of G is of size
+ * varSizes[i]. For Banded, the blocks of variables are only used to partition C.
+ * C is block banded with block bandwidth cBandwidth: block column j has blocks acting
+ * on the variable blocks j to j+cBandwidth.
+ *
+ * BlockGISolver decomposes G in place: its values need to be written again before
+ * each solve.
+ */
+class JRLQP_DLLAPI ProblemPattern
+{
+public:
+  ProblemPattern() = default;
+  /** See reset.*/
+  ProblemPattern(StructuredG::Type gType,
+                 const std::vector<int> & varSizes,
+                 const std::vector<int> & cstrSizes,
+                 int cBandwidth = 0,
+                 int gBandwidth = 0);
+
+  // The views refer to the storage of this object.
+  ProblemPattern(const ProblemPattern &) = delete;
+  ProblemPattern & operator=(const ProblemPattern &) = delete;
+
+  /** Allocate the storage and build the views for a problem where G has type \p gType
+   * and C has block bandwidth \p cBandwidth, with varSizes[i] variables and
+   * cstrSizes[i] constraints in block i. \p gBandwidth is the bandwidth of G for a
+   * Banded G, and is ignored otherwise. The values of the blocks are set to 0.
+   */
+  void reset(StructuredG::Type gType,
+             const std::vector<int> & varSizes,
+             const std::vector<int> & cstrSizes,
+             int cBandwidth = 0,
+             int gBandwidth = 0);
+
+  /** Structured G, referring to the storage of this object.*/
+  const StructuredG & G() const
+  {
+    return G_;
+  }
+  /** Structured C, referring to the storage of this object.*/
+  const StructuredC & C() const
+  {
+    return C_;
+  }
+
+  /** Diagonal block i of G, or the band for a Banded G (i = 0).*/
+  MatrixRef Gdiag(int i)
+  {
+    return Gdiag_[static_cast<size_t>(i)];
+  }
+  /** Off-diagonal block i of G, as in StructuredG.*/
+  MatrixRef GoffDiag(int i)
+  {
+    return Goff_[static_cast<size_t>(i)];
+  }
+  /** Diagonal block i of C.*/
+  MatrixRef Cdiag(int i)
+  {
+    return Cdiag_[static_cast<size_t>(i)];
+  }
+  /** Block (i+k, i) of C, for 1 <= k <= cBandwidth.*/
+  MatrixRef CsubDiag(int k, int i)
+  {
+    return Csub_[static_cast<size_t>(k - 1)][static_cast<size_t>(i)];
+  }
+
+  /** Copy the blocks of G from the dense symmetric matrix \p G. For a Banded G, only
+   * the lower band of \p G is read.
+   */
+  void setG(const MatrixConstRef & G);
+  /** Copy column \p k of C from the dense vector \p c of size nbVar(). The elements of
+   * \p c outside of the blocks of the column are ignored.
+   */
+  void setCCol(int k, const VectorConstRef & c);
+  /** Copy C from the dense nbVar() x nbCstr() matrix \p C.*/
+  void setC(const MatrixConstRef & C);
+
+  int nbBlocks() const
+  {
+    return static_cast<int>(nbVar_.size());
+  }
+  int nbVar() const
+  {
+    return varStart_.back();
+  }
+  int nbCstr() const
+  {
+    return cstrStart_.back();
+  }
+  /** First variable of block i (nbVar() for i = nbBlocks()).*/
+  int varStart(int i) const
+  {
+    return varStart_[static_cast<size_t>(i)];
+  }
+  /** First constraint of block i (nbCstr() for i = nbBlocks()).*/
+  int cstrStart(int i) const
+  {
+    return cstrStart_[static_cast<size_t>(i)];
+  }
+
+private:
+  int nv(int i) const
+  {
+    return nbVar_[static_cast<size_t>(i)];
+  }
+
+  std::vector<int> nbVar_;
+  std::vector<int> nbCstr_;
+  std::vector<int> varStart_ = {0};
+  std::vector<int> cstrStart_ = {0};
+  /** Block of each constraint.*/
+  std::vector<int> toBlock_;
+
+  std::vector<Eigen::MatrixXd> Gdiag_;
+  std::vector<Eigen::MatrixXd> Goff_;
+  std::vector<Eigen::MatrixXd> Cdiag_;
+  std::vector<std::vector<Eigen::MatrixXd>> Csub_;
+
+  StructuredG G_;
+  StructuredC C_;
+};
+} // namespace jrl::qp::structured
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iosfwd>
 #include <vector>
 
@@ -9,31 +10,87 @@
 #include <jrl-qp/defs.h>
 
 #include <jrl-qp/internal/SingleNZSegmentVector.h>
+#include <jrl-qp/internal/Workspace.h>
 
 namespace jrl::qp::structured
 {
+/** Block-structured constraint matrix C, with the constraints being C^T x.
+ *
+ * The variables are split into blocks x_0, ..., x_{N-1}, and the constraints into
+ * blocks c_0, ..., c_{N-1}. Block column j of C always has a diagonal block diag(j)
+ * acting on x_j. Depending on the type, it has additional blocks below:
+ *  - Diagonal: none.
+ *  - BlockBidiagonal: offDiag(j) acting on x_{j+1}, for j < N-1. This is typically
+ *    the case of constraints coupling consecutive stages, such as dynamics or rate
+ *    limits.
+ *  - Banded: subDiag(k,j) acting on x_{j+k}, for k = 1..b and j < N-k, where b is the
+ *    (block) bandwidth. BlockBidiagonal is the case b = 1.
+ */
 class JRLQP_DLLAPI StructuredC
 {
 public:
   enum class Type
   {
     Diagonal,
+    BlockBidiagonal,
+    Banded
   };
 
   StructuredC();
 
+  /** Block diagonal C.*/
   StructuredC(std::vector<MatrixConstRef> C);
+  /** Block diagonal (\p t = Diagonal, \p offDiag is empty) or lower block bidiagonal
+   * (\p t = BlockBidiagonal, offDiag[i] is the block below diag[i]) matrix.
+   */
+  StructuredC(Type t, const std::vector<MatrixConstRef> & diag, const std::vector<MatrixConstRef> & offDiag);
+  /** Lower block banded matrix, where subDiag[k-1][j] is the block (j+k, j).
+   * subDiag[k-1] must have diag.size()-k elements.
+   */
+  StructuredC(const std::vector<MatrixConstRef> & diag, const std::vector<std::vector<MatrixConstRef>> & subDiag);
 
+  /** Make this object refer to the same matrices as \p other, reusing the memory of the
+   * vectors if possible.*/
   StructuredC & operator=(const StructuredC & other);
 
+  Type type() const
+  {
+    return type_;
+  }
+
   const MatrixConstRef & diag(int i) const;
-  // const MatrixConstRef & offDiag(int i) const;
+  /** Block below diag(i), for BlockBidiagonal and Banded matrices.*/
+  const MatrixConstRef & offDiag(int i) const;
+  /** Block (i+k, i), for 1 <= k <= bandwidth().*/
+  const MatrixConstRef & subDiag(int k, int i) const;
+  /** Number of non-zero blocks below the diagonal blocks.*/
+  int bandwidth() const
+  {
+    return static_cast<int>(subDiag_.size());
+  }
+  /** Number of diagonal blocks.*/
+  int nbBlocks() const
+  {
+    return static_cast<int>(diag_.size());
+  }
   int nbVar() const;
   int nbVar(int i) const;
   int nbCstr() const;
   int nbCstr(int i) const;
+  /** Column \p i of C.
+   *
+   * For non-diagonal types, a column spans several blocks, that are gathered in an
+   * internal buffer. The returned vector is then only valid until the next call, and
+   * this function is not thread-safe, although const. Use the overload below for
+   * concurrent calls.
+   */
   internal::SingleNZSegmentVector col(int i) const;
+  /** Same as col(i), but gathering the blocks in \p work, resized if needed. The
+   * returned vector is valid as long as \p work is not modified.
+   */
+  internal::SingleNZSegmentVector col(int i, internal::Workspace<> & work) const;
 
+  /** out = C^T in*/
   void transposeMult(VectorRef out, const VectorConstRef & in) const;
 
   friend std::ostream & operator<<(std::ostream & os, const StructuredC & /*C*/)
@@ -43,13 +100,22 @@ public:
   }
 
 private:
+  /** Compute the cumulated sizes and the buffer used by col()*/
+  void init();
+  /** Index of the last block row of block column \p j.*/
+  int lastBlockRow(int j) const
+  {
+    return std::min(j + bandwidth(), static_cast<int>(diag_.size()) - 1);
+  }
+
   Type type_;
   std::vector<MatrixConstRef> diag_;
-  // std::vector<MatrixConstRef> offDiag_;
+  std::vector<std::vector<MatrixConstRef>> subDiag_; // subDiag_[k-1][j] is the block (j+k, j)
   std::vector<int> cumulNbVar_;
   std::vector<int> cumulNbCstr_;
   std::vector<int> toBlock_;
   int nbVar_;
   int nbCstr_;
+  mutable internal::Workspace<> work_col_;
 };
 } // namespace jrl::qp::structured
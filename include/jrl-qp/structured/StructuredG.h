@@ -6,11 +6,27 @@
 #include <vector>
 
 #include <jrl-qp/api.h>
+#include <jrl-qp/decomposition/triBlockDiagLLT.h>
 #include <jrl-qp/defs.h>
 #include <jrl-qp/internal/SingleNZSegmentVector.h>
+#include <jrl-qp/internal/Workspace.h>
 
 namespace jrl::qp::structured
 {
+/** Symmetric positive definite matrix with a sparsity structure given by its type:
+ *  - TriBlockDiagonal: diagonal blocks and the blocks offDiag(i) below diag(i),
+ *  - BlockArrowUp and BlockArrowDown: see decomposition::blockArrowLLT,
+ *  - BlockDiagonal: diagonal blocks only, offDiag is empty,
+ *  - Banded: scalar band of small bandwidth, given in lower band storage (see
+ * decomposition::bandLLT). The band is then seen as a single block diag(0) of size
+ * (bandwidth+1) x nbVar.
+ *  - DiagonalPlusLowRank: D + U U^T with D diagonal and U of size nbVar x k, k small
+ * (see decomposition::lowRankLLT). The diagonal of D is given as a single block diag(0)
+ * of size 1 x nbVar, and U as offDiag(0). Products with the inverse of the factor cost
+ * O(nbVar k), and no nbVar x nbVar matrix is formed. To keep BlockGISolver free of
+ * nbVar x nbVar storage as well, use BlockGISolver::compactionRatio(0) and
+ * BlockGISolver::reserveHint.
+ */
 class JRLQP_DLLAPI StructuredG
 {
 public:
@@ -18,11 +34,28 @@ public:
   {
     TriBlockDiagonal,
     BlockArrowUp,
-    BlockArrowDown
+    BlockArrowDown,
+    BlockDiagonal,
+    Banded,
+    DiagonalPlusLowRank
   };
 
   StructuredG() = default;
   StructuredG(Type t, const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & offDiag);
+  /** Banded matrix in lower band storage: band(i,j) = G(i+j,j). The bandwidth is
+   * band.rows()-1.
+   */
+  explicit StructuredG(const MatrixRef & band);
+  /** Matrix diag(d) + U U^T, where d is a 1 x nbVar matrix with positive elements.*/
+  StructuredG(const MatrixRef & d, const MatrixRef & U);
+
+  /** Make this object refer to the same matrices as \p other.
+   *
+   * The default copy assignment of std::vector<MatrixRef> would copy the data of the
+   * matrices referred to by other into the ones referred to by this object. The
+   * memory of the vectors is reused if possible.
+   */
+  StructuredG & operator=(const StructuredG & other);
 
   Type type() const
   {
@@ -39,6 +72,12 @@ public:
     return offDiag_[static_cast<size_t>(i)];
   }
 
+  /** Number of diagonal blocks.*/
+  int nbBlocks() const
+  {
+    return static_cast<int>(diag_.size());
+  }
+
   int nbVar() const
   {
     return nbVar_;
@@ -49,11 +88,86 @@ public:
     return static_cast<int>(diag(i).cols());
   }
 
+  /** Bandwidth of a Banded matrix.*/
+  int bandwidth() const
+  {
+    assert(type_ == Type::Banded);
+    return static_cast<int>(diag_[0].rows()) - 1;
+  }
+
+  /** Rank k of the low-rank term of a DiagonalPlusLowRank matrix.*/
+  int rank() const
+  {
+    assert(type_ == Type::DiagonalPlusLowRank);
+    return static_cast<int>(offDiag_[0].cols());
+  }
+
+  /** Use the threads of \p pool for the decomposition and the subsequent solves. With
+   * \c nullptr (default), the computations are sequential. \p pool must outlive this
+   * object.
+   *
+   * For TriBlockDiagonal, the factor is computed by decomposition::ParallelTriBlockDiagLLT
+   * and is not lower triangular anymore. Only L L^T = G is guaranteed.
+   */
+  void threadPool(internal::ThreadPool * pool)
+  {
+    pool_ = pool;
+  }
+
+  internal::ThreadPool * threadPool() const
+  {
+    return pool_;
+  }
+
   bool lltInPlace();
   bool decomposed() const
   {
     return decomposed_;
   }
+  /** Declare that the blocks contain an original matrix again, after new values were
+   * written directly into them. The next lltInPlace decomposes the new values.
+   */
+  void invalidateDecomposition()
+  {
+    decomposed_ = false;
+  }
+
+  /** If \p keep is \c true, the next calls to lltInPlace copy the blocks before
+   * overwriting them with the decomposition. This copy can then be modified by
+   * updateDiag and updateOffDiag, and the decomposition recomputed with refactorize.
+   */
+  void keepOriginal(bool keep);
+  bool keepOriginal() const
+  {
+    return keep_;
+  }
+
+  /** Change the diagonal block \p i of the original matrix to \p D.
+   * Requires keepOriginal(true) and a previous call to lltInPlace.
+   */
+  void updateDiag(int i, const MatrixConstRef & D);
+  /** Change the off-diagonal block \p i of the original matrix to \p S.
+   * Requires keepOriginal(true) and a previous call to lltInPlace.
+   */
+  void updateOffDiag(int i, const MatrixConstRef & S);
+
+  /** Recompute the decomposition after calls to updateDiag and updateOffDiag.
+   *
+   * Only the part of the decomposition depending on the changed blocks is recomputed:
+   *  - for TriBlockDiagonal, the blocks from the first changed one onward,
+   *  - for BlockArrowUp and BlockArrowDown, the changed blocks and the tip of the
+   * arrow. The contributions of the other blocks to the tip are not recomputed: the
+   * sum of the contributions is kept and updated by removing the previous
+   * contributions of the changed blocks and adding their new ones,
+   *  - for BlockDiagonal, the changed blocks,
+   *  - for Banded, the whole band (updateDiag(0, band) replaces the whole band),
+   *  - for DiagonalPlusLowRank, the whole decomposition.
+   *
+   * With a thread pool, the partial recomputation is done sequentially, except for
+   * TriBlockDiagonal where the whole decomposition is recomputed in parallel.
+   * If the last decomposition failed, the whole decomposition is recomputed as well.
+   */
+  bool refactorize();
 
   void solveInPlaceLTranspose(VectorRef v) const;
   void solveL(VectorRef out, const VectorConstRef & in) const;
@@ -66,6 +180,9 @@ public:
   }
 
 private:
+  /** Decomposition of the matrix currently stored in the blocks.*/
+  bool decompose();
+
   Type type_;
   std::vector<MatrixRef> diag_;
   std::vector<MatrixRef> offDiag_;
@@ -73,5 +190,20 @@ private:
   int nbVar_ = 0;
 
   bool decomposed_ = false; // Whether this contains the original matrix or its llt decomposition
+
+  internal::ThreadPool * pool_ = nullptr;
+  bool parallel_ = false; // Whether the decomposition was done in parallel
+  decomposition::ParallelTriBlockDiagLLT parallelTri_;
+  mutable internal::Workspace<> work_;
+
+  bool keep_ = false;
+  std::vector<Eigen::MatrixXd> origDiag_;
+  std::vector<Eigen::MatrixXd> origOffDiag_;
+  /** changed_[i] is true if block i needs to be decomposed again.*/
+  std::vector<bool> changed_;
+  /** For the arrows, sum of the contributions of all the other blocks to the tip.*/
+  Eigen::MatrixXd tipUpdate_;
+  /** For DiagonalPlusLowRank, scaling S of the factor (see decomposition::lowRankLLT).*/
+  Eigen::VectorXd lowRankScale_;
 };
 } // namespace jrl::qp::structured
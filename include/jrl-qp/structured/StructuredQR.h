@@ -22,12 +22,21 @@ public:
 
   void reset();
   void resize(int nbVar);
+  /** Number of active constraints for which the next calls to resize preallocate R and
+   * Q. A negative value (default) means nbVar.*/
+  void reserveHint(int nbActive);
+  /** Compaction threshold of Q, see internal::OrthonormalSequence::compactionRatio.*/
+  void compactionRatio(double r);
 
   internal::PartitionnedQ getPartitionnedQ() const;
 
   void setRToZero();
   void RSolve(VectorRef out, const VectorConstRef & in) const;
+  void RTransposeSolve(VectorRef out, const VectorConstRef & in) const;
 
+  /** Add the column \p d (expressed in the current basis Q) to the decomposition.
+   * Return false and leave the decomposition unchanged if \p d is linearly dependent on
+   * the current columns.*/
   bool add(const VectorConstRef & d);
   bool remove(int l);
 
@@ -40,6 +49,7 @@ private:
   int q_ = 0; // size of R (that is the number of active constraints)
   int nbVar_ = 0;
   mutable int ldR_ = 1; // Leading dimension used for R
+  int reserveHint_ = -1;
   mutable internal::Workspace<> work_R_;
   internal::Workspace<> work_essential_;
   internal::OrthonormalSequence Q_;
@@ -0,0 +1,45 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <jrl-qp/api.h>
+#include <jrl-qp/test/problems.h>
+
+namespace jrl::qp::test
+{
+/** Linear-quadratic optimal control problem in the form used by
+ * experimental::RiccatiSolver, with the matrices owned by the structure.
+ */
+struct JRLQP_DLLAPI OptimalControlProblem
+{
+  /** Same problem as a QPProblem, with the dynamics and the initial state as equality
+   * constraints. The constraint matrix is given transposed (C^T y), with the initial
+   * state constraint first, then for each stage the dynamics followed by the stage
+   * constraints.
+   */
+  QPProblem<> toDense() const;
+
+  int nx;
+  int nu;
+  int N;
+  std::vector<Eigen::MatrixXd> H;
+  Eigen::VectorXd a;
+  std::vector<Eigen::MatrixXd> F;
+  Eigen::VectorXd c;
+  Eigen::VectorXd x0;
+  std::vector<Eigen::MatrixXd> C;
+  Eigen::VectorXd bl;
+  Eigen::VectorXd bu;
+  Eigen::VectorXd xl;
+  Eigen::VectorXd xu;
+};
+
+/** Generate a random feasible problem with \p N stages, states of size \p nx, controls
+ * of size \p nu and \p m general constraints per stage. Bounds on all the variables
+ * are added if \p useBounds is \c true.
+ */
+JRLQP_DLLAPI OptimalControlProblem randomOptimalControlProblem(int nx, int nu, int N, int m, bool useBounds);
+} // namespace jrl::qp::test
@@ -115,7 +115,8 @@ inline QPProblem<Separated>::QPProblem(const LeastSquareProblem<LSSeparated> & l
 }
 
 template<bool Separated>
-inline QPProblem<Separated>::QPProblem(const QPProblem<!Separated> & qp) : Base(qp), G(qp.G), a(qp.a)
+inline QPProblem<Separated>::QPProblem(const QPProblem<!Separated> & qp)
+: Base(qp), G(qp.G), a(qp.a), objCst(qp.objCst)
 {
 }
 
@@ -0,0 +1,62 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/decomposition/bandLLT.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace jrl::qp::decomposition
+{
+bool bandLLT(MatrixRef band, int start)
+{
+  // Left-looking variant: the column j of L is computed from the column j of A and the
+  // previous columns of L, so that the decomposition can be resumed at any column.
+  const int k = static_cast<int>(band.rows()) - 1;
+  const int n = static_cast<int>(band.cols());
+  for(int j = start; j < n; ++j)
+  {
+    int m = std::min(k, n - 1 - j) + 1; // Number of non-zero elements of column j
+    auto c = band.col(j).head(m);
+    // L(j:j+m, j) = A(j:j+m, j) - sum_p L(j:j+m, p) L(j, p), with L(j+i, p) = band(j+i-p, p)
+    for(int p = std::max(0, j - k); p < j; ++p)
+    {
+      int d = j - p;
+      int r = std::min(m, k + 1 - d);
+      c.head(r) -= band(d, p) * band.col(p).segment(d, r);
+    }
+    double ljj = c[0];
+    if(!(ljj > 0)) return false;
+    ljj = std::sqrt(ljj);
+    c[0] = ljj;
+    c.tail(m - 1) /= ljj;
+  }
+  return true;
+}
+
+void bandLSolve(const MatrixConstRef & band, MatrixRef M, int start)
+{
+  const int k = static_cast<int>(band.rows()) - 1;
+  const int n = static_cast<int>(band.cols());
+  assert(M.rows() == n);
+  for(int j = start; j < n; ++j)
+  {
+    int m = std::min(k, n - 1 - j);
+    M.row(j) /= band(0, j);
+    M.middleRows(j + 1, m).noalias() -= band.col(j).segment(1, m) * M.row(j);
+  }
+}
+
+void bandLTransposeSolve(const MatrixConstRef & band, MatrixRef M, int end)
+{
+  const int k = static_cast<int>(band.rows()) - 1;
+  const int n = static_cast<int>(band.cols());
+  assert(M.rows() == n);
+  if(end < 0) end = n;
+  for(int j = end - 1; j >= 0; --j)
+  {
+    int m = std::min(k, end - 1 - j);
+    M.row(j).noalias() -= band.col(j).segment(1, m).transpose() * M.middleRows(j + 1, m);
+    M.row(j) /= band(0, j);
+  }
+}
+} // namespace jrl::qp::decomposition
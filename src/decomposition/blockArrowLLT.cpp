@@ -2,10 +2,13 @@
 
 #include <jrl-qp/decomposition/blockArrowLLT.h>
 
-#include <Eigen/Cholesky>
-
+#include <algorithm>
+#include <atomic>
 #include <numeric>
 
+#include <jrl-qp/internal/ThreadPool.h>
+#include <jrl-qp/internal/blockKernels.h>
+
 namespace
 {
 using namespace jrl::qp;
@@ -45,47 +48,114 @@ struct get<true>
     return side[i].transpose();
   }
 };
+
+using PartialMap = Eigen::Map<Eigen::MatrixXd, 0, Eigen::OuterStride<>>;
+
+/** The b-1 first blocks are split in groups of consecutive blocks, one group per task.
+ * Without \p pool, there is a single group.
+ */
+int nbGroups(const internal::ThreadPool * pool, int b)
+{
+  return pool ? std::max(1, std::min(pool->size(), b - 1)) : 1;
+}
+
+/** Index of the first block of group j.*/
+int firstBlock(int j, int g, int b)
+{
+  return j * (b - 1) / g;
+}
+
+/** Run f(j) for each group j, in parallel if pool is not null.*/
+template<typename F>
+void forEachGroup(internal::ThreadPool * pool, int g, F && f)
+{
+  if(g > 1)
+    pool->parallelFor(g, f);
+  else
+    f(0);
+}
 } // namespace
 
 namespace jrl::qp::decomposition
 {
 template<bool Up>
-bool blockArrowLLT_(const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & side)
+bool blockArrowLLT_(const std::vector<MatrixRef> & diag,
+                    const std::vector<MatrixRef> & side,
+                    internal::ThreadPool * pool,
+                    internal::Workspace<> * work)
 {
   assert(diag.size() == side.size() + 1);
 
   int b = static_cast<int>(diag.size());
   auto Db = get<Up>::D(diag, b - 1);
+  int nb = static_cast<int>(Db.rows());
+
+  // The factorizations of the blocks i < b are independent. Each group of blocks
+  // accumulates its contribution sum Bi Bi^T to Db in its own nb x nb matrix. The first
+  // group works directly on Db.
+  int g = nbGroups(pool, b);
+  if(g > 1) work->resize((g - 1) * nb * nb);
+  std::atomic<bool> ok = true;
+
+  forEachGroup(pool, g, [&](int j) {
+    double * data = j == 0 ? Db.data() : work->asVector((g - 1) * nb * nb, {}).data() + (j - 1) * nb * nb;
+    PartialMap P(data, nb, nb, Eigen::OuterStride<>(j == 0 ? Db.outerStride() : nb));
+    if(j > 0) P.template triangularView<Eigen::Lower>().setZero();
+
+    for(int i = firstBlock(j, g, b); i < firstBlock(j + 1, g, b) && ok; ++i)
+    {
+      // Li = chol(Di)
+      auto Di = get<Up>::D(diag, i);
+      if(!internal::blockLLT(Di))
+      {
+        ok = false;
+        return;
+      }
+
+      // Bi = Bi*Li^-T, and Db -= Bi Bi^T
+      if constexpr(Up)
+      {
+        internal::blockSolveLLeft(Di, side[i]);
+        internal::blockRankUpdateTranspose(P, side[i]);
+      }
+      else
+      {
+        internal::blockSolveLTransposeRight(Di, side[i]);
+        internal::blockRankUpdate(P, side[i]);
+      }
+    }
+  });
+  if(!ok) return false;
 
-  for(int i = 0; i < b - 1; ++i)
+  for(int j = 1; j < g; ++j)
   {
-    // Li = chol(Di)
-    auto Di = get<Up>::D(diag, i);
-    auto ret = Eigen::internal::llt_inplace<double, Eigen::Lower>::blocked(Di);
-    if(ret > 0) return false;
-
-    // Bi = Bi*Li^-T
-    auto Li = Di.template triangularView<Eigen::Lower>();
-    if constexpr(Up)
-      Li.template solveInPlace<Eigen::OnTheLeft>(side[i]);
-    else
-      Li.transpose().template solveInPlace<Eigen::OnTheRight>(side[i]);
-
-    // Db -= Bi Bi^T
-    Db.template selfadjointView<Eigen::Lower>().rankUpdate(get<Up>::B(side, i), -1.);
+    // Only the lower part of the partial sums is computed, and only this part is read.
+    Db.template triangularView<Eigen::Lower>() +=
+        PartialMap(work->asVector((g - 1) * nb * nb, {}).data() + (j - 1) * nb * nb, nb, nb, Eigen::OuterStride<>(nb));
   }
-  // Lb = chol(Db)
-  auto ret = Eigen::internal::llt_inplace<double, Eigen::Lower>::blocked(Db);
 
-  return ret <= 0;
+  // Lb = chol(Db)
+  return internal::blockLLT(Db);
 }
 
 bool blockArrowLLT(const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & side, bool up)
 {
   if(up)
-    return blockArrowLLT_<true>(diag, side);
+    return blockArrowLLT_<true>(diag, side, nullptr, nullptr);
+  else
+    return blockArrowLLT_<false>(diag, side, nullptr, nullptr);
+}
+
+bool blockArrowLLT(const std::vector<MatrixRef> & diag,
+                   const std::vector<MatrixRef> & side,
+                   bool up,
+                   internal::ThreadPool & pool,
+                   internal::Workspace<> & work)
+{
+  if(up)
+    return blockArrowLLT_<true>(diag, side, &pool, &work);
   else
-    return blockArrowLLT_<false>(diag, side);
+    return blockArrowLLT_<false>(diag, side, &pool, &work);
 }
 
 template<bool Up>
@@ -93,7 +163,9 @@ void blockArrowLSolve_(const std::vector<MatrixRef> & diag,
                        const std::vector<MatrixRef> & side,
                        MatrixRef M,
                        int start,
-                       int end)
+                       int end,
+                       internal::ThreadPool * pool,
+                       internal::Workspace<> * work)
 {
   // | L1   0  ...  0 | | X1 |   | M1 |
   // |  0  L2  ...  0 | | X2 | = | M2 |
@@ -109,78 +181,128 @@ void blockArrowLSolve_(const std::vector<MatrixRef> & diag,
   //
   // The helper struct get<Up> allows to abstract the way the matrix L is represented
   // by diag and side, so that we can write the same code for Up = true or Up = false.
+  //
+  // The solves for i<b are independent. Each group of blocks accumulates its
+  // contribution - sum Bi Xi to Mb in its own matrix, the first group working directly
+  // on Mb.
 
   assert(diag.size() == side.size() + 1);
 
   int b = static_cast<int>(diag.size());
-  int n = 0;
+  auto Db = get<Up>::D(diag, b - 1);
+  assert(Db.rows() == Db.cols());
+  int nb = static_cast<int>(Db.rows());
+  int nc = static_cast<int>(M.cols());
+  int nt = static_cast<int>(M.rows()) - nb; // First row of Mb
+
+  int g = nbGroups(pool, b);
+  if(g > 1) work->resize((g - 1) * nb * nc);
+
+  forEachGroup(pool, g, [&](int j) {
+    auto Mb = M.bottomRows(nb);
+    double * data = j == 0 ? Mb.data() : work->asVector((g - 1) * nb * nc, {}).data() + (j - 1) * nb * nc;
+    PartialMap P(data, nb, nc, Eigen::OuterStride<>(j == 0 ? Mb.outerStride() : nb));
+    if(j > 0) P.setZero();
+
+    int i0 = firstBlock(j, g, b);
+    int n = 0;
+    for(int i = 0; i < i0; ++i) n += static_cast<int>(get<Up>::D(diag, i).rows());
+    for(int i = i0; i < firstBlock(j + 1, g, b); ++i)
+    {
+      auto Di = get<Up>::D(diag, i);
+      assert(Di.rows() == Di.cols());
+      int ni = static_cast<int>(Di.rows());
 
-  //[OPTIM] All solveInplace can be parallelized. Aggregation into Mb cannot be directly
-  // parallelized in the loop, but something akin to prefix sum could be used.
-  for(int i = 0; i < b - 1; ++i)
-  {
-    auto Di = get<Up>::D(diag, i);
-    assert(Di.rows() == Di.cols());
-    int ni = static_cast<int>(Di.rows());
+      int s = std::max(start - n, 0); // first non-zero row in Mi
+      if((ni < s || end <= n))
+      {
+        // If Mi is zero we don't have to perform any operations.
+        assert(M.middleRows(n, ni).isZero());
+        n += ni;
+        continue;
+      }
 
-    int s = std::max(start - n, 0); // first non-zero row in Mi
-    if((ni < s || end <= n))
-    {
-      // If Mi is zero we don't have to perform any operations.
-      assert(M.middleRows(n, ni).isZero());
+      // We ignore the first rows of Mi that are 0, if any.
+      auto Li = Di.bottomRightCorner(ni - s, ni - s).template triangularView<Eigen::Lower>();
+      auto Mi = M.middleRows(n + s, ni - s);
+      // Mi = Li^-1 Mi
+      Li.solveInPlace(Mi);
+      // Mb = Mb - Bi * Mi
+      P.noalias() -= get<Up>::B(side, i).middleCols(s, ni - s) * Mi;
       n += ni;
-      continue;
     }
+  });
 
-    // We ignore the first rows of Mi that are 0, if any.
-    auto Li = Di.bottomRightCorner(ni - s, ni - s).template triangularView<Eigen::Lower>();
-    auto Mi = M.middleRows(n + s, ni - s);
-    // Mi = Li^-1 Mi
-    Li.solveInPlace(Mi);
-    // Mb = Mb - Bi * Mi
-    M.bottomRows(diag.back().rows()).noalias() -= get<Up>::B(side, i).middleCols(s, ni - s) * Mi;
-    n += ni;
+  auto Mb = M.middleRows(nt, nb);
+  for(int j = 1; j < g; ++j)
+  {
+    Mb += PartialMap(work->asVector((g - 1) * nb * nc, {}).data() + (j - 1) * nb * nc, nb, nc,
+                     Eigen::OuterStride<>(nb));
   }
-  auto Db = get<Up>::D(diag, b - 1);
-  assert(Db.rows() == Db.cols());
-  int nb = static_cast<int>(Db.rows());
   // It could be possible to be more refined here, by tracking the first and last non-zero row in Mb.
   auto Lb = Db.template triangularView<Eigen::Lower>();
-  auto Mb = M.middleRows(n, nb);
   // Mb = Lb^-1 Mb
   Lb.solveInPlace(Mb);
 }
 
-void blockArrowLSolve(const std::vector<MatrixRef> & diag,
-                      const std::vector<MatrixRef> & side,
-                      bool up,
-                      MatrixRef v,
-                      int start,
-                      int end)
+void blockArrowLSolveImpl(const std::vector<MatrixRef> & diag,
+                          const std::vector<MatrixRef> & side,
+                          bool up,
+                          MatrixRef v,
+                          int start,
+                          int end,
+                          internal::ThreadPool * pool,
+                          internal::Workspace<> * work)
 {
   if(end < 0) end = static_cast<int>(v.rows());
 
   if(up)
   {
-    Eigen::MatrixXd tmp = v;
+    // Move the first n0 rows at the bottom. This is done column by column, in place, to
+    // avoid a temporary copy of v.
     int n0 = static_cast<int>(diag.front().rows());
-    auto s = v.rows() - n0;
-    v.topRows(s) = tmp.bottomRows(s);
-    v.bottomRows(n0) = tmp.topRows(n0);
-    blockArrowLSolve_<true>(diag, side, v, std::max(0, start - n0), std::max(0, end - n0));
+    for(Eigen::Index j = 0; j < v.cols(); ++j)
+    {
+      double * c = v.col(j).data();
+      std::rotate(c, c + n0, c + v.rows());
+    }
+    blockArrowLSolve_<true>(diag, side, v, std::max(0, start - n0), std::max(0, end - n0), pool, work);
   }
   else
   {
-    blockArrowLSolve_<false>(diag, side, v, start, end);
+    blockArrowLSolve_<false>(diag, side, v, start, end, pool, work);
   }
 }
 
+void blockArrowLSolve(const std::vector<MatrixRef> & diag,
+                      const std::vector<MatrixRef> & side,
+                      bool up,
+                      MatrixRef v,
+                      int start,
+                      int end)
+{
+  blockArrowLSolveImpl(diag, side, up, v, start, end, nullptr, nullptr);
+}
+
+void blockArrowLSolve(const std::vector<MatrixRef> & diag,
+                      const std::vector<MatrixRef> & side,
+                      bool up,
+                      MatrixRef v,
+                      internal::ThreadPool & pool,
+                      internal::Workspace<> & work,
+                      int start,
+                      int end)
+{
+  blockArrowLSolveImpl(diag, side, up, v, start, end, &pool, &work);
+}
+
 template<bool Up>
 void blockArrowLTransposeSolve_(const std::vector<MatrixRef> & diag,
                                 const std::vector<MatrixRef> & side,
                                 MatrixRef M,
                                 int start,
-                                int end)
+                                int end,
+                                internal::ThreadPool * pool)
 {
   // | L1^T   0     ...     B1^T  | |   X1   |   |   M1   |
   // |   0   ...             ...  | |  ...   | = |   ...  |
@@ -196,6 +318,8 @@ void blockArrowLTransposeSolve_(const std::vector<MatrixRef> & diag,
   //
   // The helper struct get<Up> allows to abstract the way the matrix L is represented
   // by diag and side, so that we can write the same code for Up = true or Up = false.
+  //
+  // Once Xb is computed, the solves for i<b are independent and are run by groups.
 
   int b = static_cast<int>(diag.size());
   int s = static_cast<int>(M.rows());
@@ -213,67 +337,95 @@ void blockArrowLTransposeSolve_(const std::vector<MatrixRef> & diag,
   else
     zero = true;
 
-  int n = 0;
-  //[OPTIM] This loop can be fully parallelized
-  for(int i = 0; i < b - 1; ++i)
-  {
-    auto Di = get<Up>::D(diag, i);
-    assert(Di.rows() == Di.cols());
-    int ni = static_cast<int>(Di.rows());
-
-    auto Mi = M.middleRows(n, ni);
-    if(zero) // Mb is zero
+  int g = nbGroups(pool, b);
+  forEachGroup(pool, g, [&](int j) {
+    int i0 = firstBlock(j, g, b);
+    int n = 0;
+    for(int i = 0; i < i0; ++i) n += static_cast<int>(get<Up>::D(diag, i).rows());
+    for(int i = i0; i < firstBlock(j + 1, g, b); ++i)
     {
-      if(start >= n + ni) // Mi is zero
-      {
-        n += ni;
-        continue; // rhs is zero, no need to perform the inversion
-      }
-    }
-    else
-      Mi.noalias() -= get<Up>::B(side, i).transpose() * Mb;
+      auto Di = get<Up>::D(diag, i);
+      assert(Di.rows() == Di.cols());
+      int ni = static_cast<int>(Di.rows());
 
-    if(end >= n) // if not, we know that both Mb and Mi are zero
-    {
-      if(end >= n + ni)
+      auto Mi = M.middleRows(n, ni);
+      if(zero) // Mb is zero
       {
-        auto Li = Di.template triangularView<Eigen::Lower>();
-        Li.transpose().solveInPlace(Mi);
+        if(start >= n + ni) // Mi is zero
+        {
+          n += ni;
+          continue; // rhs is zero, no need to perform the inversion
+        }
       }
       else
+        Mi.noalias() -= get<Up>::B(side, i).transpose() * Mb;
+
+      if(end >= n) // if not, we know that both Mb and Mi are zero
       {
-        assert(zero);
-        int r = end - n;
-        auto Li = Di.topLeftCorner(r, r).template triangularView<Eigen::Lower>();
-        Li.transpose().solveInPlace(Mi.topRows(r));
+        if(end >= n + ni)
+        {
+          auto Li = Di.template triangularView<Eigen::Lower>();
+          Li.transpose().solveInPlace(Mi);
+        }
+        else
+        {
+          assert(zero);
+          int r = end - n;
+          auto Li = Di.topLeftCorner(r, r).template triangularView<Eigen::Lower>();
+          Li.transpose().solveInPlace(Mi.topRows(r));
+        }
       }
+      n += ni;
     }
-    n += ni;
-  }
+  });
 }
 
-void blockArrowLTransposeSolve(const std::vector<MatrixRef> & diag,
-                               const std::vector<MatrixRef> & side,
-                               bool up,
-                               MatrixRef v,
-                               int start,
-                               int end)
+void blockArrowLTransposeSolveImpl(const std::vector<MatrixRef> & diag,
+                                   const std::vector<MatrixRef> & side,
+                                   bool up,
+                                   MatrixRef v,
+                                   int start,
+                                   int end,
+                                   internal::ThreadPool * pool)
 {
   if(end < 0) end = static_cast<int>(v.rows());
 
   if(up)
   {
-    blockArrowLTransposeSolve_<true>(diag, side, v, start, end);
-    Eigen::MatrixXd tmp = v;
+    blockArrowLTransposeSolve_<true>(diag, side, v, start, end, pool);
+    // Move the last n0 rows back at the top.
     int n0 = static_cast<int>(diag.front().rows());
-    auto s = v.rows() - n0;
-    v.bottomRows(s) = tmp.topRows(s);
-    v.topRows(n0) = tmp.bottomRows(n0);
+    for(Eigen::Index j = 0; j < v.cols(); ++j)
+    {
+      double * c = v.col(j).data();
+      std::rotate(c, c + v.rows() - n0, c + v.rows());
+    }
   }
   else
   {
-    blockArrowLTransposeSolve_<false>(diag, side, v, start, end);
+    blockArrowLTransposeSolve_<false>(diag, side, v, start, end, pool);
   }
 }
 
+void blockArrowLTransposeSolve(const std::vector<MatrixRef> & diag,
+                               const std::vector<MatrixRef> & side,
+                               bool up,
+                               MatrixRef v,
+                               int start,
+                               int end)
+{
+  blockArrowLTransposeSolveImpl(diag, side, up, v, start, end, nullptr);
+}
+
+void blockArrowLTransposeSolve(const std::vector<MatrixRef> & diag,
+                               const std::vector<MatrixRef> & side,
+                               bool up,
+                               MatrixRef v,
+                               internal::ThreadPool & pool,
+                               int start,
+                               int end)
+{
+  blockArrowLTransposeSolveImpl(diag, side, up, v, start, end, &pool);
+}
+
 } // namespace jrl::qp::decomposition
@@ -0,0 +1,139 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/decomposition/blockDiagLLT.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <jrl-qp/internal/ThreadPool.h>
+#include <jrl-qp/internal/blockKernels.h>
+
+namespace
+{
+using namespace jrl::qp;
+
+/** Range [first, last) of blocks intersecting the rows [start, end) of M, and index of
+ * the first row of block first.
+ */
+struct BlockRange
+{
+  BlockRange(const std::vector<MatrixRef> & diag, const MatrixRef & M, int start, int end)
+  {
+    int b = static_cast<int>(diag.size());
+    if(end < 0) end = static_cast<int>(M.rows());
+    first = 0;
+    row = 0;
+    while(first < b && row + diag[static_cast<size_t>(first)].rows() <= start)
+    {
+      row += static_cast<int>(diag[static_cast<size_t>(first)].rows());
+      ++first;
+    }
+    last = first;
+    int r = row;
+    while(last < b && r < end)
+    {
+      r += static_cast<int>(diag[static_cast<size_t>(last)].rows());
+      ++last;
+    }
+  }
+
+  int first;
+  int last;
+  int row;
+};
+
+/** Call f(i, row) for each block i of r, row being the first row of the block. With
+ * \p pool, the blocks are split in groups of consecutive blocks, one per thread.
+ */
+template<typename F>
+void forEachBlock(const std::vector<MatrixRef> & diag, const BlockRange & r, internal::ThreadPool * pool, F && f)
+{
+  auto group = [&](int first, int last, int row) {
+    for(int i = first; i < last; ++i)
+    {
+      f(i, row);
+      row += static_cast<int>(diag[static_cast<size_t>(i)].rows());
+    }
+  };
+
+  int n = r.last - r.first;
+  int g = pool ? std::max(1, std::min(pool->size(), n)) : 1;
+  if(g > 1)
+  {
+    pool->parallelFor(g, [&](int j) {
+      int first = r.first + j * n / g;
+      int last = r.first + (j + 1) * n / g;
+      int row = r.row;
+      for(int i = r.first; i < first; ++i) row += static_cast<int>(diag[static_cast<size_t>(i)].rows());
+      group(first, last, row);
+    });
+  }
+  else
+    group(r.first, r.last, r.row);
+}
+} // namespace
+
+namespace jrl::qp::decomposition
+{
+bool blockDiagLLT(const std::vector<MatrixRef> & diag, int start)
+{
+  for(size_t i = static_cast<size_t>(start); i < diag.size(); ++i)
+  {
+    if(!internal::blockLLT(diag[i])) return false;
+  }
+  return true;
+}
+
+bool blockDiagLLT(const std::vector<MatrixRef> & diag, internal::ThreadPool & pool)
+{
+  std::atomic<bool> ok = true;
+  pool.parallelFor(static_cast<int>(diag.size()), [&](int i) {
+    if(!internal::blockLLT(diag[static_cast<size_t>(i)])) ok = false;
+  });
+  return ok;
+}
+
+void blockDiagLSolve(const std::vector<MatrixRef> & diag, MatrixRef M, int start, int end)
+{
+  BlockRange r(diag, M, start, end);
+  forEachBlock(diag, r, nullptr, [&](int i, int row) {
+    const auto & L = diag[static_cast<size_t>(i)];
+    L.triangularView<Eigen::Lower>().solveInPlace(M.middleRows(row, L.rows()));
+  });
+}
+
+void blockDiagLSolve(const std::vector<MatrixRef> & diag,
+                     MatrixRef M,
+                     internal::ThreadPool & pool,
+                     int start,
+                     int end)
+{
+  BlockRange r(diag, M, start, end);
+  forEachBlock(diag, r, &pool, [&](int i, int row) {
+    const auto & L = diag[static_cast<size_t>(i)];
+    L.triangularView<Eigen::Lower>().solveInPlace(M.middleRows(row, L.rows()));
+  });
+}
+
+void blockDiagLTransposeSolve(const std::vector<MatrixRef> & diag, MatrixRef M, int start, int end)
+{
+  BlockRange r(diag, M, start, end);
+  forEachBlock(diag, r, nullptr, [&](int i, int row) {
+    const auto & L = diag[static_cast<size_t>(i)];
+    L.transpose().triangularView<Eigen::Upper>().solveInPlace(M.middleRows(row, L.rows()));
+  });
+}
+
+void blockDiagLTransposeSolve(const std::vector<MatrixRef> & diag,
+                              MatrixRef M,
+                              internal::ThreadPool & pool,
+                              int start,
+                              int end)
+{
+  BlockRange r(diag, M, start, end);
+  forEachBlock(diag, r, &pool, [&](int i, int row) {
+    const auto & L = diag[static_cast<size_t>(i)];
+    L.transpose().triangularView<Eigen::Upper>().solveInPlace(M.middleRows(row, L.rows()));
+  });
+}
+} // namespace jrl::qp::decomposition
@@ -0,0 +1,104 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/decomposition/lowRankLLT.h>
+
+#include <Eigen/Eigenvalues>
+#include <Eigen/QR>
+
+namespace
+{
+using namespace jrl::qp;
+
+/** M = F^-1 M, with F = I + Z diag(s) Z^T.*/
+void applyFInverse(const MatrixConstRef & Z, const VectorConstRef & s, MatrixRef M, MatrixRef work)
+{
+  // F^-1 = I + Z diag(t) Z^T with t = 1/(1+s) - 1 = -s/(1+s)
+  work.noalias() = Z.transpose() * M;
+  for(int i = 0; i < s.size(); ++i) work.row(i) *= -s[i] / (1 + s[i]);
+  M.noalias() += Z * work;
+}
+} // namespace
+
+namespace jrl::qp::decomposition
+{
+bool lowRankLLT(MatrixRef d, MatrixRef U, VectorRef s, internal::Workspace<> & work)
+{
+  const int n = static_cast<int>(U.rows());
+  const int k = static_cast<int>(U.cols());
+  assert(d.rows() == 1 && d.cols() == n);
+  assert(s.size() == k && k <= n);
+
+  if(!(d.array() > 0).all()) return false;
+  d = d.cwiseSqrt();
+  if(k == 0) return true;
+
+  // Two k x k matrices and 5 vectors of size k, see below.
+  work.resize(2 * k * k + 5 * k);
+  double * w = work.asVector(work.size(), {}).data();
+  Eigen::Map<Eigen::MatrixXd> E(w, k, k);
+  Eigen::Map<Eigen::MatrixXd> T(w + k * k, k, k);
+  Eigen::Map<Eigen::VectorXd> hQR(w + 2 * k * k, k);
+  Eigen::Map<Eigen::VectorXd> tmp(w + 2 * k * k + k, k);
+  Eigen::Map<Eigen::VectorXd> hTri(w + 2 * k * k + 2 * k, k - 1);
+  Eigen::Map<Eigen::VectorXd> lambda(w + 2 * k * k + 3 * k, k);
+  Eigen::Map<Eigen::VectorXd> subDiag(w + 2 * k * k + 4 * k, k - 1);
+
+  // V = D^-1/2 U = Q R, and V V^T = (Q E) Lambda (Q E)^T with R R^T = E Lambda E^T
+  U = d.row(0).cwiseInverse().asDiagonal() * U;
+  Eigen::internal::householder_qr_inplace_unblocked(U, hQR, tmp.data());
+  E = U.topRows(k).triangularView<Eigen::Upper>();
+  T.noalias() = E * E.transpose();
+
+  // Eigendecomposition of R R^T, done by hand rather than with SelfAdjointEigenSolver
+  // so as to work in the workspace only: R R^T = H T H^T with T tridiagonal, then
+  // T = E_T Lambda E_T^T and E = H E_T.
+  Eigen::internal::tridiagonalization_inplace(T, hTri);
+  lambda = T.diagonal();
+  subDiag = T.diagonal<-1>();
+  E.setIdentity();
+  auto info = Eigen::internal::computeFromTridiagonal_impl(lambda, subDiag, 30 * k, true, E);
+  if(info != Eigen::Success) return false;
+  for(int i = k - 2; i >= 0; --i)
+    E.bottomRows(k - i - 1).applyHouseholderOnTheLeft(T.col(i).tail(k - i - 2), hTri[i], tmp.data());
+
+  // U <- Q [I; 0], in place, by applying the Householder reflectors backward
+  for(int j = k - 1; j >= 0; --j)
+  {
+    if(j < k - 1)
+      U.bottomRightCorner(n - j, k - j - 1).applyHouseholderOnTheLeft(U.col(j).tail(n - j - 1), hQR[j], tmp.data());
+    U.col(j).tail(n - j - 1) *= -hQR[j];
+    U(j, j) = 1 - hQR[j];
+    U.col(j).head(j).setZero();
+  }
+  // Z = Q [E; 0] = U E, row by row
+  for(int i = 0; i < n; ++i)
+  {
+    tmp.transpose().noalias() = U.row(i) * E;
+    U.row(i) = tmp.transpose();
+  }
+  s = (1 + lambda.array().max(0)).sqrt() - 1;
+  return true;
+}
+
+void lowRankLSolve(const MatrixConstRef & d,
+                   const MatrixConstRef & Z,
+                   const VectorConstRef & s,
+                   MatrixRef M,
+                   MatrixRef work)
+{
+  // L^-1 = F^-1 D^-1/2
+  M.array().colwise() /= d.row(0).transpose().array();
+  applyFInverse(Z, s, M, work);
+}
+
+void lowRankLTransposeSolve(const MatrixConstRef & d,
+                            const MatrixConstRef & Z,
+                            const VectorConstRef & s,
+                            MatrixRef M,
+                            MatrixRef work)
+{
+  // L^-T = D^-1/2 F^-1
+  applyFInverse(Z, s, M, work);
+  M.array().colwise() /= d.row(0).transpose().array();
+}
+} // namespace jrl::qp::decomposition
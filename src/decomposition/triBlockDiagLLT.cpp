@@ -2,42 +2,38 @@
 
 #include <jrl-qp/decomposition/triBlockDiagLLT.h>
 
-#include <Eigen/Cholesky>
+#include <algorithm>
+#include <atomic>
 
-namespace jrl::qp::decomposition
-{
-bool triBlockDiagLLT(const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & subDiag)
+#include <jrl-qp/internal/ThreadPool.h>
+#include <jrl-qp/internal/blockKernels.h>
+
+namespace
 {
-  assert(diag.size() == subDiag.size() + 1);
+using namespace jrl::qp;
 
-  size_t b = diag.size();
-  for(size_t i = 0; i < b - 1; ++i)
+// The functions below work on the b blocks diag[0..b-1] and subDiag[0..b-2], so that
+// they can be used on a subset of the blocks without copying the std::vector.
+
+bool llt(const MatrixRef * diag, const MatrixRef * subDiag, int b, int start = 0)
+{
+  // Blocks before start already contain the factor
+  for(int i = std::max(start - 1, 0); i < b - 1; ++i)
   {
     // Li = chol(Di)
-    auto Di = diag[i];
-    auto ret = Eigen::internal::llt_inplace<double, Eigen::Lower>::blocked(Di);
-    if(ret > 0) return false;
+    if(i >= start && !internal::blockLLT(diag[i])) return false;
 
     // Si = Si*Li^-T
-    auto Li = Di.template triangularView<Eigen::Lower>();
-    Li.transpose().template solveInPlace<Eigen::OnTheRight>(subDiag[i]);
+    internal::blockSolveLTransposeRight(diag[i], subDiag[i]);
 
     // D[i+1] -= Si Si^T
-    auto Di1 = diag[i + 1];
-    Di1.template selfadjointView<Eigen::Lower>().rankUpdate(subDiag[i], -1.);
+    internal::blockRankUpdate(diag[i + 1], subDiag[i]);
   }
   // Lb = chol(Db)
-  auto Db = diag.back();
-  auto ret = Eigen::internal::llt_inplace<double, Eigen::Lower>::blocked(Db);
-  if(ret > 0) return false;
-
-  return true;
+  return internal::blockLLT(diag[b - 1]);
 }
 
-void triBlockDiagLSolve(const std::vector<MatrixRef> & diag,
-                        const std::vector<MatrixRef> & subDiag,
-                        MatrixRef M,
-                        int start)
+void lSolve(const MatrixRef * diag, const MatrixRef * subDiag, int b, MatrixRef M, int start)
 {
   // We want to solve
   // | L1   0   0 ...| | X1 |   | M1 |
@@ -52,13 +48,11 @@ void triBlockDiagLSolve(const std::vector<MatrixRef> & diag,
   // Whenever Mi - B[i-1] X[i-1] is zero, Xi is zero and we can skip this block.
   // If it is not the case for i0, then it is not the case for any i>i0.
 
-  assert(diag.size() == subDiag.size() + 1);
-
   int n = 0;
   int l = 0;
   int li = 0;
   bool zero = true; //  Mi - B[i-1] X[i-1] is zero
-  for(size_t i = 0; i < diag.size(); ++i)
+  for(int i = 0; i < b; ++i)
   {
     auto Di = diag[i];
     assert(Di.rows() == Di.cols());
@@ -95,10 +89,7 @@ void triBlockDiagLSolve(const std::vector<MatrixRef> & diag,
   assert(n == M.rows());
 }
 
-void triBlockDiagLTransposeSolve(const std::vector<MatrixRef> & diag,
-                                 const std::vector<MatrixRef> & subDiag,
-                                 MatrixRef M,
-                                 int end)
+void lTransposeSolve(const MatrixRef * diag, const MatrixRef * subDiag, int b, MatrixRef M, int end)
 {
   // We want to solve
   // |                ...              | |  ...   |   |  ...   |
@@ -120,7 +111,7 @@ void triBlockDiagLTransposeSolve(const std::vector<MatrixRef> & diag,
 
   if(end < 0) end = n;
 
-  for(int i = static_cast<int>(diag.size()) - 1; i >= 0; --i)
+  for(int i = b - 1; i >= 0; --i)
   {
     auto Di = diag[i];
     assert(Di.rows() == Di.cols());
@@ -156,4 +147,229 @@ void triBlockDiagLTransposeSolve(const std::vector<MatrixRef> & diag,
   }
   assert(n == 0);
 }
+} // namespace
+
+namespace jrl::qp::decomposition
+{
+bool triBlockDiagLLT(const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & subDiag, int start)
+{
+  assert(diag.size() == subDiag.size() + 1);
+  assert(start >= 0 && start < static_cast<int>(diag.size()));
+  return llt(diag.data(), subDiag.data(), static_cast<int>(diag.size()), start);
+}
+
+void triBlockDiagLSolve(const std::vector<MatrixRef> & diag,
+                        const std::vector<MatrixRef> & subDiag,
+                        MatrixRef M,
+                        int start)
+{
+  assert(diag.size() == subDiag.size() + 1);
+  lSolve(diag.data(), subDiag.data(), static_cast<int>(diag.size()), M, start);
+}
+
+void triBlockDiagLTransposeSolve(const std::vector<MatrixRef> & diag,
+                                 const std::vector<MatrixRef> & subDiag,
+                                 MatrixRef M,
+                                 int end)
+{
+  assert(diag.size() == subDiag.size() + 1);
+  lTransposeSolve(diag.data(), subDiag.data(), static_cast<int>(diag.size()), M, end);
+}
+
+ParallelTriBlockDiagLLT::ParallelTriBlockDiagLLT(internal::ThreadPool & pool, int nbChunks)
+: pool_(&pool), requestedChunks_(nbChunks)
+{
+}
+
+void ParallelTriBlockDiagLLT::nbChunks(int p)
+{
+  requestedChunks_ = p;
+}
+
+Eigen::Map<Eigen::MatrixXd> ParallelTriBlockDiagLLT::F(int c) const
+{
+  assert(c > 0 && c < p_);
+  int r = row(interiorEnd(c)) - row(first(c));
+  int s = size(sep(c - 1));
+  return {work_.asVector(work_.size(), {}).data() + offsetF_[static_cast<size_t>(c)], r, s};
+}
+
+Eigen::Map<Eigen::MatrixXd> ParallelTriBlockDiagLLT::G(int c) const
+{
+  assert(c >= 0 && c < p_ - 2);
+  return {work_.asVector(work_.size(), {}).data() + offsetG_[static_cast<size_t>(c)], size(sep(c + 1)),
+          size(sep(c))};
+}
+
+
+bool ParallelTriBlockDiagLLT::compute(const std::vector<MatrixRef> & diag, const std::vector<MatrixRef> & subDiag)
+{
+  assert(diag.size() == subDiag.size() + 1);
+  assert(pool_);
+  const int b = static_cast<int>(diag.size());
+
+  // Each chunk but the last one needs at least one interior block and its separator.
+  int p = requestedChunks_ > 0 ? requestedChunks_ : pool_->size();
+  p_ = std::max(1, std::min(p, b / 2));
+  chunk_.resize(static_cast<size_t>(p_) + 1);
+  for(int c = 0; c <= p_; ++c) chunk_[static_cast<size_t>(c)] = c * b / p_;
+  rowStart_.resize(static_cast<size_t>(b) + 1);
+  rowStart_[0] = 0;
+  for(size_t i = 0; i < diag.size(); ++i) rowStart_[i + 1] = rowStart_[i] + static_cast<int>(diag[i].rows());
+
+  if(p_ == 1) return llt(diag.data(), subDiag.data(), b);
+
+  // Memory for the F(c) and G(c)
+  offsetF_.resize(static_cast<size_t>(p_));
+  offsetG_.resize(static_cast<size_t>(p_ - 2));
+  int total = 0;
+  for(int c = 1; c < p_; ++c)
+  {
+    offsetF_[static_cast<size_t>(c)] = total;
+    total += (row(interiorEnd(c)) - row(first(c))) * size(sep(c - 1));
+  }
+  for(int c = 0; c < p_ - 2; ++c)
+  {
+    offsetG_[static_cast<size_t>(c)] = total;
+    total += size(sep(c + 1)) * size(sep(c));
+  }
+  work_.resize(total);
+
+  // Factorization of the chunk interiors, L_I, and computation of W
+  std::atomic<bool> ok = true;
+  pool_->parallelFor(p_, [&](int c) {
+    int s = first(c);
+    int e = interiorEnd(c);
+    if(!llt(diag.data() + s, subDiag.data() + s, e - s))
+    {
+      ok = false;
+      return;
+    }
+    if(c < p_ - 1)
+    {
+      // The only non-zero block of W between sep(c) and the interior of chunk c is
+      // B = S[e-1] L[e-1]^-T, stored in place of S[e-1]
+      internal::blockSolveLTransposeRight(diag[static_cast<size_t>(e - 1)], subDiag[static_cast<size_t>(e - 1)]);
+    }
+    if(c > 0)
+    {
+      // F(c) = L_Ic^-1 [S[s-1]; 0]. This block is dense.
+      auto Fc = F(c);
+      int ns = size(s);
+      Fc.topRows(ns) = subDiag[static_cast<size_t>(s - 1)];
+      Fc.bottomRows(Fc.rows() - ns).setZero();
+      lSolve(diag.data() + s, subDiag.data() + s, e - s, Fc, 0);
+    }
+  });
+  if(!ok) return false;
+
+  // Schur complement A_S - W W^T
+  pool_->parallelFor(p_ - 1, [&](int c) {
+    int t = sep(c);
+    auto Dt = diag[static_cast<size_t>(t)];
+    auto Fc = F(c + 1);
+    internal::blockRankUpdate(Dt, subDiag[static_cast<size_t>(t - 1)]);
+    internal::blockRankUpdateTranspose(Dt, Fc);
+    if(c < p_ - 2)
+    {
+      int t1 = sep(c + 1);
+      G(c).noalias() = -subDiag[static_cast<size_t>(t1 - 1)] * Fc.bottomRows(size(t1 - 1));
+    }
+  });
+
+  // Factorization of the Schur complement, L_S
+  for(int c = 0; c < p_ - 1; ++c)
+  {
+    const auto & Dt = diag[static_cast<size_t>(sep(c))];
+    if(!internal::blockLLT(Dt)) return false;
+    if(c < p_ - 2)
+    {
+      auto Gc = G(c);
+      internal::blockSolveLTransposeRight(Dt, Gc);
+      internal::blockRankUpdate(diag[static_cast<size_t>(sep(c + 1))], Gc);
+    }
+  }
+
+  return true;
+}
+
+void ParallelTriBlockDiagLLT::solveL(const std::vector<MatrixRef> & diag,
+                                     const std::vector<MatrixRef> & subDiag,
+                                     MatrixRef M,
+                                     int start) const
+{
+  assert(diag.size() + 1 == rowStart_.size());
+  assert(M.rows() == rowStart_.back());
+  if(p_ == 1)
+  {
+    lSolve(diag.data(), subDiag.data(), static_cast<int>(diag.size()), M, start);
+    return;
+  }
+
+  // Y_I = L_I^-1 M_I
+  pool_->parallelFor(p_, [&](int c) {
+    int s = first(c);
+    int e = interiorEnd(c);
+    // If M_Ic is zero, so is Y_Ic
+    if(row(e) <= start) return;
+    lSolve(diag.data() + s, subDiag.data() + s, e - s, M.middleRows(row(s), row(e) - row(s)),
+           std::max(0, start - row(s)));
+  });
+
+  // M_S - W Y_I
+  pool_->parallelFor(p_ - 1, [&](int c) {
+    int t = sep(c);
+    int s1 = first(c + 1);
+    auto Mt = M.middleRows(row(t), size(t));
+    Mt.noalias() -= subDiag[static_cast<size_t>(t - 1)] * M.middleRows(row(t - 1), size(t - 1));
+    Mt.noalias() -= F(c + 1).transpose() * M.middleRows(row(s1), row(interiorEnd(c + 1)) - row(s1));
+  });
+
+  // Y_S = L_S^-1 (M_S - W Y_I)
+  for(int c = 0; c < p_ - 1; ++c)
+  {
+    int t = sep(c);
+    auto Mt = M.middleRows(row(t), size(t));
+    if(c > 0) Mt.noalias() -= G(c - 1) * M.middleRows(row(sep(c - 1)), size(sep(c - 1)));
+    auto Dt = diag[static_cast<size_t>(t)];
+    Dt.template triangularView<Eigen::Lower>().solveInPlace(Mt);
+  }
+}
+
+void ParallelTriBlockDiagLLT::solveLTranspose(const std::vector<MatrixRef> & diag,
+                                              const std::vector<MatrixRef> & subDiag,
+                                              MatrixRef M) const
+{
+  assert(diag.size() + 1 == rowStart_.size());
+  assert(M.rows() == rowStart_.back());
+  if(p_ == 1)
+  {
+    lTransposeSolve(diag.data(), subDiag.data(), static_cast<int>(diag.size()), M, -1);
+    return;
+  }
+
+  // X_S = L_S^-T M_S
+  for(int c = p_ - 2; c >= 0; --c)
+  {
+    int t = sep(c);
+    auto Mt = M.middleRows(row(t), size(t));
+    if(c < p_ - 2) Mt.noalias() -= G(c).transpose() * M.middleRows(row(sep(c + 1)), size(sep(c + 1)));
+    auto Dt = diag[static_cast<size_t>(t)];
+    Dt.template triangularView<Eigen::Lower>().transpose().solveInPlace(Mt);
+  }
+
+  // X_I = L_I^-T (M_I - W^T X_S)
+  pool_->parallelFor(p_, [&](int c) {
+    int s = first(c);
+    int e = interiorEnd(c);
+    auto Mi = M.middleRows(row(s), row(e) - row(s));
+    if(c > 0) Mi.noalias() -= F(c) * M.middleRows(row(sep(c - 1)), size(sep(c - 1)));
+    if(c < p_ - 1)
+    {
+      Mi.bottomRows(size(e - 1)).noalias() -=
+          subDiag[static_cast<size_t>(e - 1)].transpose() * M.middleRows(row(sep(c)), size(sep(c)));
+    }
+    lTransposeSolve(diag.data() + s, subDiag.data() + s, e - s, Mi, -1);
+  });
+}
 } // namespace jrl::qp::decomposition
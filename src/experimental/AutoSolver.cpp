@@ -0,0 +1,512 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/experimental/AutoSolver.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace
+{
+using namespace jrl::qp;
+using GType = structured::StructuredG::Type;
+
+// Rough cost of handling a block of variables in the structured computations, and of a
+// column of a banded matrix, in flops. They account for the loops and function calls.
+constexpr double blockOverhead = 1000;
+constexpr double bandOverhead = 20;
+// A structure is chosen if its estimated cost is at least minGain times lower than the
+// dense one, as BlockGISolver does more work per iteration than the dense solver.
+constexpr double minGain = 4;
+// Maximum size of the tip of the arrows that is looked for.
+constexpr int maxTip = 64;
+
+/** Lower profile of G: lo[i] is the first column j <= i with G(i,j) != 0, and hi[j] is
+ * the last row i >= j with G(i,j) != 0 (i, resp. j, if there is none).
+ */
+void profiles(const MatrixConstRef & G, std::vector<int> & lo, std::vector<int> & hi)
+{
+  int n = static_cast<int>(G.rows());
+  lo.resize(static_cast<size_t>(n));
+  hi.resize(static_cast<size_t>(n));
+  for(int i = 0; i < n; ++i)
+  {
+    lo[static_cast<size_t>(i)] = i;
+    hi[static_cast<size_t>(i)] = i;
+  }
+  for(int j = 0; j < n; ++j)
+  {
+    for(int i = j + 1; i < n; ++i)
+    {
+      if(G(i, j) != 0)
+      {
+        lo[static_cast<size_t>(i)] = std::min(lo[static_cast<size_t>(i)], j);
+        hi[static_cast<size_t>(j)] = i;
+      }
+    }
+  }
+}
+
+/** Sizes of the blocks of the finest block-diagonal partition of the leading m x m part
+ * of a matrix with lower profile lo.
+ */
+std::vector<int> blockDiagPartition(const std::vector<int> & lo, int m)
+{
+  // There is a boundary at p if no row i >= p has a non-zero in a column j < p.
+  std::vector<int> sizes;
+  int minLo = m;
+  int end = m;
+  for(int p = m - 1; p >= 0; --p)
+  {
+    minLo = std::min(minLo, lo[static_cast<size_t>(p)]);
+    if(minLo >= p)
+    {
+      sizes.push_back(end - p);
+      end = p;
+    }
+  }
+  std::reverse(sizes.begin(), sizes.end());
+  return sizes;
+}
+
+/** Block tri-diagonal partition of a matrix with profile hi, with a first block of size
+ * s1. Each block is made just large enough for the non-zeros of the columns of the
+ * previous block.
+ */
+std::vector<int> triBlockPartition(const std::vector<int> & hi, int n, int s1)
+{
+  std::vector<int> s = {0, s1};
+  while(s.back() < n)
+  {
+    int a = s[s.size() - 2];
+    int b = s.back();
+    int m = b + 1;
+    for(int j = a; j < b; ++j) m = std::max(m, hi[static_cast<size_t>(j)] + 1);
+    s.push_back(std::min(m, n));
+  }
+  std::vector<int> sizes(s.size() - 1);
+  for(size_t i = 0; i < sizes.size(); ++i) sizes[i] = s[i + 1] - s[i];
+  return sizes;
+}
+
+double cube(double n)
+{
+  return n * n * n / 3;
+}
+
+/** Estimated number of flops for the decomposition of a matrix with the given type and
+ * blocks (blocks being the leaves, and t the tip, for the arrows).
+ */
+double cost(GType type, const std::vector<int> & blocks, int t = 0)
+{
+  double c = 0;
+  for(size_t i = 0; i < blocks.size(); ++i)
+  {
+    double ni = blocks[i];
+    c += cube(ni) + blockOverhead;
+    if(type == GType::TriBlockDiagonal && i > 0)
+    {
+      double nj = blocks[i - 1];
+      c += ni * nj * (ni + nj);
+    }
+    if(type == GType::BlockArrowUp || type == GType::BlockArrowDown) c += ni * t * (ni + t);
+  }
+  if(t > 0) c += cube(t) + blockOverhead;
+  return c;
+}
+
+/** Block of variable i, given the starting row of each block.*/
+int blockOf(const std::vector<int> & start, int i)
+{
+  return static_cast<int>(std::upper_bound(start.begin(), start.end(), i) - start.begin()) - 1;
+}
+
+/** First and last non-zero rows of each column of C (-1 if the column is zero).*/
+void columnRanges(const MatrixConstRef & C, std::vector<int> & first, std::vector<int> & last)
+{
+  int n = static_cast<int>(C.rows());
+  int m = static_cast<int>(C.cols());
+  first.assign(static_cast<size_t>(m), -1);
+  last.assign(static_cast<size_t>(m), -1);
+  for(int j = 0; j < m; ++j)
+  {
+    for(int i = 0; i < n; ++i)
+    {
+      if(C(i, j) != 0)
+      {
+        if(first[static_cast<size_t>(j)] < 0) first[static_cast<size_t>(j)] = i;
+        last[static_cast<size_t>(j)] = i;
+      }
+    }
+  }
+}
+
+/** Group of each constraint (first block it acts on) and block bandwidth of C for the
+ * blocks starting at start.
+ */
+int constraintGroups(const std::vector<int> & start,
+                     const std::vector<int> & first,
+                     const std::vector<int> & last,
+                     std::vector<int> & group)
+{
+  int bw = 0;
+  group.resize(first.size());
+  for(size_t j = 0; j < first.size(); ++j)
+  {
+    if(first[j] < 0)
+    {
+      group[j] = 0;
+      continue;
+    }
+    group[j] = blockOf(start, first[j]);
+    bw = std::max(bw, blockOf(start, last[j]) - group[j]);
+  }
+  return bw;
+}
+
+std::vector<int> starts(const std::vector<int> & sizes)
+{
+  std::vector<int> s = {0};
+  for(int n : sizes) s.push_back(s.back() + n);
+  return s;
+}
+} // namespace
+
+namespace jrl::qp::experimental
+{
+const AutoSolver::Structure & AutoSolver::analyze(const MatrixConstRef & G,
+                                                  const MatrixConstRef & C,
+                                                  const VectorConstRef & bl,
+                                                  const VectorConstRef & bu,
+                                                  bool useBounds)
+{
+  assert(G.rows() == G.cols());
+  assert(C.rows() == G.rows());
+  const int n = static_cast<int>(G.rows());
+  nbVar_ = n;
+  nbCstr_ = static_cast<int>(C.cols());
+  useBounds_ = useBounds;
+  analyzed_ = true;
+  ++nbAnalyses_;
+
+  std::vector<int> lo, hi;
+  profiles(G, lo, hi);
+  int k = 0;
+  for(int i = 0; i < n; ++i) k = std::max(k, i - lo[static_cast<size_t>(i)]);
+
+  Structure & s = structure_;
+  s = Structure();
+  s.bandwidth = k;
+  s.blocks = {n};
+  s.cstrBlocks = {nbCstr_};
+  s.perm.resize(static_cast<size_t>(nbCstr_));
+  std::iota(s.perm.begin(), s.perm.end(), 0);
+
+  if(k == 0 && useBounds && singleOneSided(bl, bu))
+  {
+    s.backend = Backend::BoxAndSingleConstraint;
+    return s;
+  }
+
+  // Candidate structures for G, each one being evaluated with the block bandwidth of C
+  // it induces.
+  std::vector<int> first, last, group;
+  columnRanges(C, first, last);
+  double best = cube(n) / minGain;
+  std::vector<int> bestGroup;
+  auto consider = [&](GType t, std::vector<int> blocks, double c) {
+    auto start = starts(blocks);
+    int bw = constraintGroups(start, first, last, group);
+    c *= 1 + bw;
+    if(c < best)
+    {
+      best = c;
+      s.backend = Backend::Block;
+      s.gType = t;
+      s.blocks = std::move(blocks);
+      s.cBandwidth = bw;
+      bestGroup = group;
+    }
+  };
+
+  // Banded
+  if(k < n - 1) consider(GType::Banded, {n}, n * (k * k + k + bandOverhead));
+
+  // Block diagonal
+  auto bd = blockDiagPartition(lo, n);
+  if(bd.size() > 1) consider(GType::BlockDiagonal, bd, cost(GType::BlockDiagonal, bd));
+
+  // Block tri-diagonal, for several sizes of the first block
+  for(int s1 = 1; s1 < std::min(n, 2 * k + 2); ++s1)
+  {
+    auto tb = triBlockPartition(hi, n, s1);
+    if(tb.size() > 2) consider(GType::TriBlockDiagonal, tb, cost(GType::TriBlockDiagonal, tb));
+  }
+
+  // Arrows: block diagonal matrix with the tip as the last block (down), or the first
+  // one (up). The up case is the down case for the matrix with the variables in reverse
+  // order, whose lower profile is given by hi.
+  std::vector<int> loRev(static_cast<size_t>(n));
+  for(int i = 0; i < n; ++i) loRev[static_cast<size_t>(i)] = n - 1 - hi[static_cast<size_t>(n - 1 - i)];
+  for(int t = 1; t <= std::min(maxTip, n / 3); ++t)
+  {
+    auto down = blockDiagPartition(lo, n - t);
+    if(down.size() > 1)
+    {
+      double c = cost(GType::BlockArrowDown, down, t);
+      down.push_back(t);
+      consider(GType::BlockArrowDown, down, c);
+    }
+    auto up = blockDiagPartition(loRev, n - t);
+    if(up.size() > 1)
+    {
+      double c = cost(GType::BlockArrowUp, up, t);
+      std::reverse(up.begin(), up.end());
+      up.insert(up.begin(), t);
+      consider(GType::BlockArrowUp, up, c);
+    }
+  }
+
+  if(s.backend == Backend::Block)
+  {
+    if(s.gType == GType::Banded)
+      s.cType = structured::StructuredC::Type::Diagonal;
+    else if(s.cBandwidth == 0)
+      s.cType = structured::StructuredC::Type::Diagonal;
+    else if(s.cBandwidth == 1)
+      s.cType = structured::StructuredC::Type::BlockBidiagonal;
+    else
+      s.cType = structured::StructuredC::Type::Banded;
+
+    // Constraints sorted by group
+    std::stable_sort(s.perm.begin(), s.perm.end(), [&](int i, int j) {
+      return bestGroup[static_cast<size_t>(i)] < bestGroup[static_cast<size_t>(j)];
+    });
+    s.cstrBlocks.assign(s.blocks.size(), 0);
+    for(int g : bestGroup) ++s.cstrBlocks[static_cast<size_t>(g)];
+    buildViews();
+  }
+
+  return s;
+}
+
+TerminationStatus AutoSolver::solve(const MatrixConstRef & G,
+                                    const VectorConstRef & a,
+                                    const MatrixConstRef & C,
+                                    const VectorConstRef & bl,
+                                    const VectorConstRef & bu,
+                                    const VectorConstRef & xl,
+                                    const VectorConstRef & xu)
+{
+  bool useBounds = xl.size() > 0;
+  if(!analyzed_ || !fits(G, C, bl, bu, useBounds)) analyze(G, C, bl, bu, useBounds);
+
+  switch(structure_.backend)
+  {
+    case Backend::Block:
+      return solveBlock(G, a, C, bl, bu, xl, xu);
+    case Backend::BoxAndSingleConstraint:
+      return solveBox(G, a, C, bl, bu, xl, xu);
+    default:
+      return solveDense(G, a, C, bl, bu, xl, xu);
+  }
+}
+
+TerminationStatus AutoSolver::solve(const Eigen::SparseMatrix<double> & G,
+                                    const VectorConstRef & a,
+                                    const Eigen::SparseMatrix<double> & C,
+                                    const VectorConstRef & bl,
+                                    const VectorConstRef & bu,
+                                    const VectorConstRef & xl,
+                                    const VectorConstRef & xu)
+{
+  Eigen::MatrixXd Gd = G;
+  Eigen::MatrixXd Cd = C;
+  return solve(Gd, a, Cd, bl, bu, xl, xu);
+}
+
+void AutoSolver::options(const SolverOptions & opt)
+{
+  options_ = opt;
+  dense_.options(opt);
+  block_.options(opt);
+  box_.options(opt);
+}
+
+bool AutoSolver::singleOneSided(const VectorConstRef & bl, const VectorConstRef & bu) const
+{
+  if(bl.size() == 0) return true;
+  return bl.size() == 1 && (bl[0] < -options_.bigBnd() || bu[0] > options_.bigBnd());
+}
+
+bool AutoSolver::fits(const MatrixConstRef & G,
+                      const MatrixConstRef & C,
+                      const VectorConstRef & bl,
+                      const VectorConstRef & bu,
+                      bool useBounds) const
+{
+  const int n = static_cast<int>(G.rows());
+  if(n != nbVar_ || C.cols() != nbCstr_ || useBounds != useBounds_) return false;
+
+  const Structure & s = structure_;
+  if(s.backend == Backend::Dense) return true;
+  if(s.backend == Backend::BoxAndSingleConstraint)
+  {
+    if(!singleOneSided(bl, bu)) return false;
+    // G is diagonal. Its strictly lower part is checked in place, to avoid a temporary.
+    for(int j = 0; j < n - 1; ++j)
+    {
+      if(!G.col(j).tail(n - j - 1).isZero(0)) return false;
+    }
+    return true;
+  }
+
+  // Non-zeros of G
+  int b = static_cast<int>(s.blocks.size());
+  for(int i = 0; i < n; ++i)
+  {
+    int bi = blockOf(varStart_, i);
+    int lo; // First column allowed in row i, in addition to the tip for the arrows
+    switch(s.gType)
+    {
+      case GType::Banded:
+        lo = i - s.bandwidth;
+        break;
+      case GType::TriBlockDiagonal:
+        lo = varStart_[static_cast<size_t>(std::max(bi - 1, 0))];
+        break;
+      case GType::BlockArrowDown:
+        lo = bi == b - 1 ? 0 : varStart_[static_cast<size_t>(bi)];
+        break;
+      default:
+        lo = varStart_[static_cast<size_t>(bi)];
+        break;
+    }
+    int j0 = s.gType == GType::BlockArrowUp ? varStart_[1] : 0;
+    for(int j = j0; j < std::max(lo, 0); ++j)
+    {
+      if(G(i, j) != 0) return false;
+    }
+  }
+
+  // Non-zeros of C
+  for(int k = 0; k < nbCstr_; ++k)
+  {
+    int g = blockOf(cstrStart_, k);
+    int r0 = varStart_[static_cast<size_t>(g)];
+    int r1 = varStart_[static_cast<size_t>(std::min(g + s.cBandwidth + 1, b))];
+    const auto & c = C.col(s.perm[static_cast<size_t>(k)]);
+    if(!c.head(r0).isZero(0) || !c.tail(n - r1).isZero(0)) return false;
+  }
+  return true;
+}
+
+void AutoSolver::buildViews()
+{
+  const Structure & s = structure_;
+  varStart_ = starts(s.blocks);
+  cstrStart_ = starts(s.cstrBlocks);
+  pattern_.reset(s.gType, s.blocks, s.cstrBlocks, s.cBandwidth, s.bandwidth);
+  l_.resize(nbCstr_);
+  u_.resize(nbCstr_);
+}
+
+TerminationStatus AutoSolver::solveDense(const MatrixConstRef & G,
+                                         const VectorConstRef & a,
+                                         const MatrixConstRef & C,
+                                         const VectorConstRef & bl,
+                                         const VectorConstRef & bu,
+                                         const VectorConstRef & xl,
+                                         const VectorConstRef & xu)
+{
+  // G is overwritten by the solver
+  G_ = G;
+  auto ret = dense_.solve(G_, a, C, bl, bu, xl, xu);
+  x_ = dense_.solution();
+  f_ = dense_.objectiveValue();
+  it_ = dense_.iterations();
+  as_ = dense_.activeSet();
+  return ret;
+}
+
+TerminationStatus AutoSolver::solveBlock(const MatrixConstRef & G,
+                                         const VectorConstRef & a,
+                                         const MatrixConstRef & C,
+                                         const VectorConstRef & bl,
+                                         const VectorConstRef & bu,
+                                         const VectorConstRef & xl,
+                                         const VectorConstRef & xu)
+{
+  const Structure & s = structure_;
+  // Only the values are copied: the views of pattern_ are kept from the analysis.
+  pattern_.setG(G);
+  for(int k = 0; k < nbCstr_; ++k)
+  {
+    int i = s.perm[static_cast<size_t>(k)];
+    pattern_.setCCol(k, C.col(i));
+    l_[k] = bl[i];
+    u_[k] = bu[i];
+  }
+
+  auto ret = block_.solve(pattern_.G(), a, pattern_.C(), l_, u_, xl, xu);
+  x_ = block_.solution();
+  f_ = block_.objectiveValue();
+  it_ = block_.iterations();
+  const auto & as = block_.activeSet();
+  as_.resize(as.size());
+  for(int k = 0; k < nbCstr_; ++k)
+    as_[static_cast<size_t>(s.perm[static_cast<size_t>(k)])] = as[static_cast<size_t>(k)];
+  std::copy(as.begin() + nbCstr_, as.end(), as_.begin() + nbCstr_);
+  return ret;
+}
+
+TerminationStatus AutoSolver::solveBox(const MatrixConstRef & G,
+                                       const VectorConstRef & a,
+                                       const MatrixConstRef & C,
+                                       const VectorConstRef & bl,
+                                       const VectorConstRef & bu,
+                                       const VectorConstRef & xl,
+                                       const VectorConstRef & xu)
+{
+  // With y = D^1/2 x, where D is the diagonal of G, the problem is
+  // min. 0.5 ||y - y0||^2 with y0 = -D^-1/2 a, s.t. (D^-1/2 c)^T y >= b and the scaled
+  // bounds. An upper bound b <= c^T x is written as -c^T x >= -b.
+  d_ = G.diagonal();
+  if(!(d_.minCoeff() > 0)) return TerminationStatus::NON_POS_HESSIAN;
+  d_ = d_.cwiseSqrt();
+  a_ = -a.cwiseQuotient(d_);
+  xl_ = xl.cwiseProduct(d_);
+  xu_ = xu.cwiseProduct(d_);
+  double b = -std::numeric_limits<double>::infinity();
+  bool flip = false;
+  if(nbCstr_ == 1)
+  {
+    flip = bl[0] < -options_.bigBnd();
+    c_ = C.col(0).cwiseQuotient(d_);
+    b = bl[0];
+    if(flip)
+    {
+      c_ = -c_;
+      b = -bu[0];
+    }
+  }
+  else
+    c_.setZero(nbVar_);
+
+  auto ret = box_.solve(a_, c_, b, xl_, xu_);
+  x_ = box_.solution().cwiseQuotient(d_);
+  f_ = box_.objectiveValue() - 0.5 * a_.squaredNorm();
+  it_ = box_.iterations();
+  // The active set of box_ always has one general constraint.
+  const auto & as = box_.activeSet();
+  as_.resize(static_cast<size_t>(nbCstr_ + nbVar_));
+  if(nbCstr_ == 1)
+  {
+    as_[0] = as[0];
+    if(flip && as[0] == ActivationStatus::LOWER) as_[0] = ActivationStatus::UPPER;
+  }
+  std::copy(as.begin() + 1, as.end(), as_.begin() + nbCstr_);
+  return ret;
+}
+} // namespace jrl::qp::experimental
@@ -1,5 +1,7 @@
 /* Copyright 2020 CNRS-AIST JRL */
 
+#include <algorithm>
+
 #include <Eigen/Cholesky>
 #include <Eigen/QR>
 #include <jrl-qp/experimental/BlockGISolver.h>
@@ -59,6 +61,64 @@ TerminationStatus BlockGISolver::solve(const structured::StructuredG & G,
   return DualSolver::solve();
 }
 
+void BlockGISolver::shift(int k)
+{
+  const auto & G = pb_.G;
+  const auto & C = pb_.C;
+  assert(k >= 0);
+  assert(G.nbBlocks() == C.nbBlocks());
+  assert(A_.nbCstr() == C.nbCstr());
+
+  // Stages are the blocks first to last-1
+  int b = G.nbBlocks();
+  int first = G.type() == structured::StructuredG::Type::BlockArrowUp ? 1 : 0;
+  int last = G.type() == structured::StructuredG::Type::BlockArrowDown ? b - 1 : b;
+  if(last <= first) return;
+
+  // Equality and fixed status are recomputed from the data, for the stages as well as
+  // for the blocks that are not shifted.
+  auto filter = [](ActivationStatus s) {
+    return s == ActivationStatus::EQUALITY || s == ActivationStatus::FIXED ? ActivationStatus::INACTIVE : s;
+  };
+  const auto & as = A_.activationStatus();
+  shiftedAs_.resize(as.size());
+  std::transform(as.begin(), as.end(), shiftedAs_.begin(), filter);
+
+  // Shift the statuses of a group of elements (constraints or bounds) starting at
+  // offset, where block i has size(i) elements. Block i takes the statuses of block
+  // j = min(i+k, last-1), starting at src.
+  auto shiftBlocks = [&](int offset, auto && size) {
+    int dst = offset;
+    int src = offset;
+    for(int i = 0; i < first; ++i) dst += size(i);
+    for(int i = 0; i < first + k && i < last - 1; ++i) src += size(i);
+    for(int i = first; i < last; ++i)
+    {
+      int j = std::min(i + k, last - 1);
+      int n = size(i);
+      if(size(j) == n)
+      {
+        for(int l = 0; l < n; ++l) shiftedAs_[static_cast<size_t>(dst + l)] = filter(as[static_cast<size_t>(src + l)]);
+      }
+      else
+      {
+        std::fill_n(shiftedAs_.begin() + dst, n, ActivationStatus::INACTIVE);
+      }
+      dst += n;
+      if(i + k < last - 1) src += size(j);
+    }
+  };
+  shiftBlocks(0, [&](int i) { return C.nbCstr(i); });
+  if(A_.nbBnd() > 0) shiftBlocks(A_.nbCstr(), [&](int i) { return G.nbVar(i); });
+
+  A_.reset();
+  for(int i = 0; i < A_.nbAll(); ++i)
+  {
+    if(shiftedAs_[static_cast<size_t>(i)] != ActivationStatus::INACTIVE)
+      A_.activate(i, shiftedAs_[static_cast<size_t>(i)]);
+  }
+}
+
 internal::InitTermination BlockGISolver::init_()
 {
   JRLQP_DEBUG_ONLY(QR_.setRToZero());
@@ -67,12 +127,15 @@ internal::InitTermination BlockGISolver::init_()
   auto retAS = processInitialActiveSet();
   if(!retAS) return retAS;
 
+  // If allowed, a G already decomposed by the caller (e.g. with refactorize after some
+  // blocks were updated) is used as is.
   // [OPTIM]: this is not necessary if there are nbVar equality constraints
-  auto ret = pb_.G.lltInPlace();
+  auto ret = (reuseDecomposition_ && pb_.G.decomposed()) || pb_.G.lltInPlace();
 
   if(!ret) return TerminationStatus::NON_POS_HESSIAN;
 
-  initializeComputationData();
+  auto retData = initializeComputationData();
+  if(!retData) return retData;
   initializePrimalDualPoints();
 
   // If some constraints have ben activated with u<0, we deactivate them
@@ -272,7 +335,22 @@ double BlockGISolver::dot_(const internal::SelectedConstraint & sc, const Vector
   }
 }
 
-void BlockGISolver::resize_(int nbVar, int nbCstr, bool /*useBounds*/)
+void BlockGISolver::compactionRatio(double r)
+{
+  QR_.compactionRatio(r);
+}
+
+void BlockGISolver::reserveHint(int nbActive)
+{
+  QR_.reserveHint(nbActive);
+}
+
+void BlockGISolver::reuseDecomposition(bool reuse)
+{
+  reuseDecomposition_ = reuse;
+}
+
+void BlockGISolver::resize_(int nbVar, int nbCstr, bool useBounds)
 {
   if(nbVar != nbVar_)
   {
@@ -285,6 +363,9 @@ void BlockGISolver::resize_(int nbVar, int nbCstr, bool /*useBounds*/)
   {
     work_cx_.resize(nbCstr);
   }
+  // So that copying the warm start data does not allocate
+  pb_.as.reserve(static_cast<size_t>(nbCstr + (useBounds ? nbVar : 0)));
+  shiftedAs_.reserve(static_cast<size_t>(nbCstr + (useBounds ? nbVar : 0)));
 }
 
 internal::TerminationType BlockGISolver::processInitialActiveSet()
@@ -333,7 +414,7 @@ internal::TerminationType BlockGISolver::processInitialActiveSet()
     {
       auto s = pb_.as[i];
       assert(s <= ActivationStatus::EQUALITY);
-      if(s == ActivationStatus::FIXED)
+      if(s == ActivationStatus::EQUALITY)
       {
         JRLQP_LOG_COMMENT(log_, LogFlags::ACTIVE_SET, "Ignoring activation status for constraint ", i);
       }
@@ -375,110 +456,94 @@ internal::TerminationType BlockGISolver::processInitialActiveSet()
 
 internal::TerminationType BlockGISolver::initializeComputationData()
 {
-  // auto L = pb_.G.template triangularView<Eigen::Lower>();
-
-  // int q = A_.nbActiveCstr();
-  // auto N = work_R_.asMatrix(nbVar_, q, nbVar_);
-  // auto b_act = work_bact_.asVector(q);
-  // for(int i = 0; i < q; ++i)
-  //{
-  //  int cstrIdx = A_[i];
-  //  switch(A_.activationStatus(cstrIdx))
-  //  {
-  //    case ActivationStatus::LOWER: // fallthrough
-  //    case ActivationStatus::EQUALITY:
-  //      N.col(i) = pb_.C.col(cstrIdx);
-  //      b_act[i] = pb_.bl(cstrIdx);
-  //      break;
-  //    case ActivationStatus::UPPER:
-  //      N.col(i) = -pb_.C.col(cstrIdx);
-  //      b_act[i] = -pb_.bu(cstrIdx);
-  //      break;
-  //    case ActivationStatus::LOWER_BOUND: // fallthrough
-  //    case ActivationStatus::FIXED:
-  //      N.col(i).setZero();
-  //      N.col(i)[cstrIdx - A_.nbCstr()] = 1;
-  //      b_act[i] = pb_.xl(cstrIdx - A_.nbCstr());
-  //      break;
-  //    case ActivationStatus::UPPER_BOUND:
-  //      N.col(i).setZero();
-  //      N.col(i)[cstrIdx - A_.nbCstr()] = -1;
-  //      b_act[i] = -pb_.xu(cstrIdx - A_.nbCstr());
-  //      break;
-  //    default:
-  //      break;
-  //  }
-  //}
-
-  //// J = L^-t
-  // auto J = work_J_.asMatrix(nbVar_, nbVar_, nbVar_);
-  // J.setIdentity();
-  // L.transpose().solveInPlace(J);
-
-  //// B = L^-1 N
-  // L.solveInPlace(N); // [OPTIM] There are other possible ways to do this:
-  //                   //  - use solveInPlace while filling N
-  //                   //  - multiply N by J^T = L^-t (this would require that multiplication by triangular matrix can
-  //                   be
-  //                   //  done in place with Eigen)
-
-  //// QR in place
-  // Eigen::Map<Eigen::VectorXd> hCoeffs(work_hCoeffs_.asVector(q).data(),
-  //                                    q); // Should be simply hCoeffs = work_hCoeffs_.asVector(q), but his does
-  //                                    compile
-  //                                        // with householder_qr_inplace_blocked
-  // WVector tmp = work_tmp_.asVector(nbVar_);
-  // bool b = Eigen::internal::is_malloc_allowed();
-  // Eigen::internal::set_is_malloc_allowed(true);
-  // Eigen::internal::householder_qr_inplace_blocked<decltype(N), decltype(hCoeffs)>::run(N, hCoeffs, 48, tmp.data());
-
-  //// J = J*Q
-  // Eigen::HouseholderSequence Q(N, hCoeffs);
-  // Q.applyThisOnTheRight(J, tmp);
-  // Eigen::internal::set_is_malloc_allowed(b);
-
-  //// Set lower part of R to 0
-  // JRLQP_DEBUG_ONLY(for(int i = 0; i < q; ++i) N.col(i).tail(nbVar_ - i - 1).setZero(););
-
-  // JRLQP_LOG(log_, LogFlags::INIT | LogFlags::NO_ITER, N, J, b_act);
-
-  // temp
   J_.reset();
   QR_.reset();
   J_.setL(pb_.G);
   J_.setQ(QR_.getPartitionnedQ());
+
+  // The active constraints are added one by one to the QR decomposition of
+  // B = L^-1 N, where N is the matrix of the active constraint normals. For the i-th
+  // constraint n_i, J^T n_i = Q^T L^-1 n_i with the current Q gives the column to add.
+  // Adding it updates R and Q, and thus J = L^-T Q. Inequality constraints that are
+  // linearly dependent on the previous ones are deactivated.
+  auto d = work_d_.asVector(nbVar_, {});
+  int q = 0;
+  while(q < A_.nbActiveCstr())
+  {
+    int cstrIdx = A_[q];
+    auto status = A_.activationStatus(cstrIdx);
+    J_.premultByJt(d, pb_.C, {cstrIdx, status});
+    if(QR_.add(d))
+    {
+      ++q;
+    }
+    else
+    {
+      if(status == ActivationStatus::EQUALITY || status == ActivationStatus::FIXED)
+        return TerminationStatus::LINEAR_DEPENDENCY_DETECTED;
+      A_.deactivate(q);
+    }
+  }
+
+  auto b_act = work_bact_.asVector(q, {});
+  for(int i = 0; i < q; ++i)
+  {
+    int cstrIdx = A_[i];
+    switch(A_.activationStatus(cstrIdx))
+    {
+      case ActivationStatus::LOWER: // fallthrough
+      case ActivationStatus::EQUALITY:
+        b_act[i] = pb_.bl(cstrIdx);
+        break;
+      case ActivationStatus::UPPER:
+        b_act[i] = -pb_.bu(cstrIdx);
+        break;
+      case ActivationStatus::LOWER_BOUND: // fallthrough
+      case ActivationStatus::FIXED:
+        b_act[i] = pb_.xl(cstrIdx - A_.nbCstr());
+        break;
+      case ActivationStatus::UPPER_BOUND:
+        b_act[i] = -pb_.xu(cstrIdx - A_.nbCstr());
+        break;
+      default:
+        break;
+    }
+  }
+
+  JRLQP_LOG(log_, LogFlags::INIT | LogFlags::NO_ITER, b_act);
+
   return TerminationStatus::SUCCESS;
 }
 
 internal::TerminationType BlockGISolver::initializePrimalDualPoints()
 {
-  // int q = A_.nbActiveCstr();
-  // WVector b_act = work_bact_.asVector(q);
-  // WVector alpha = work_tmp_.asVector(nbVar_);
-  // WVector beta = work_r_.asVector(q);
-  // WVector x = work_x_.asVector(nbVar_);
-  // WVector u = work_u_.asVector(q);
-  // auto alpha1 = alpha.head(q);
-  // auto alpha2 = alpha.tail(nbVar_ - q);
-
-  // alpha.noalias() = J.transpose() * pb_.a;
-  // beta = R.transpose().solve(b_act);
-  // x.noalias() = J.leftCols(q) * beta - J.rightCols(nbVar_ - q) * alpha2;
-  // u = alpha1 + beta;
-  // R.solveInPlace(u);
-
-  // f_ = beta.dot(0.5 * beta + alpha1) - 0.5 * alpha2.squaredNorm();
-
-  // JRLQP_LOG(log_, LogFlags::INIT | LogFlags::NO_ITER, alpha, beta, x, u, f_);
-
-  // temp computation
-  assert(A_.nbActiveCstr() == 0);
-  // x = -G^-1 * a
-  auto x = work_x_.asVector(nbVar_);
-  pb_.G.solveL(x, pb_.a);
+  int q = A_.nbActiveCstr();
+  WVector b_act = work_bact_.asVector(q);
+  WVector alpha = work_d_.asVector(nbVar_);
+  WVector beta = work_r_.asVector(q);
+  WVector x = work_x_.asVector(nbVar_);
+  WVector u = work_u_.asVector(q);
+  auto alpha1 = alpha.head(q);
+  auto alpha2 = alpha.tail(nbVar_ - q);
+  const auto & Q = QR_.getPartitionnedQ().Q();
+
+  // alpha = J^T a = Q^T L^-1 a
+  pb_.G.solveL(alpha, pb_.a);
+  Q.applyTransposeToTheLeft(alpha);
+  // beta = R^-T b_act
+  QR_.RTransposeSolve(beta, b_act);
+  // x = J1 beta - J2 alpha2 = L^-T Q [beta; -alpha2]
+  x.head(q) = beta;
+  x.tail(nbVar_ - q) = -alpha2;
+  Q.applyToTheLeft(x);
   pb_.G.solveInPlaceLTranspose(x);
-  x = -x;
-  f_ = 0.5 * pb_.a.dot(x);
+  // u = R^-1 (alpha1 + beta)
+  u = alpha1 + beta;
+  QR_.RSolve(u, u);
+
+  f_ = beta.dot(0.5 * beta + alpha1) - 0.5 * alpha2.squaredNorm();
+
+  JRLQP_LOG(log_, LogFlags::INIT | LogFlags::NO_ITER, alpha, beta, x, u, f_);
 
   return TerminationStatus::SUCCESS;
 }
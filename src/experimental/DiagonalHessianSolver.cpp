@@ -0,0 +1,44 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/experimental/DiagonalHessianSolver.h>
+
+namespace jrl::qp::experimental
+{
+DiagonalHessianSolver::DiagonalHessianSolver() : BlockGISolver()
+{
+  compactionRatio(0);
+  reserveHint(0);
+}
+
+DiagonalHessianSolver::DiagonalHessianSolver(int nbVar, int nbCstr, bool useBounds) : DiagonalHessianSolver()
+{
+  resize(nbVar, nbCstr, useBounds);
+}
+
+TerminationStatus DiagonalHessianSolver::solve(const VectorConstRef & g,
+                                               const VectorConstRef & a,
+                                               const MatrixConstRef & C,
+                                               const VectorConstRef & bl,
+                                               const VectorConstRef & bu,
+                                               const VectorConstRef & xl,
+                                               const VectorConstRef & xu,
+                                               const std::vector<ActivationStatus> & as)
+{
+  assert(C.rows() == g.size());
+
+  // The views are only rebuilt when the storage they refer to changes, so that solving
+  // problems of the same size with the same C storage does not allocate.
+  if(d_.cols() != g.size())
+  {
+    d_.resize(1, g.size());
+    G_ = structured::StructuredG(MatrixRef(d_));
+  }
+  d_.row(0) = g.transpose();
+
+  if(C_.nbBlocks() != 1 || C_.diag(0).data() != C.data() || C_.diag(0).rows() != C.rows()
+     || C_.diag(0).cols() != C.cols() || C_.diag(0).outerStride() != C.outerStride())
+    C_ = structured::StructuredC({C});
+
+  return BlockGISolver::solve(G_, a, C_, bl, bu, xl, xu, as);
+}
+} // namespace jrl::qp::experimental
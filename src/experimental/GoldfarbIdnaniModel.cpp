@@ -0,0 +1,294 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Cholesky>
+#include <Eigen/Jacobi>
+#include <jrl-qp/experimental/GoldfarbIdnaniModel.h>
+#include <jrl-qp/internal/ConstraintNormal.h>
+
+using Givens = Eigen::JacobiRotation<double>;
+
+namespace jrl::qp::experimental
+{
+GoldfarbIdnaniModel::GoldfarbIdnaniModel() : GoldfarbIdnaniSolver()
+{
+  options_.warmStart_ = true;
+}
+
+void GoldfarbIdnaniModel::setProblem(const MatrixConstRef & G,
+                                     const VectorConstRef & a,
+                                     const MatrixConstRef & C,
+                                     const VectorConstRef & bl,
+                                     const VectorConstRef & bu,
+                                     const VectorConstRef & xl,
+                                     const VectorConstRef & xu)
+{
+  int nbVar = static_cast<int>(G.rows());
+  int nbCstr = static_cast<int>(C.cols());
+  assert(G.cols() == nbVar);
+  assert(a.size() == nbVar);
+  assert(C.rows() == nbVar);
+  assert(bl.size() == nbCstr);
+  assert(bu.size() == nbCstr);
+  assert(xl.size() == nbVar || xl.size() == 0);
+  assert(xu.size() == xl.size());
+
+  G_ = G;
+  a_ = a;
+  C_ = C;
+  bl_ = bl;
+  bu_ = bu;
+  xl_ = xl;
+  xu_ = xu;
+  diagG_.resize(nbVar);
+
+  // The data are only modified in place from now on, so that pb_ can keep referring
+  // to them.
+  new(&pb_.G) MatrixRef(G_);
+  new(&pb_.a) VectorConstRef(a_);
+  new(&pb_.C) MatrixConstRef(C_);
+  new(&pb_.bl) VectorConstRef(bl_);
+  new(&pb_.bu) VectorConstRef(bu_);
+  new(&pb_.xl) VectorConstRef(xl_);
+  new(&pb_.xu) VectorConstRef(xu_);
+
+  resize(nbVar, nbCstr, xl.size() > 0);
+  A_.reset();
+  factorized_ = false;
+  resumable_ = false;
+  changedCols_.clear();
+  changedCols_.reserve(static_cast<size_t>(nbCstr));
+  colChanged_.assign(static_cast<size_t>(nbCstr), false);
+}
+
+void GoldfarbIdnaniModel::updateLinearTerm(const VectorConstRef & a)
+{
+  assert(a.size() == a_.size());
+  a_ = a;
+}
+
+void GoldfarbIdnaniModel::updateBounds(const VectorConstRef & bl, const VectorConstRef & bu)
+{
+  assert(bl.size() == bl_.size() && bu.size() == bu_.size());
+  bl_ = bl;
+  bu_ = bu;
+}
+
+void GoldfarbIdnaniModel::updateVarBounds(const VectorConstRef & xl, const VectorConstRef & xu)
+{
+  assert(xl_.size() > 0 && "The problem was set without bounds.");
+  assert(xl.size() == xl_.size() && xu.size() == xu_.size());
+  xl_ = xl;
+  xu_ = xu;
+}
+
+void GoldfarbIdnaniModel::updateConstraintColumns(const std::vector<int> & idx, const MatrixConstRef & cols)
+{
+  assert(cols.rows() == C_.rows() && cols.cols() == static_cast<int>(idx.size()));
+  for(size_t k = 0; k < idx.size(); ++k)
+  {
+    int i = idx[k];
+    C_.col(i) = cols.col(static_cast<int>(k));
+    if(!colChanged_[static_cast<size_t>(i)])
+    {
+      colChanged_[static_cast<size_t>(i)] = true;
+      changedCols_.push_back(i);
+    }
+  }
+}
+
+void GoldfarbIdnaniModel::updateHessian(const MatrixConstRef & U, const VectorConstRef & s)
+{
+  const int n = static_cast<int>(G_.rows());
+  assert(U.rows() == n && U.cols() == s.size());
+  if(!factorized_)
+  {
+    G_.noalias() += U * s.asDiagonal() * U.transpose();
+    return;
+  }
+
+  for(int k = 0; k < s.size(); ++k)
+  {
+    auto v = U.col(k);
+    // Keep G itself up to date in the upper part of G_, in case we need to decompose it
+    // again.
+    for(int j = 1; j < n; ++j) G_.col(j).head(j) += s[k] * v[j] * v.head(j);
+    diagG_.array() += s[k] * v.array().square();
+
+    if(factorized_ && Eigen::internal::llt_inplace<double, Eigen::Lower>::rankUpdate(G_, v, s[k]) >= 0)
+    {
+      factorized_ = false;
+      resumable_ = false;
+    }
+    if(resumable_) resumable_ = updateFactorization(v, s[k]);
+  }
+
+  if(!factorized_) restoreG();
+}
+
+TerminationStatus GoldfarbIdnaniModel::solve()
+{
+  JRLQP_LOG_RESET(log_);
+  JRLQP_LOG(log_, LogFlags::INPUT | LogFlags::NO_ITER, a_, C_, bl_, bu_, xl_, xu_);
+
+  auto ret = DualSolver::solve();
+  // At the end of a successful solve, the factorization corresponds to the active set
+  // and to the current C.
+  resumable_ = ret == TerminationStatus::SUCCESS;
+  for(int i : changedCols_) colChanged_[static_cast<size_t>(i)] = false;
+  changedCols_.clear();
+  return ret;
+}
+
+internal::InitTermination GoldfarbIdnaniModel::init_()
+{
+  if(options_.warmStart_)
+  {
+    // Kept for the fallback below, as updateChangedColumns modifies the active set.
+    pb_.as = A_.activationStatus();
+    if(resumable_ && activeSetConsistent() && updateChangedColumns())
+    {
+      initializeActiveBounds();
+      initializePrimalDualPoints();
+      deactivateNegativeMultipliers();
+      return TerminationStatus::SUCCESS;
+    }
+  }
+  else
+    pb_.as.clear();
+
+  JRLQP_DEBUG_ONLY(work_R_.setZero());
+  auto retAS = processInitialActiveSet();
+  if(!retAS) return retAS;
+
+  if(!factorized_)
+  {
+    diagG_ = pb_.G.diagonal();
+    if(Eigen::internal::llt_inplace<double, Eigen::Lower>::blocked(pb_.G) >= 0)
+    {
+      // Keep G for the next updates.
+      restoreG();
+      return TerminationStatus::NON_POS_HESSIAN;
+    }
+    factorized_ = true;
+  }
+
+  initializeComputationData();
+  initializePrimalDualPoints();
+  deactivateNegativeMultipliers();
+
+  return TerminationStatus::SUCCESS;
+}
+
+void GoldfarbIdnaniModel::restoreG()
+{
+  const int n = static_cast<int>(G_.rows());
+  for(int j = 0; j < n - 1; ++j) G_.col(j).tail(n - j - 1) = G_.row(j).tail(n - j - 1).transpose();
+  G_.diagonal() = diagG_;
+}
+
+bool GoldfarbIdnaniModel::activeSetConsistent() const
+{
+  const double big = options_.bigBnd_;
+  for(int i = 0; i < A_.nbCstr(); ++i)
+  {
+    auto s = A_.activationStatus(i);
+    if((bl_[i] == bu_[i]) != (s == ActivationStatus::EQUALITY)) return false;
+    if((s == ActivationStatus::LOWER && bl_[i] < -big) || (s == ActivationStatus::UPPER && bu_[i] > big)) return false;
+  }
+  for(int i = 0; i < A_.nbBnd(); ++i)
+  {
+    auto s = A_.activationStatusBnd(i);
+    if((xl_[i] == xu_[i]) != (s == ActivationStatus::FIXED)) return false;
+    if((s == ActivationStatus::LOWER_BOUND && xl_[i] < -big) || (s == ActivationStatus::UPPER_BOUND && xu_[i] > big))
+      return false;
+  }
+  return true;
+}
+
+bool GoldfarbIdnaniModel::updateChangedColumns()
+{
+  int maxUpdates = maxColumnUpdates_ >= 0 ? maxColumnUpdates_ : std::max(1, nbVar_ / 4);
+  auto nbActiveChanged =
+      std::count_if(changedCols_.begin(), changedCols_.end(), [this](int i) { return A_.isActive(i); });
+  if(nbActiveChanged > maxUpdates) return false;
+
+  auto J = work_J_.asMatrix(nbVar_, nbVar_, nbVar_);
+  for(int i : changedCols_)
+  {
+    if(!A_.isActive(i)) continue;
+    int l = 0;
+    while(A_[l] != i) ++l;
+    auto s = A_.activationStatus(i);
+    A_.deactivate(l);
+    removeConstraint_(l);
+
+    // Same as an addition during the iterations: d = J^T n, then the QR is updated.
+    A_.activate(i, s);
+    int q = A_.nbActiveCstr();
+    auto d = work_d_.asVector(nbVar_);
+    internal::ConstraintNormal np(pb_.C, i, s);
+    np.preMultiplyByMt(d, J);
+    if(d.tail(nbVar_ - q + 1).norm() <= 1e-12 * d.norm()) return false; //[NUMERIC] better criterion
+    addConstraint_({i, s});
+  }
+  return true;
+}
+
+bool GoldfarbIdnaniModel::updateFactorization(const VectorConstRef & v, double sigma)
+{
+  int q = A_.nbActiveCstr();
+  auto J = work_J_.asMatrix(nbVar_, nbVar_, nbVar_);
+  // Rows of [R; 0] affected by the update: row q gets filled during the first sweep.
+  auto R = work_R_.asMatrix(std::min(q + 1, nbVar_), q, nbVar_);
+  auto p = work_d_.asVector(nbVar_);
+  auto Jp = work_hCoeffs_.asVector(nbVar_);
+  auto w = work_tmp_.asVector(q);
+
+  p.noalias() = J.transpose() * v;
+  double s2 = p.squaredNorm();
+  double c = 1 + sigma * s2;
+  if(c <= 1e-12) return false; //[NUMERIC] better criterion
+  if(s2 == 0) return true;
+
+  // (J (I + beta p p^T)) (J (I + beta p p^T))^T = J J^T - sigma (J p) (J p)^T / c, which is
+  // the inverse of G + sigma v v^T by the Sherman-Morrison formula.
+  double beta = (1 / std::sqrt(c) - 1) / s2;
+  Jp.noalias() = J * p;
+  J.noalias() += beta * Jp * p.transpose();
+  if(q == 0) return true;
+
+  // (I + beta p p^T) [R; 0] = [R; 0] + p w^T
+  w.noalias() = R.topRows(q).template triangularView<Eigen::Upper>().transpose() * p.head(q);
+  w *= beta;
+  // The sweeps below rotate whole rows of R, so that the part below its diagonal must be
+  // zero. It is not guaranteed by the solver (it holds e.g. the Householder vectors of the
+  // initial QR outside of debug builds). This also zeroes row q.
+  R.template triangularView<Eigen::StrictlyLower>().setZero();
+
+  // Rotate p to a multiple of e1. [R; 0] becomes upper Hessenberg.
+  for(int i = nbVar_ - 2; i >= 0; --i)
+  {
+    Givens Qi;
+    Qi.makeGivens(p[i], p[i + 1], &p[i]);
+    p[i + 1] = 0;
+    if(i < q) R.applyOnTheLeft(i, i + 1, Qi.transpose());
+    J.applyOnTheRight(i, i + 1, Qi);
+  }
+  R.row(0) += p[0] * w.transpose();
+
+  // Back to upper triangular
+  for(int i = 0; i < std::min(q, nbVar_ - 1); ++i)
+  {
+    Givens Qi;
+    Qi.makeGivens(R(i, i), R(i + 1, i), &R(i, i));
+    R(i + 1, i) = 0;
+    R.rightCols(q - i - 1).applyOnTheLeft(i, i + 1, Qi.transpose());
+    J.applyOnTheRight(i, i + 1, Qi);
+  }
+
+  return true;
+}
+} // namespace jrl::qp::experimental
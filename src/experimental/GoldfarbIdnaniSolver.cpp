@@ -79,33 +79,7 @@ internal::InitTermination GoldfarbIdnaniSolver::init_()
   initializeComputationData();
   initializePrimalDualPoints();
 
-  // If some constraints have ben activated with u<0, we deactivate them
-  while(true)
-  {
-    int q = A_.nbActiveCstr();
-    WVector u = work_u_.asVector(q);
-    WVector b_act = work_bact_.asVector(q);
-    double umin = -1e-14; // [Numerics] Do better.
-    int lmin = -1;
-    for(int l = 0; l < q; ++l)
-    {
-      int i = A_[l];
-      if(u[l] < umin && A_.activationStatus(i) != ActivationStatus::FIXED
-         && A_.activationStatus(i) != ActivationStatus::EQUALITY)
-      {
-        umin = u[l];
-        lmin = l;
-      }
-    }
-    if(lmin < 0) break; // no more constraint to deactivate
-
-    ++it_;
-    b_act.segment(lmin, q - 1 - lmin) = b_act.tail(q - 1 - lmin);
-    JRLQP_DEBUG_ONLY(u[q - 1] = 0);
-    A_.deactivate(lmin);
-    removeConstraint_(lmin);
-    initializePrimalDualPoints();
-  }
+  deactivateNegativeMultipliers();
 
   return TerminationStatus::SUCCESS;
 }
@@ -290,7 +264,7 @@ double GoldfarbIdnaniSolver::dot_(const internal::SelectedConstraint & sc, const
   return np.dot(z);
 }
 
-void GoldfarbIdnaniSolver::resize_(int nbVar, int /*nbCstr*/, bool /*useBounds*/)
+void GoldfarbIdnaniSolver::resize_(int nbVar, int nbCstr, bool useBounds)
 {
   if(nbVar != nbVar_)
   {
@@ -301,6 +275,8 @@ void GoldfarbIdnaniSolver::resize_(int nbVar, int /*nbCstr*/, bool /*useBounds*/
     work_hCoeffs_.resize(nbVar);
     work_bact_.resize(nbVar);
   }
+  // So that copying the warm start data does not allocate
+  pb_.as.reserve(static_cast<size_t>(nbCstr + (useBounds ? nbVar : 0)));
 }
 
 internal::TerminationType GoldfarbIdnaniSolver::processInitialActiveSet()
@@ -349,7 +325,7 @@ internal::TerminationType GoldfarbIdnaniSolver::processInitialActiveSet()
     {
       auto s = pb_.as[i];
       assert(s <= ActivationStatus::EQUALITY);
-      if(s == ActivationStatus::FIXED)
+      if(s == ActivationStatus::EQUALITY)
       {
         JRLQP_LOG_COMMENT(log_, LogFlags::ACTIVE_SET, "Ignoring activation status for constraint ", i);
       }
@@ -389,13 +365,72 @@ internal::TerminationType GoldfarbIdnaniSolver::processInitialActiveSet()
   return TerminationStatus::SUCCESS;
 }
 
+void GoldfarbIdnaniSolver::deactivateNegativeMultipliers()
+{
+  // If some constraints have ben activated with u<0, we deactivate them
+  while(true)
+  {
+    int q = A_.nbActiveCstr();
+    WVector u = work_u_.asVector(q);
+    WVector b_act = work_bact_.asVector(q);
+    double umin = -1e-14; // [Numerics] Do better.
+    int lmin = -1;
+    for(int l = 0; l < q; ++l)
+    {
+      int i = A_[l];
+      if(u[l] < umin && A_.activationStatus(i) != ActivationStatus::FIXED
+         && A_.activationStatus(i) != ActivationStatus::EQUALITY)
+      {
+        umin = u[l];
+        lmin = l;
+      }
+    }
+    if(lmin < 0) break; // no more constraint to deactivate
+
+    ++it_;
+    b_act.segment(lmin, q - 1 - lmin) = b_act.tail(q - 1 - lmin);
+    JRLQP_DEBUG_ONLY(u[q - 1] = 0);
+    A_.deactivate(lmin);
+    removeConstraint_(lmin);
+    initializePrimalDualPoints();
+  }
+}
+
+void GoldfarbIdnaniSolver::initializeActiveBounds()
+{
+  int q = A_.nbActiveCstr();
+  auto b_act = work_bact_.asVector(q);
+  for(int i = 0; i < q; ++i)
+  {
+    int cstrIdx = A_[i];
+    switch(A_.activationStatus(cstrIdx))
+    {
+      case ActivationStatus::LOWER: // fallthrough
+      case ActivationStatus::EQUALITY:
+        b_act[i] = pb_.bl(cstrIdx);
+        break;
+      case ActivationStatus::UPPER:
+        b_act[i] = -pb_.bu(cstrIdx);
+        break;
+      case ActivationStatus::LOWER_BOUND: // fallthrough
+      case ActivationStatus::FIXED:
+        b_act[i] = pb_.xl(cstrIdx - A_.nbCstr());
+        break;
+      case ActivationStatus::UPPER_BOUND:
+        b_act[i] = -pb_.xu(cstrIdx - A_.nbCstr());
+        break;
+      default:
+        break;
+    }
+  }
+}
+
 internal::TerminationType GoldfarbIdnaniSolver::initializeComputationData()
 {
   auto L = pb_.G.template triangularView<Eigen::Lower>();
 
   int q = A_.nbActiveCstr();
   auto N = work_R_.asMatrix(nbVar_, q, nbVar_);
-  auto b_act = work_bact_.asVector(q);
   for(int i = 0; i < q; ++i)
   {
     int cstrIdx = A_[i];
@@ -404,27 +439,24 @@ internal::TerminationType GoldfarbIdnaniSolver::initializeComputationData()
       case ActivationStatus::LOWER: // fallthrough
       case ActivationStatus::EQUALITY:
         N.col(i) = pb_.C.col(cstrIdx);
-        b_act[i] = pb_.bl(cstrIdx);
         break;
       case ActivationStatus::UPPER:
         N.col(i) = -pb_.C.col(cstrIdx);
-        b_act[i] = -pb_.bu(cstrIdx);
         break;
       case ActivationStatus::LOWER_BOUND: // fallthrough
       case ActivationStatus::FIXED:
         N.col(i).setZero();
         N.col(i)[cstrIdx - A_.nbCstr()] = 1;
-        b_act[i] = pb_.xl(cstrIdx - A_.nbCstr());
         break;
       case ActivationStatus::UPPER_BOUND:
         N.col(i).setZero();
         N.col(i)[cstrIdx - A_.nbCstr()] = -1;
-        b_act[i] = -pb_.xu(cstrIdx - A_.nbCstr());
         break;
       default:
         break;
     }
   }
+  initializeActiveBounds();
 
   // J = L^-t
   auto J = work_J_.asMatrix(nbVar_, nbVar_, nbVar_);
@@ -438,22 +470,24 @@ internal::TerminationType GoldfarbIdnaniSolver::initializeComputationData()
                      //  done in place with Eigen)
 
   // QR in place
-  Eigen::Map<Eigen::VectorXd> hCoeffs(work_hCoeffs_.asVector(q).data(),
-                                      q); // Should be simply hCoeffs = work_hCoeffs_.asVector(q), but his does compile
-                                          // with householder_qr_inplace_blocked
+  // We use the unblocked version of the decomposition and apply the reflectors one by
+  // one: the blocked versions allocate temporary matrices. The number of active
+  // constraints at initialization is usually small, so that blocking would not bring
+  // much anyway.
+  WVector hCoeffs = work_hCoeffs_.asVector(q);
   WVector tmp = work_tmp_.asVector(nbVar_);
-  bool b = Eigen::internal::is_malloc_allowed();
-  Eigen::internal::set_is_malloc_allowed(true);
-  Eigen::internal::householder_qr_inplace_blocked<decltype(N), decltype(hCoeffs)>::run(N, hCoeffs, 48, tmp.data());
+  Eigen::internal::householder_qr_inplace_unblocked(N, hCoeffs, tmp.data());
 
   // J = J*Q
-  Eigen::HouseholderSequence Q(N, hCoeffs);
-  Q.applyThisOnTheRight(J, tmp);
-  Eigen::internal::set_is_malloc_allowed(b);
+  for(int k = 0; k < q; ++k)
+  {
+    J.rightCols(nbVar_ - k).applyHouseholderOnTheRight(N.col(k).tail(nbVar_ - k - 1), hCoeffs[k], tmp.data());
+  }
 
   // Set lower part of R to 0
   JRLQP_DEBUG_ONLY(for(int i = 0; i < q; ++i) N.col(i).tail(nbVar_ - i - 1).setZero(););
 
+  WVector b_act = work_bact_.asVector(q);
   JRLQP_LOG(log_, LogFlags::INIT | LogFlags::NO_ITER, N, J, b_act);
 
   return TerminationStatus::SUCCESS;
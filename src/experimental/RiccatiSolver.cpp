@@ -0,0 +1,709 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <algorithm>
+#include <cmath>
+
+#include <jrl-qp/experimental/RiccatiSolver.h>
+#include <jrl-qp/internal/blockKernels.h>
+
+namespace
+{
+using namespace jrl::qp;
+
+/** Sign of the constraint normal for a given activation status.*/
+double sign(ActivationStatus status)
+{
+  return status == ActivationStatus::UPPER || status == ActivationStatus::UPPER_BOUND ? -1 : 1;
+}
+} // namespace
+
+namespace jrl::qp::experimental
+{
+RiccatiSolver::RiccatiSolver() : DualSolver() {}
+
+RiccatiSolver::RiccatiSolver(int nx, int nu, int N, int nbCstr, bool useBounds) : RiccatiSolver()
+{
+  resizeStages(nx, nu, N);
+  resize(N * (nx + nu) + nx, nbCstr, useBounds);
+}
+
+TerminationStatus RiccatiSolver::solve(const std::vector<MatrixConstRef> & H,
+                                       const VectorConstRef & a,
+                                       const std::vector<MatrixConstRef> & F,
+                                       const VectorConstRef & c,
+                                       const VectorConstRef & x0,
+                                       const std::vector<MatrixConstRef> & C,
+                                       const VectorConstRef & bl,
+                                       const VectorConstRef & bu,
+                                       const VectorConstRef & xl,
+                                       const VectorConstRef & xu,
+                                       const std::vector<ActivationStatus> & as)
+{
+  int N = static_cast<int>(F.size());
+  int nx = static_cast<int>(x0.size());
+  int nu = N > 0 ? static_cast<int>(F[0].cols()) - nx : 0;
+  int nbVar = N * (nx + nu) + nx;
+  int nbCstr = static_cast<int>(bl.size());
+  bool useBnd = xl.size() > 0;
+
+  JRLQP_LOG_RESET(log_);
+  JRLQP_LOG(log_, LogFlags::INPUT | LogFlags::NO_ITER, a, c, x0, bl, bu, xl, xu, as);
+
+  // Check coherence of the input sizes
+  assert(N > 0 && nu > 0);
+  assert(H.size() == F.size() + 1);
+  assert(C.size() == F.size() + 1);
+  assert(a.size() == nbVar);
+  assert(c.size() == N * nx);
+  assert(bu.size() == nbCstr);
+  assert(xl.size() == nbVar || xl.size() == 0);
+  assert(xu.size() == xl.size());
+  assert(static_cast<int>(as.size()) == nbCstr + xl.size() || as.size() == 0);
+  assert(options_.warmStart_ || (as.empty() && "Non-empty active set used with cold start option."));
+
+  pb_.H.clear();
+  std::copy(H.begin(), H.end(), std::back_inserter(pb_.H));
+  new(&pb_.a) VectorConstRef(a);
+  pb_.F.clear();
+  std::copy(F.begin(), F.end(), std::back_inserter(pb_.F));
+  new(&pb_.c) VectorConstRef(c);
+  new(&pb_.x0) VectorConstRef(x0);
+  pb_.C.clear();
+  std::copy(C.begin(), C.end(), std::back_inserter(pb_.C));
+  new(&pb_.bl) VectorConstRef(bl);
+  new(&pb_.bu) VectorConstRef(bu);
+  new(&pb_.xl) VectorConstRef(xl);
+  new(&pb_.xu) VectorConstRef(xu);
+
+  resizeStages(nx, nu, N);
+  resize(nbVar, nbCstr, useBnd);
+  cstrStart_.resize(static_cast<size_t>(N) + 2);
+  toStage_.resize(static_cast<size_t>(nbCstr));
+  cstrStart_[0] = 0;
+  for(int k = 0; k <= N; ++k)
+  {
+    int mk = static_cast<int>(C[static_cast<size_t>(k)].cols());
+    assert(C[static_cast<size_t>(k)].rows() == (k < N ? nx + nu : nx));
+    std::fill_n(toStage_.begin() + cstrStart_[static_cast<size_t>(k)], mk, k);
+    cstrStart_[static_cast<size_t>(k) + 1] = cstrStart_[static_cast<size_t>(k)] + mk;
+  }
+  assert(cstrStart_.back() == nbCstr);
+
+  if(options_.warmStart_)
+  {
+    pb_.as = as.empty() ? A_.activationStatus() : as;
+  }
+
+  return DualSolver::solve();
+}
+
+void RiccatiSolver::resizeStages(int nx, int nu, int N)
+{
+  if(nx == nx_ && nu == nu_ && N == N_) return;
+  nx_ = nx;
+  nu_ = nu;
+  N_ = N;
+  maxActive_ = N * nu;
+  int ns = nx + nu;
+  work_P_.resize((N + 1) * nx * nx);
+  work_Lk_.resize(N * nu * nu);
+  work_Y_.resize(N * nu * nx);
+  work_tmp_.resize(ns * ns + nx * ns);
+  work_p_.resize(2 * nx);
+  work_L_.resize(maxActive_ * maxActive_);
+  work_l_.resize(maxActive_ + 1);
+  cstrStart_.reserve(static_cast<size_t>(N) + 2);
+}
+
+internal::InitTermination RiccatiSolver::init_()
+{
+  // Decide the initial active set given the data and the options
+  auto retAS = processInitialActiveSet();
+  if(!retAS) return retAS;
+
+  if(!factorize()) return TerminationStatus::NON_POS_HESSIAN;
+
+  // Unconstrained solution
+  auto xunc = work_xunc_.asVector(nbVar_, {});
+  riccatiSolve(xunc, pb_.a, true);
+
+  auto retData = initializeComputationData();
+  if(!retData) return retData;
+  initializePrimalDualPoints();
+
+  // If some constraints have ben activated with u<0, we deactivate them
+  while(true)
+  {
+    int q = A_.nbActiveCstr();
+    WVector u = work_u_.asVector(q);
+    WVector b_act = work_bact_.asVector(q);
+    double umin = -1e-14; // [Numerics] Do better.
+    int lmin = -1;
+    for(int l = 0; l < q; ++l)
+    {
+      int i = A_[l];
+      if(u[l] < umin && A_.activationStatus(i) != ActivationStatus::FIXED
+         && A_.activationStatus(i) != ActivationStatus::EQUALITY)
+      {
+        umin = u[l];
+        lmin = l;
+      }
+    }
+    if(lmin < 0) break; // no more constraint to deactivate
+
+    ++it_;
+    b_act.segment(lmin, q - 1 - lmin) = b_act.tail(q - 1 - lmin);
+    A_.deactivate(lmin);
+    removeConstraint_(lmin);
+    initializePrimalDualPoints();
+  }
+
+  return TerminationStatus::SUCCESS;
+}
+
+bool RiccatiSolver::factorize()
+{
+  int nx = nx_;
+  int nu = nu_;
+  int ns = nx + nu;
+  using Map = Eigen::Map<Eigen::MatrixXd>;
+  double * P = work_P_.asVector((N_ + 1) * nx * nx, {}).data();
+  double * L = work_Lk_.asVector(N_ * nu * nu, {}).data();
+  double * Y = work_Y_.asVector(N_ * nu * nx, {}).data();
+  double * tmp = work_tmp_.asVector(ns * ns + nx * ns, {}).data();
+
+  // P_N = H_N
+  Map(P + N_ * nx * nx, nx, nx) = pb_.H.back();
+  for(int k = N_ - 1; k >= 0; --k)
+  {
+    const auto & Fk = pb_.F[static_cast<size_t>(k)];
+    Map Pk1(P + (k + 1) * nx * nx, nx, nx);
+    Map M(tmp, ns, ns);
+    Map T(tmp + ns * ns, nx, ns);
+    Map Lk(L + k * nu * nu, nu, nu);
+    Map Yk(Y + k * nu * nx, nu, nx);
+
+    // M = H_k + F_k^T P_{k+1} F_k
+    T.noalias() = Pk1 * Fk;
+    M = pb_.H[static_cast<size_t>(k)];
+    M.noalias() += Fk.transpose() * T;
+
+    // L_k L_k^T = M_uu, Y_k = L_k^-1 M_ux
+    Lk = M.bottomRightCorner(nu, nu);
+    if(!internal::blockLLT(Lk)) return false;
+    Yk = M.bottomLeftCorner(nu, nx);
+    internal::blockSolveLLeft(Lk, Yk);
+
+    // P_k = M_xx - Y_k^T Y_k
+    if(k > 0)
+    {
+      Map Pk(P + k * nx * nx, nx, nx);
+      Pk = M.topLeftCorner(nx, nx);
+      Pk.noalias() -= Yk.transpose() * Yk;
+    }
+  }
+  return true;
+}
+
+void RiccatiSolver::riccatiSolve(VectorRef y, const VectorConstRef & l, bool affine) const
+{
+  // Backward pass: with p_{k+1} the linear term of the cost-to-go at stage k+1,
+  //   h = P_{k+1} c_k + p_{k+1}
+  //   [m_x; m_u] = l_k + F_k^T h
+  //   d_k = L_k^-1 m_u
+  //   p_k = m_x - Y_k^T d_k
+  // d_k is stored in the slot of u_k in y.
+  // Forward pass:
+  //   u_k = -L_k^-T (Y_k x_k + d_k)
+  //   x_{k+1} = F_k y_k + c_k
+  int nx = nx_;
+  int nu = nu_;
+  int ns = nx + nu;
+  using CMap = Eigen::Map<const Eigen::MatrixXd>;
+  auto P = [&](int k) { return CMap(work_P_.asVector((N_ + 1) * nx * nx).data() + k * nx * nx, nx, nx); };
+  auto L = [&](int k) { return CMap(work_Lk_.asVector(N_ * nu * nu).data() + k * nu * nu, nu, nu); };
+  auto Y = [&](int k) { return CMap(work_Y_.asVector(N_ * nu * nx).data() + k * nu * nx, nu, nx); };
+  auto ph = work_p_.asVector(2 * nx, {});
+  auto p = ph.head(nx);
+  auto h = ph.tail(nx);
+
+  p = l.tail(nx);
+  for(int k = N_ - 1; k >= 0; --k)
+  {
+    const auto & Fk = pb_.F[static_cast<size_t>(k)];
+    auto yk = y.segment(k * ns, ns);
+    auto mu = yk.tail(nu);
+    h = p;
+    if(affine) h.noalias() += P(k + 1) * pb_.c.segment(k * nx, nx);
+    yk = l.segment(k * ns, ns);
+    yk.noalias() += Fk.transpose() * h;
+    L(k).triangularView<Eigen::Lower>().solveInPlace(mu);
+    p = yk.head(nx);
+    p.noalias() -= Y(k).transpose() * mu;
+  }
+
+  if(affine)
+    y.head(nx) = pb_.x0;
+  else
+    y.head(nx).setZero();
+  for(int k = 0; k < N_; ++k)
+  {
+    const auto & Fk = pb_.F[static_cast<size_t>(k)];
+    auto yk = y.segment(k * ns, ns);
+    auto uk = yk.tail(nu);
+    uk.noalias() += Y(k) * yk.head(nx);
+    L(k).transpose().triangularView<Eigen::Upper>().solveInPlace(uk);
+    uk = -uk;
+    auto xk1 = y.segment((k + 1) * ns, nx);
+    xk1.noalias() = Fk * yk;
+    if(affine) xk1 += pb_.c.segment(k * nx, nx);
+  }
+}
+
+bool RiccatiSolver::onInitialStateOnly(int i) const
+{
+  if(i >= A_.nbCstr()) return i - A_.nbCstr() < nx_;
+  if(i >= cstrStart_[1]) return false;
+  return pb_.C[0].col(i).tail(nu_).isZero(0);
+}
+
+double RiccatiSolver::cstrDot(int i, ActivationStatus status, const VectorConstRef & y) const
+{
+  if(i >= A_.nbCstr()) return sign(status) * y[i - A_.nbCstr()];
+
+  int k = toStage_[static_cast<size_t>(i)];
+  const auto & Ck = pb_.C[static_cast<size_t>(k)];
+  int j = i - cstrStart_[static_cast<size_t>(k)];
+  return sign(status) * Ck.col(j).dot(y.segment(k * (nx_ + nu_), Ck.rows()));
+}
+
+void RiccatiSolver::addCstr(VectorRef y, int i, ActivationStatus status, double s) const
+{
+  s *= sign(status);
+  if(i >= A_.nbCstr())
+  {
+    y[i - A_.nbCstr()] += s;
+    return;
+  }
+
+  int k = toStage_[static_cast<size_t>(i)];
+  const auto & Ck = pb_.C[static_cast<size_t>(k)];
+  int j = i - cstrStart_[static_cast<size_t>(k)];
+  y.segment(k * (nx_ + nu_), Ck.rows()) += s * Ck.col(j);
+}
+
+double RiccatiSolver::objective(const VectorConstRef & y) const
+{
+  int ns = nx_ + nu_;
+  double f = pb_.a.dot(y);
+  for(int k = 0; k <= N_; ++k)
+  {
+    const auto & Hk = pb_.H[static_cast<size_t>(k)];
+    auto yk = y.segment(k * ns, Hk.rows());
+    f += 0.5 * yk.dot(Hk * yk);
+  }
+  return f;
+}
+
+bool RiccatiSolver::appendToFactor(int q, const VectorConstRef & l, double delta)
+{
+  // The new row of L is [l^T, sqrt(delta - |l|^2)]
+  double d2 = delta - l.squaredNorm();
+  if(!(d2 > 0)) return false;
+  auto L = work_L_.asMatrix(q + 1, q + 1, maxActive_, {});
+  L.row(q).head(q) = l.transpose();
+  L(q, q) = std::sqrt(d2);
+  return true;
+}
+
+internal::SelectedConstraint RiccatiSolver::selectViolatedConstraint_(const VectorConstRef & x) const
+{
+  // We look for the constraint with the maximum violation
+  double smin = 0;
+  int p = -1;
+  ActivationStatus status = ActivationStatus::INACTIVE;
+
+  int ns = nx_ + nu_;
+  WVector cx = work_cx_.asVector(A_.nbCstr());
+  for(int k = 0; k <= N_; ++k)
+  {
+    const auto & Ck = pb_.C[static_cast<size_t>(k)];
+    cx.segment(cstrStart_[static_cast<size_t>(k)], Ck.cols()).noalias() =
+        Ck.transpose() * x.segment(k * ns, Ck.rows());
+  }
+
+  // Check general constraints. Those on x_0 only were checked by processInitialActiveSet.
+  for(int i = 0; i < A_.nbCstr(); ++i)
+  {
+    if(!A_.isActive(i) && !onInitialStateOnly(i))
+    {
+      if(double sl = cx[i] - pb_.bl[i]; sl < smin)
+      {
+        smin = sl;
+        p = i;
+        status = ActivationStatus::LOWER;
+      }
+      else if(double su = pb_.bu[i] - cx[i]; su < smin)
+      {
+        smin = su;
+        p = i;
+        status = ActivationStatus::UPPER;
+      }
+    }
+  }
+
+  // Check bound constraints, except the ones on x_0
+  for(int i = std::min(nx_, A_.nbBnd()); i < A_.nbBnd(); ++i)
+  {
+    if(!A_.isActiveBnd(i))
+    {
+      if(double sl = x[i] - pb_.xl[i]; sl < smin)
+      {
+        smin = sl;
+        p = A_.nbCstr() + i;
+        status = ActivationStatus::LOWER_BOUND;
+      }
+      else if(double su = pb_.xu[i] - x[i]; su < smin)
+      {
+        smin = su;
+        p = A_.nbCstr() + i;
+        status = ActivationStatus::UPPER_BOUND;
+      }
+    }
+  }
+
+  return {p, status};
+}
+
+void RiccatiSolver::computeStep_(VectorRef z, VectorRef r, const internal::SelectedConstraint & sc) const
+{
+  // With w = P n+, the dual step is r = (N^T P N)^-1 N^T w and the primal step is
+  // z = w - P N r.
+  int q = A_.nbActiveCstr();
+  auto g = work_g_.asVector(nbVar_, {});
+  auto w = work_w_.asVector(nbVar_, {});
+  auto l = work_l_.asVector(q, {});
+
+  // w = P n+ is the solution for the linear term -n+
+  g.setZero();
+  addCstr(g, sc.index(), sc.status(), -1);
+  riccatiSolve(w, g, false);
+  delta_ = cstrDot(sc.index(), sc.status(), w);
+
+  // l = L^-1 N^T w, r = L^-T l
+  for(int j = 0; j < q; ++j) l[j] = cstrDot(A_[j], A_.activationStatus(A_[j]), w);
+  getL(q).solveInPlace(l);
+  r = l;
+  getL(q).transpose().solveInPlace(r);
+
+  if(q > 0)
+  {
+    // z = w - P N r
+    g.setZero();
+    for(int j = 0; j < q; ++j) addCstr(g, A_[j], A_.activationStatus(A_[j]), -r[j]);
+    riccatiSolve(z, g, false);
+    z = w - z;
+  }
+  else
+  {
+    z = w;
+  }
+}
+
+DualSolver::StepLength RiccatiSolver::computeStepLength_(const internal::SelectedConstraint & sc,
+                                                         const VectorConstRef & x,
+                                                         const VectorConstRef & u,
+                                                         const VectorConstRef & z,
+                                                         const VectorConstRef & r) const
+{
+  double t1 = options_.bigBnd_;
+  double t2 = options_.bigBnd_;
+  int l = 0;
+
+  for(int k = 0; k < A_.nbActiveCstr(); ++k)
+  {
+    auto s = A_.activationStatus(A_[k]);
+    if(s != ActivationStatus::EQUALITY && s != ActivationStatus::FIXED && r[k] > 0)
+    {
+      if(double tk = u[k] / r[k]; tk < t1)
+      {
+        t1 = tk;
+        l = k;
+      }
+    }
+  }
+
+  if(z.norm() > 1e-14) //[NUMERIC] better criterion
+  {
+    double b;
+    switch(sc.status())
+    {
+      case ActivationStatus::LOWER:
+        b = pb_.bl[sc.index()];
+        break;
+      case ActivationStatus::UPPER:
+        b = pb_.bu[sc.index()];
+        break;
+      case ActivationStatus::LOWER_BOUND:
+        b = pb_.xl[sc.index() - A_.nbCstr()];
+        break;
+      case ActivationStatus::UPPER_BOUND:
+        b = pb_.xu[sc.index() - A_.nbCstr()];
+        break;
+      default:
+        assert(false);
+        b = 0;
+    }
+    // The signs of the normal cancel out.
+    t2 = (b - cstrDot(sc.index(), ActivationStatus::LOWER, x)) / cstrDot(sc.index(), ActivationStatus::LOWER, z);
+  }
+
+  return {t1, t2, l};
+}
+
+bool RiccatiSolver::addConstraint_(const internal::SelectedConstraint & /*sc*/)
+{
+  // The constraint was already activated in A_. l and delta_ were computed by
+  // computeStep_.
+  int q = A_.nbActiveCstr() - 1;
+  return appendToFactor(q, work_l_.asVector(q), delta_);
+}
+
+bool RiccatiSolver::removeConstraint_(int l)
+{
+  // Removing row and column l of N^T P N = L L^T gives L' L'^T + c c^T, where L' is L
+  // without its row and column l and c is the column l of L without its first l+1
+  // elements (placed in the trailing rows). The trailing block of L' is thus updated by
+  // a rank-one update.
+  int q = A_.nbActiveCstr();
+  auto L = work_L_.asMatrix(q + 1, q + 1, maxActive_, {});
+  int n = q - l;
+  auto c = work_l_.asVector(n, {});
+  c = L.col(l).tail(n);
+
+  // Remove row l and column l. We copy element by element, as source and destination
+  // overlap.
+  for(int j = 0; j < q; ++j)
+  {
+    int sj = j < l ? j : j + 1;
+    for(int i = std::max(j, l); i < q; ++i) L(i, j) = L(i + 1, sj);
+  }
+
+  // Rank-one update of the trailing block
+  auto T = L.block(l, l, n, n);
+  for(int k = 0; k < n; ++k)
+  {
+    double rk = std::hypot(T(k, k), c[k]);
+    double ck = rk / T(k, k);
+    double sk = c[k] / T(k, k);
+    T(k, k) = rk;
+    int m = n - k - 1;
+    T.col(k).tail(m) = (T.col(k).tail(m) + sk * c.tail(m)) / ck;
+    c.tail(m) = ck * c.tail(m) - sk * T.col(k).tail(m);
+  }
+  return true;
+}
+
+double RiccatiSolver::dot_(const internal::SelectedConstraint & sc, const VectorConstRef & z)
+{
+  return cstrDot(sc.index(), sc.status(), z);
+}
+
+void RiccatiSolver::resize_(int nbVar, int nbCstr, bool useBounds)
+{
+  if(nbVar != nbVar_)
+  {
+    work_g_.resize(nbVar);
+    work_w_.resize(nbVar);
+    work_xunc_.resize(nbVar);
+    work_bact_.resize(nbVar);
+  }
+  if(nbCstr != A_.nbCstr())
+  {
+    work_cx_.resize(nbCstr);
+    toStage_.reserve(static_cast<size_t>(nbCstr));
+  }
+  // So that copying the warm start data does not allocate
+  pb_.as.reserve(static_cast<size_t>(nbCstr + (useBounds ? nbVar : 0)));
+}
+
+internal::TerminationType RiccatiSolver::processInitialActiveSet()
+{
+  A_.reset();
+
+  // The constraints on x_0 only are checked against x0, and are not activated below.
+  auto violated = [](double v, double l, double u) {
+    double tol = 1e-12 * (1 + std::abs(v)); //[NUMERIC] better criterion
+    return v < l - tol || v > u + tol;
+  };
+  for(int i = 0; i < cstrStart_[1]; ++i)
+  {
+    if(onInitialStateOnly(i) && violated(pb_.C[0].col(i).head(nx_).dot(pb_.x0), pb_.bl[i], pb_.bu[i]))
+      return TerminationStatus::INFEASIBLE;
+  }
+  for(int i = 0; i < std::min(nx_, A_.nbBnd()); ++i)
+  {
+    if(violated(pb_.x0[i], pb_.xl[i], pb_.xu[i])) return TerminationStatus::INFEASIBLE;
+  }
+
+  // Same as BlockGISolver::processInitialActiveSet
+  for(int i = std::min(nx_, A_.nbBnd()); i < A_.nbBnd(); ++i)
+  {
+    int bi = A_.nbCstr() + i;
+    if(pb_.xl[i] == pb_.xu[i])
+    {
+      A_.activate(bi, ActivationStatus::FIXED);
+    }
+    else if(!pb_.as.empty() && options_.warmStart_ && pb_.as[bi] != ActivationStatus::INACTIVE)
+    {
+      auto s = pb_.as[bi];
+      assert(s > ActivationStatus::EQUALITY);
+      if(s == ActivationStatus::FIXED)
+      {
+        JRLQP_LOG_COMMENT(log_, LogFlags::ACTIVE_SET, "Ignoring activation status for bound ", i,
+                          " (bounds not equal)");
+      }
+      else
+      {
+        if((s == ActivationStatus::LOWER_BOUND && pb_.xl[i] < -options_.bigBnd_)
+           || (s == ActivationStatus::UPPER_BOUND && pb_.xu[i] > +options_.bigBnd_))
+          JRLQP_LOG_COMMENT(log_, LogFlags::ACTIVE_SET, "Ignoring activation status for bound ", i,
+                            " (infinite bound)");
+        else
+          A_.activate(bi, s);
+      }
+    }
+  }
+  for(int i = 0; i < A_.nbCstr(); ++i)
+  {
+    if(onInitialStateOnly(i)) continue;
+    if(pb_.bl[i] == pb_.bu[i])
+    {
+      A_.activate(i, ActivationStatus::EQUALITY);
+    }
+    else if(!pb_.as.empty() && options_.warmStart_ && pb_.as[i] != ActivationStatus::INACTIVE)
+    {
+      auto s = pb_.as[i];
+      assert(s <= ActivationStatus::EQUALITY);
+      if(s == ActivationStatus::EQUALITY)
+      {
+        JRLQP_LOG_COMMENT(log_, LogFlags::ACTIVE_SET, "Ignoring activation status for constraint ", i);
+      }
+      else
+      {
+        if((s == ActivationStatus::LOWER && pb_.bl[i] < -options_.bigBnd_)
+           || (s == ActivationStatus::UPPER && pb_.bu[i] > +options_.bigBnd_))
+          JRLQP_LOG_COMMENT(log_, LogFlags::ACTIVE_SET, "Ignoring activation status for constraint ", i,
+                            " (infinite bound)");
+        else
+          A_.activate(i, s);
+      }
+    }
+  }
+
+  // The dynamics leave N*nu degrees of freedom.
+  if(A_.nbActiveCstr() > maxActive_)
+  {
+    if(A_.nbActiveEquality() + A_.nbFixedVariable() > maxActive_) return TerminationStatus::OVERCONSTRAINED_PROBLEM;
+
+    auto isEqualityOrFixed = [this](int i) {
+      auto a = A_.activationStatus(A_[i]);
+      return a == ActivationStatus::EQUALITY || a == ActivationStatus::FIXED;
+    };
+    int i = A_.nbActiveCstr();
+    while(A_.nbActiveCstr() > maxActive_)
+    {
+      --i;
+      while(isEqualityOrFixed(i)) --i;
+      A_.deactivate(i);
+    }
+  }
+
+  return TerminationStatus::SUCCESS;
+}
+
+internal::TerminationType RiccatiSolver::initializeComputationData()
+{
+  // The active constraints are added one by one to the factor of N^T P N. Inequality
+  // constraints that are linearly dependent on the previous ones are deactivated.
+  auto w = work_w_.asVector(nbVar_, {});
+  auto g = work_g_.asVector(nbVar_, {});
+  int q = 0;
+  while(q < A_.nbActiveCstr())
+  {
+    int i = A_[q];
+    auto s = A_.activationStatus(i);
+    g.setZero();
+    addCstr(g, i, s, -1);
+    riccatiSolve(w, g, false);
+    auto l = work_l_.asVector(q, {});
+    for(int j = 0; j < q; ++j) l[j] = cstrDot(A_[j], A_.activationStatus(A_[j]), w);
+    getL(q).solveInPlace(l);
+    if(appendToFactor(q, l, cstrDot(i, s, w)))
+    {
+      ++q;
+    }
+    else
+    {
+      if(s == ActivationStatus::EQUALITY || s == ActivationStatus::FIXED)
+        return TerminationStatus::LINEAR_DEPENDENCY_DETECTED;
+      A_.deactivate(q);
+    }
+  }
+
+  auto b_act = work_bact_.asVector(q, {});
+  for(int j = 0; j < q; ++j)
+  {
+    int i = A_[j];
+    switch(A_.activationStatus(i))
+    {
+      case ActivationStatus::LOWER: // fallthrough
+      case ActivationStatus::EQUALITY:
+        b_act[j] = pb_.bl(i);
+        break;
+      case ActivationStatus::UPPER:
+        b_act[j] = -pb_.bu(i);
+        break;
+      case ActivationStatus::LOWER_BOUND: // fallthrough
+      case ActivationStatus::FIXED:
+        b_act[j] = pb_.xl(i - A_.nbCstr());
+        break;
+      case ActivationStatus::UPPER_BOUND:
+        b_act[j] = -pb_.xu(i - A_.nbCstr());
+        break;
+      default:
+        break;
+    }
+  }
+
+  JRLQP_LOG(log_, LogFlags::INIT | LogFlags::NO_ITER, b_act);
+
+  return TerminationStatus::SUCCESS;
+}
+
+internal::TerminationType RiccatiSolver::initializePrimalDualPoints()
+{
+  // x = xunc + P N u, with u such that N^T x = b_act, i.e. N^T P N u = b_act - N^T xunc
+  int q = A_.nbActiveCstr();
+  WVector b_act = work_bact_.asVector(q);
+  WVector xunc = work_xunc_.asVector(nbVar_);
+  WVector x = work_x_.asVector(nbVar_);
+  WVector u = work_u_.asVector(q);
+  auto g = work_g_.asVector(nbVar_, {});
+
+  for(int j = 0; j < q; ++j) u[j] = b_act[j] - cstrDot(A_[j], A_.activationStatus(A_[j]), xunc);
+  getL(q).solveInPlace(u);
+  getL(q).transpose().solveInPlace(u);
+
+  g.setZero();
+  for(int j = 0; j < q; ++j) addCstr(g, A_[j], A_.activationStatus(A_[j]), -u[j]);
+  riccatiSolve(x, g, false);
+  x += xunc;
+
+  f_ = objective(x);
+
+  JRLQP_LOG(log_, LogFlags::INIT | LogFlags::NO_ITER, x, u, f_);
+
+  return TerminationStatus::SUCCESS;
+}
+} // namespace jrl::qp::experimental
@@ -1,35 +1,52 @@
 /* Copyright 2020-2021 CNRS-AIST JRL */
 
+#include <algorithm>
+
 #include <jrl-qp/internal/OrthonormalSequence.h>
 
 namespace jrl::qp::internal
 {
-ElemOrthonormalSequence::ElemOrthonormalSequence(OSeqType type, int n, int size) : type_(type), n_(n), size_(0)
+ElemOrthonormalSequence::ElemOrthonormalSequence(OSeqType type, int n, int size)
+: type_(type), n_(n), capacity_(size), size_(0), work_(storageSize(type, n, size))
+{
+}
+
+ElemOrthonormalSequence::ElemOrthonormalSequence(OSeqType type, int n, int size, double * buffer)
+: type_(type), n_(n), capacity_(size), size_(0), buffer_(buffer)
+{
+  assert(buffer || storageSize(type, n, size) == 0);
+}
+
+int ElemOrthonormalSequence::storageSize(OSeqType type, int n, int size)
 {
   switch(type)
   {
-    case jrl::qp::internal::OSeqType::Householder:
-      work1_.resize(n, size);
-      work2_.resize(size);
-      break;
-    case jrl::qp::internal::OSeqType::Givens:
-      work1_.resize(size);
-      work2_.resize(size);
-      break;
-    case jrl::qp::internal::OSeqType::Permutation:
-      assert(false && "Not implemented yet");
-      break;
+    case OSeqType::Householder:
+      // Essential parts stored as the columns of a n x size matrix, followed by the coefficients
+      return (n + 1) * size;
+    case OSeqType::Givens:
+      // Cosines, followed by sines
+      return 2 * size;
+    case OSeqType::Permutation:
+      // Pairs of indices of the transpositions
+      return 2 * size;
     default:
       assert(false);
-      break;
+      return 0;
   }
 }
 
+void ElemOrthonormalSequence::rebase(double * buffer)
+{
+  buffer_ = buffer;
+}
+
 void ElemOrthonormalSequence::add(const Givens & Q)
 {
   assert(type_ == OSeqType::Givens);
-  auto c = work1_.asVector(size_ + 1);
-  auto s = work2_.asVector(size_ + 1);
+  assert(size_ < capacity_);
+  double * c = data();
+  double * s = c + capacity_;
   c[size_] = Q.c();
   s[size_] = Q.s();
   ++size_;
@@ -38,15 +55,27 @@ void ElemOrthonormalSequence::add(const Givens & Q)
 void ElemOrthonormalSequence::add(const VectorConstRef & essential, double tau)
 {
   assert(type_ == OSeqType::Householder);
+  assert(size_ < capacity_);
   assert(essential.size() == n_ - size_ - 1);
-  auto e = work1_.asMatrix(n_, size_ + 1, n_);
-  auto t = work2_.asVector(size_ + 1);
+  Eigen::Map<Eigen::MatrixXd> e(data(), n_, size_ + 1);
+  double * t = data() + n_ * capacity_;
   e.col(size_).tail(n_ - size_ - 1) = essential;
   e(size_, size_) = 1;
   t[size_] = tau;
   ++size_;
 }
 
+void ElemOrthonormalSequence::add(int i, int j)
+{
+  assert(type_ == OSeqType::Permutation);
+  assert(size_ < capacity_);
+  assert(i >= 0 && i < n_ && j >= 0 && j < n_);
+  double * p = data();
+  p[2 * size_] = i;
+  p[2 * size_ + 1] = j;
+  ++size_;
+}
+
 void ElemOrthonormalSequence::applyToTheLeft(VectorRef v, int start, int size) const
 {
   assert(v.size() == n_);
@@ -55,32 +84,39 @@ void ElemOrthonormalSequence::applyToTheLeft(VectorRef v, int start, int size) c
   {
     case OSeqType::Householder:
     {
-      auto E = work1_.asMatrix(n_, size_, n_);
-      auto h = work2_.asVector(size_);
-      if(size_ == 1)
-      {
-        double d = E.col(0).segment(start, size).dot(v.segment(start, size));
-        v -= h[0] * d * E.col(0);
-      }
-      else
+      // v = H_0 ... H_{k-1} v, where H_j = I - h_j e_j e_j^T and e_j is zero above row j.
+      // The non-zero part of v is tracked as [lo, hi): H_j leaves v unchanged if hi <= j,
+      // and otherwise only the rows of [lo, hi) contribute to e_j^T v.
+      Eigen::Map<const Eigen::MatrixXd> E(data(), n_, size_);
+      Eigen::Map<const Eigen::VectorXd> h(data() + n_ * capacity_, size_);
+      int lo = start;
+      int hi = start + size;
+      for(int j = size_ - 1; j >= 0; --j)
       {
-        // [OPTIM] ? take start and size into account
-        Eigen::HouseholderSequence H(E, h);
-        H.applyThisOnTheLeft(v);
+        if(hi <= j) continue;
+        int b = std::max(j, lo);
+        double d = E.col(j).segment(b, hi - b).dot(v.segment(b, hi - b));
+        v.tail(n_ - j) -= h[j] * d * E.col(j).tail(n_ - j);
+        lo = std::min(lo, j);
+        hi = n_;
       }
     }
     break;
     case OSeqType::Givens:
     {
-      auto c = work1_.asVector(size_);
-      auto s = work2_.asVector(size_);
+      Eigen::Map<const Eigen::VectorXd> c(data(), size_);
+      Eigen::Map<const Eigen::VectorXd> s(data() + capacity_, size_);
       int b = std::min(size_ - 1, start + size - 1);
       for(int i = b; i >= 0; --i) v.applyOnTheLeft(i, i + 1, Givens(c[i], s[i]));
     }
     break;
     case OSeqType::Permutation:
-      assert(false && "Not implemented yet");
-      break;
+    {
+      const double * p = data();
+      for(int i = size_ - 1; i >= 0; --i)
+        std::swap(v[static_cast<int>(p[2 * i])], v[static_cast<int>(p[2 * i + 1])]);
+    }
+    break;
     default:
       assert(false);
   }
@@ -94,32 +130,36 @@ void ElemOrthonormalSequence::applyTransposeToTheLeft(VectorRef v, int start, in
   {
     case OSeqType::Householder:
     {
-      auto E = work1_.asMatrix(n_, size_, n_);
-      auto h = work2_.asVector(size_);
-      if(size_ == 1)
-      {
-        double d = E.col(0).segment(start, size).dot(v.segment(start, size));
-        v -= h[0] * d * E.col(0);
-      }
-      else
+      // v = H_{k-1} ... H_0 v, with the same tracking of the non-zero part of v as above.
+      // Once hi <= j, the remaining reflectors leave v unchanged.
+      Eigen::Map<const Eigen::MatrixXd> E(data(), n_, size_);
+      Eigen::Map<const Eigen::VectorXd> h(data() + n_ * capacity_, size_);
+      int lo = start;
+      int hi = start + size;
+      for(int j = 0; j < size_ && j < hi; ++j)
       {
-        // [OPTIM] ? take start and size into account
-        Eigen::HouseholderSequence H(E, h);
-        H.transpose().applyThisOnTheLeft(v);
+        int b = std::max(j, lo);
+        double d = E.col(j).segment(b, hi - b).dot(v.segment(b, hi - b));
+        v.tail(n_ - j) -= h[j] * d * E.col(j).tail(n_ - j);
+        lo = std::min(lo, j);
+        hi = n_;
       }
     }
     break;
     case OSeqType::Givens:
     {
-      auto c = work1_.asVector(size_);
-      auto s = work2_.asVector(size_);
+      Eigen::Map<const Eigen::VectorXd> c(data(), size_);
+      Eigen::Map<const Eigen::VectorXd> s(data() + capacity_, size_);
       int b = std::max(0, start - 1);
       for(int i = b; i < size_; ++i) v.applyOnTheLeft(i, i + 1, Givens(c[i], s[i]).transpose());
     }
     break;
     case OSeqType::Permutation:
-      assert(false && "Not implemented yet");
-      break;
+    {
+      const double * p = data();
+      for(int i = 0; i < size_; ++i) std::swap(v[static_cast<int>(p[2 * i])], v[static_cast<int>(p[2 * i + 1])]);
+    }
+    break;
     default:
       assert(false);
   }
@@ -138,7 +178,8 @@ OrthonormalSequence::OrthonormalSequence(int n) : n_(n) {}
 
 void OrthonormalSequence::add(int start, const Givens & Q)
 {
-  auto & last = seq_.back();
+  assert(nbSeq_ > 0);
+  auto & last = seq_[static_cast<size_t>(nbSeq_ - 1)];
   assert(last.H.type() == OSeqType::Givens);
   if(last.H.size() == 0)
   {
@@ -153,7 +194,8 @@ void OrthonormalSequence::add(int start, const Givens & Q)
 
 void OrthonormalSequence::add(int start, const VectorConstRef & essential, double tau)
 {
-  auto & last = seq_.back();
+  assert(nbSeq_ > 0);
+  auto & last = seq_[static_cast<size_t>(nbSeq_ - 1)];
   assert(last.H.type() == OSeqType::Householder);
   if(last.H.size() == 0)
   {
@@ -166,14 +208,102 @@ void OrthonormalSequence::add(int start, const VectorConstRef & essential, doubl
   last.H.add(essential, tau);
 }
 
+void OrthonormalSequence::add(int start, int i, int j)
+{
+  assert(nbSeq_ > 0);
+  auto & last = seq_[static_cast<size_t>(nbSeq_ - 1)];
+  assert(last.H.type() == OSeqType::Permutation);
+  if(last.H.size() == 0)
+  {
+    last.start = start;
+  }
+  else
+  {
+    assert(last.start == start);
+  }
+  last.H.add(i, j);
+}
+
 void OrthonormalSequence::prepare(OSeqType type, int n, int seqSize)
 {
-  seq_.emplace_back(0, type, n, seqSize);
+  // The cost of applying the sequence grows with each new element. Once it is higher than
+  // the one of a dense matrix, we merge the existing elements into the dense part.
+  if(compactionRatio_ > 0 && seqCost_ > compactionRatio_ * denseCost()) compact();
+
+  int storage = ElemOrthonormalSequence::storageSize(type, n, seqSize);
+  growArena(storage);
+  double * buffer = arena_.asVector(arena_.size(), {}).data() + used_;
+  // We recycle the elements from previous uses when possible, to avoid memory allocations.
+  if(nbSeq_ < static_cast<int>(seq_.size()))
+  {
+    seq_[static_cast<size_t>(nbSeq_)] = EmbeddedSeq(0, used_, type, n, seqSize, buffer);
+  }
+  else
+  {
+    seq_.emplace_back(0, used_, type, n, seqSize, buffer);
+  }
+  used_ += storage;
+  seqCost_ += applicationCost(type, n, seqSize);
+  ++nbSeq_;
 }
 
 void OrthonormalSequence::clear()
 {
-  seq_.clear();
+  nbSeq_ = 0;
+  used_ = 0;
+  seqCost_ = 0;
+  hasDense_ = false;
+}
+
+void OrthonormalSequence::compactionRatio(double r)
+{
+  compactionRatio_ = r;
+  // Without compaction, the dense part is never formed and its memory can be released.
+  if(r <= 0 && !hasDense_) dense_.resize(0, true);
+}
+
+void OrthonormalSequence::compact()
+{
+  if(nbSeq_ == 0) return;
+
+  dense_.resize(n_, n_);
+  tmp_.resize(n_);
+  auto D = dense_.asMatrix(n_, n_, n_, {});
+  if(!hasDense_) D.setIdentity();
+
+  // D <- D * H_0 * ... * H_k, computed row by row as (H_k^T ... H_0^T D^T)^T
+  auto t = tmp_.asVector(n_, {});
+  for(int r = 0; r < n_; ++r)
+  {
+    t = D.row(r).transpose();
+    applySeqTransposeToTheLeft(t);
+    D.row(r) = t.transpose();
+  }
+
+  hasDense_ = true;
+  nbSeq_ = 0;
+  used_ = 0;
+  seqCost_ = 0;
+}
+
+double OrthonormalSequence::applicationCost(OSeqType type, int n, int seqSize)
+{
+  switch(type)
+  {
+    case OSeqType::Householder:
+      return 4. * n * seqSize; // dot product + axpy for each reflector
+    case OSeqType::Givens:
+      return 6. * seqSize;
+    case OSeqType::Permutation:
+      return seqSize;
+    default:
+      return 0;
+  }
+}
+
+double OrthonormalSequence::denseCost() const
+{
+  return 2. * n_ * n_;
 }
 
 void OrthonormalSequence::resize(int n)
@@ -181,6 +311,34 @@ void OrthonormalSequence::resize(int n)
   n_ = n;
 }
 
+void OrthonormalSequence::reserve(int nbElem)
+{
+  if(static_cast<int>(seq_.capacity()) < nbElem) seq_.reserve(static_cast<size_t>(nbElem));
+  // A Householder reflector requires n_+1 elements, a sequence of Givens rotation 2*(n_-1)
+  // at most, but is usually much shorter.
+  int size = nbElem * (n_ + 1);
+  if(arena_.size() < size) growArena(size - used_);
+  if(compactionRatio_ > 0)
+  {
+    dense_.resize(n_, n_);
+    tmp_.resize(n_);
+  }
+}
+
+void OrthonormalSequence::growArena(int size)
+{
+  if(used_ + size <= arena_.size()) return;
+
+  arena_.conservativeResize(std::max(used_ + size, 2 * arena_.size()));
+  // The data may have moved
+  double * base = arena_.asVector(arena_.size(), {}).data();
+  for(int i = 0; i < nbSeq_; ++i)
+  {
+    auto & Hi = seq_[static_cast<size_t>(i)];
+    Hi.H.rebase(base + Hi.offset);
+  }
+}
+
 int OrthonormalSequence::size() const
 {
   return n_;
@@ -189,58 +347,107 @@ int OrthonormalSequence::size() const
 void OrthonormalSequence::applyToTheLeft(VectorRef v) const
 {
   assert(v.size() == n_);
-  for(int i = static_cast<int>(seq_.size()) - 1; i >= 0; --i)
+  applySeqToTheLeft(v);
+  if(hasDense_)
   {
-    const auto & Hi = seq_[i];
-    Hi.H.applyToTheLeft(v.segment(Hi.start, Hi.H.n()), 0, Hi.H.n());
+    auto t = tmp_.asVector(n_, {});
+    t.noalias() = dense_.asMatrix(n_, n_, n_) * v;
+    v = t;
   }
 }
 
 void OrthonormalSequence::applyTransposeToTheLeft(VectorRef v) const
 {
   assert(v.size() == n_);
-  for(size_t i = 0; i < seq_.size(); ++i)
+  if(hasDense_)
+  {
+    auto t = tmp_.asVector(n_, {});
+    t.noalias() = dense_.asMatrix(n_, n_, n_).transpose() * v;
+    v = t;
+  }
+  applySeqTransposeToTheLeft(v);
+}
+
+void OrthonormalSequence::applySeqToTheLeft(VectorRef v) const
+{
+  for(int i = nbSeq_ - 1; i >= 0; --i)
+  {
+    const auto & Hi = seq_[i];
+    Hi.H.applyToTheLeft(v.segment(Hi.start, Hi.H.n()), 0, Hi.H.n());
+  }
+}
+
+void OrthonormalSequence::applySeqTransposeToTheLeft(VectorRef v) const
+{
+  for(int i = 0; i < nbSeq_; ++i)
   {
     const auto & Hi = seq_[i];
     Hi.H.applyTransposeToTheLeft(v.segment(Hi.start, Hi.H.n()), 0, Hi.H.n());
   }
 }
 
-void OrthonormalSequence::applyToTheLeft(VectorRef out, const SingleNZSegmentVector & in) const
+void OrthonormalSequence::applyToTheLeft(VectorRef v, int start, int size) const
 {
-  assert(in.size() == n_);
-  assert(out.size() == n_);
-  in.toFullVector(out);
-  int start = in.start(); // first non zero
-  int end = in.start() + static_cast<int>(in.nzSegment().size()); // first zero after segment
-  for(int i = static_cast<int>(seq_.size()) - 1; i >= 0; --i)
+  assert(v.size() == n_);
+  assert(start >= 0 && size >= 0 && start + size <= n_);
+  int end = start + size; // first zero after the non-zero part
+  for(int i = nbSeq_ - 1; i >= 0; --i)
   {
     const auto & Hi = seq_[i];
-    if(Hi.start >= end || Hi.start + Hi.H.n() < start) continue; // We skip if Hi would multiply zero
+    if(Hi.start >= end || Hi.start + Hi.H.n() <= start) continue; // We skip if Hi would multiply zero
     int s = std::max(0, start - Hi.start);
     int n = std::min(Hi.H.n(), end - Hi.start);
-    Hi.H.applyToTheLeft(out.segment(Hi.start, Hi.H.n()), s, n - s);
+    Hi.H.applyToTheLeft(v.segment(Hi.start, Hi.H.n()), s, n - s);
     start = std::min(start, Hi.start);
     end = std::max(end, Hi.start + Hi.H.n());
   }
+  if(hasDense_)
+  {
+    auto t = tmp_.asVector(n_, {});
+    t.noalias() = dense_.asMatrix(n_, n_, n_).middleCols(start, end - start) * v.segment(start, end - start);
+    v = t;
+  }
 }
 
-void OrthonormalSequence::applyTransposeToTheLeft(VectorRef out, const SingleNZSegmentVector & in) const
+void OrthonormalSequence::applyTransposeToTheLeft(VectorRef v, int start, int size) const
 {
-  assert(in.size() == n_);
-  assert(out.size() == n_);
-  in.toFullVector(out);
-  int start = in.start(); // first non zero
-  int end = in.start() + static_cast<int>(in.nzSegment().size()); // first zero after segment
-  for(size_t i = 0; i < seq_.size(); ++i)
+  assert(v.size() == n_);
+  assert(start >= 0 && size >= 0 && start + size <= n_);
+  if(hasDense_)
+  {
+    // After the multiplication by the dense part, the vector has no structure anymore.
+    auto t = tmp_.asVector(n_, {});
+    t.noalias() = dense_.asMatrix(n_, n_, n_).middleRows(start, size).transpose() * v.segment(start, size);
+    v = t;
+    applySeqTransposeToTheLeft(v);
+    return;
+  }
+  int end = start + size; // first zero after the non-zero part
+  for(int i = 0; i < nbSeq_; ++i)
   {
     const auto & Hi = seq_[i];
-    if(Hi.start >= end || Hi.start + Hi.H.n() < start) continue; // We skip if Hi would multiply zero
+    if(Hi.start >= end || Hi.start + Hi.H.n() <= start) continue; // We skip if Hi would multiply zero
     int s = std::max(0, start - Hi.start);
     int n = std::min(Hi.H.n(), end - Hi.start);
-    Hi.H.applyTransposeToTheLeft(out.segment(Hi.start, Hi.H.n()), s, n - s);
+    Hi.H.applyTransposeToTheLeft(v.segment(Hi.start, Hi.H.n()), s, n - s);
     start = std::min(start, Hi.start);
     end = std::max(end, Hi.start + Hi.H.n());
   }
 }
+
+void OrthonormalSequence::applyToTheLeft(VectorRef out, const SingleNZSegmentVector & in) const
+{
+  assert(in.size() == n_);
+  assert(out.size() == n_);
+  in.toFullVector(out);
+  applyToTheLeft(out, in.start(), static_cast<int>(in.nzSegment().size()));
+}
+
+void OrthonormalSequence::applyTransposeToTheLeft(VectorRef out, const SingleNZSegmentVector & in) const
+{
+  assert(in.size() == n_);
+  assert(out.size() == n_);
+  in.toFullVector(out);
+  applyTransposeToTheLeft(out, in.start(), static_cast<int>(in.nzSegment().size()));
+}
 } // namespace jrl::qp::internal
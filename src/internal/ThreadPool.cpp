@@ -0,0 +1,76 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/internal/ThreadPool.h>
+
+#include <algorithm>
+
+namespace jrl::qp::internal
+{
+ThreadPool::ThreadPool(int nbThreads)
+{
+  if(nbThreads <= 0) nbThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  workers_.reserve(static_cast<size_t>(nbThreads - 1));
+  for(int i = 1; i < nbThreads; ++i) workers_.emplace_back([this] { work(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for(auto & w : workers_) w.join();
+}
+
+void ThreadPool::run(int n, Task task, void * data)
+{
+  if(n <= 0) return;
+
+  // Not worth waking up the workers
+  if(workers_.empty() || n == 1)
+  {
+    for(int i = 0; i < n; ++i) task(data, i);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = task;
+    data_ = data;
+    n_ = n;
+    next_ = 0;
+    busy_ = static_cast<int>(workers_.size());
+    ++generation_;
+  }
+  start_.notify_all();
+  process();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return busy_ == 0; });
+}
+
+void ThreadPool::work()
+{
+  unsigned generation = 0;
+  for(;;)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [&] { return stop_ || generation_ != generation; });
+      if(stop_) return;
+      generation = generation_;
+    }
+    process();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if(--busy_ == 0) done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::process()
+{
+  for(int i = next_++; i < n_; i = next_++) task_(data_, i);
+}
+} // namespace jrl::qp::internal
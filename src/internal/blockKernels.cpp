@@ -0,0 +1,162 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/internal/blockKernels.h>
+
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include <Eigen/Cholesky>
+
+namespace
+{
+using namespace jrl::qp;
+
+template<int R, int C>
+using Fixed = Eigen::Matrix<double, R, C>;
+
+template<int N>
+using Seq = std::make_integer_sequence<int, N>;
+
+/** Call f(std::integral_constant<int, n>) if there is a kernel for n, and return
+ * whether it was the case. This is the only place listing the kernel sizes.
+ */
+template<typename F>
+bool dispatch(int n, F && f)
+{
+  switch(n)
+  {
+    case 6:
+      f(std::integral_constant<int, 6>{});
+      return true;
+    case 12:
+      f(std::integral_constant<int, 12>{});
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** Same as dispatch, for two sizes.*/
+template<typename F>
+bool dispatch(int n, int m, F && f)
+{
+  bool done = false;
+  dispatch(n, [&](auto N) { done = dispatch(m, [&](auto M) { f(N, M); }); });
+  return done;
+}
+
+// Right-looking Cholesky decomposition. Step K computes the column K of L and updates
+// the trailing block. The loop over K is unrolled at compile time, so that all the
+// blocks have fixed sizes. The upper part of A is overwritten with garbage.
+template<int N, int K>
+bool cholStep(Fixed<N, N> & A)
+{
+  double d = A(K, K);
+  if(!(d > 0)) return false;
+  d = std::sqrt(d);
+  A(K, K) = d;
+  constexpr int R = N - K - 1;
+  if constexpr(R > 0)
+  {
+    auto c = A.template block<R, 1>(K + 1, K);
+    c /= d;
+    A.template block<R, R>(K + 1, K + 1).noalias() -= c * c.transpose();
+  }
+  return true;
+}
+
+template<int N, int... K>
+bool chol(Fixed<N, N> & A, std::integer_sequence<int, K...>)
+{
+  return (cholStep<N, K>(A) && ...);
+}
+
+// X = X L^-T, column by column: X_j = (X_j - X_{0:j-1} L_{j,0:j-1}^T) / L_jj
+template<int N, int M, int J>
+void trsmStep(const Fixed<N, N> & L, Fixed<M, N> & X)
+{
+  if constexpr(J > 0) X.col(J).noalias() -= X.template leftCols<J>() * L.template block<1, J>(J, 0).transpose();
+  X.col(J) /= L(J, J);
+}
+
+template<int N, int M, int... J>
+void trsm(const Fixed<N, N> & L, Fixed<M, N> & X, std::integer_sequence<int, J...>)
+{
+  (trsmStep<N, M, J>(L, X), ...);
+}
+} // namespace
+
+namespace jrl::qp::internal
+{
+bool blockLLT(MatrixRef A)
+{
+  assert(A.rows() == A.cols());
+  bool ok = true;
+  if(dispatch(static_cast<int>(A.rows()), [&](auto N) {
+       Fixed<N, N> L = A;
+       ok = chol(L, Seq<N>());
+       if(ok) A.template triangularView<Eigen::Lower>() = L;
+     }))
+    return ok;
+
+  return Eigen::internal::llt_inplace<double, Eigen::Lower>::blocked(A) < 0;
+}
+
+void blockSolveLTransposeRight(const MatrixConstRef & L, MatrixRef X)
+{
+  assert(L.rows() == L.cols() && X.cols() == L.rows());
+  if(dispatch(static_cast<int>(L.rows()), static_cast<int>(X.rows()), [&](auto N, auto M) {
+       Fixed<N, N> l = L;
+       Fixed<M, N> x = X;
+       trsm(l, x, Seq<N>());
+       X = x;
+     }))
+    return;
+
+  L.template triangularView<Eigen::Lower>().transpose().template solveInPlace<Eigen::OnTheRight>(X);
+}
+
+void blockSolveLLeft(const MatrixConstRef & L, MatrixRef X)
+{
+  assert(L.rows() == L.cols() && X.rows() == L.rows());
+  // L^-1 X = (X^T L^-T)^T
+  if(dispatch(static_cast<int>(L.rows()), static_cast<int>(X.cols()), [&](auto N, auto M) {
+       Fixed<N, N> l = L;
+       Fixed<M, N> x = X.transpose();
+       trsm(l, x, Seq<N>());
+       X = x.transpose();
+     }))
+    return;
+
+  L.template triangularView<Eigen::Lower>().solveInPlace(X);
+}
+
+void blockRankUpdate(MatrixRef D, const MatrixConstRef & X)
+{
+  assert(D.rows() == D.cols() && X.rows() == D.rows());
+  if(dispatch(static_cast<int>(X.cols()), static_cast<int>(D.rows()), [&](auto N, auto M) {
+       Fixed<M, M> d = D;
+       Fixed<M, N> x = X;
+       d.noalias() -= x * x.transpose();
+       D.template triangularView<Eigen::Lower>() = d;
+     }))
+    return;
+
+  D.template selfadjointView<Eigen::Lower>().rankUpdate(X, -1.);
+}
+
+void blockRankUpdateTranspose(MatrixRef D, const MatrixConstRef & X)
+{
+  assert(D.rows() == D.cols() && X.cols() == D.rows());
+  if(dispatch(static_cast<int>(X.rows()), static_cast<int>(D.rows()), [&](auto N, auto M) {
+       Fixed<M, M> d = D;
+       Fixed<N, M> x = X;
+       d.noalias() -= x.transpose() * x;
+       D.template triangularView<Eigen::Lower>() = d;
+     }))
+    return;
+
+  D.template selfadjointView<Eigen::Lower>().rankUpdate(X.transpose(), -1.);
+}
+} // namespace jrl::qp::internal
@@ -0,0 +1,172 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/structured/ProblemPattern.h>
+
+#include <algorithm>
+
+namespace jrl::qp::structured
+{
+ProblemPattern::ProblemPattern(StructuredG::Type gType,
+                               const std::vector<int> & varSizes,
+                               const std::vector<int> & cstrSizes,
+                               int cBandwidth,
+                               int gBandwidth)
+{
+  reset(gType, varSizes, cstrSizes, cBandwidth, gBandwidth);
+}
+
+void ProblemPattern::reset(StructuredG::Type gType,
+                           const std::vector<int> & varSizes,
+                           const std::vector<int> & cstrSizes,
+                           int cBandwidth,
+                           int gBandwidth)
+{
+  using Type = StructuredG::Type;
+  assert(!varSizes.empty() && varSizes.size() == cstrSizes.size());
+  assert(gType != Type::DiagonalPlusLowRank && "Not supported yet.");
+  assert(cBandwidth >= 0 && cBandwidth < static_cast<int>(varSizes.size()));
+  nbVar_ = varSizes;
+  nbCstr_ = cstrSizes;
+  const int b = nbBlocks();
+
+  varStart_.resize(static_cast<size_t>(b + 1));
+  cstrStart_.resize(static_cast<size_t>(b + 1));
+  for(size_t i = 0; i < static_cast<size_t>(b); ++i)
+  {
+    varStart_[i + 1] = varStart_[i] + nbVar_[i];
+    cstrStart_[i + 1] = cstrStart_[i] + nbCstr_[i];
+  }
+  toBlock_.resize(static_cast<size_t>(nbCstr()));
+  for(int i = 0; i < b; ++i)
+    std::fill(toBlock_.begin() + cstrStart(i), toBlock_.begin() + cstrStart(i + 1), i);
+
+  // Storage of G
+  Gdiag_.clear();
+  Goff_.clear();
+  if(gType == Type::Banded)
+  {
+    assert(gBandwidth >= 0 && gBandwidth < nbVar());
+    Gdiag_.push_back(Eigen::MatrixXd::Zero(gBandwidth + 1, nbVar()));
+  }
+  else
+  {
+    for(int i = 0; i < b; ++i) Gdiag_.push_back(Eigen::MatrixXd::Zero(nv(i), nv(i)));
+    for(int i = 1; i < b; ++i)
+    {
+      switch(gType)
+      {
+        case Type::TriBlockDiagonal:
+          Goff_.push_back(Eigen::MatrixXd::Zero(nv(i), nv(i - 1)));
+          break;
+        case Type::BlockArrowUp:
+          Goff_.push_back(Eigen::MatrixXd::Zero(nv(i), nv(0)));
+          break;
+        case Type::BlockArrowDown:
+          Goff_.push_back(Eigen::MatrixXd::Zero(nv(b - 1), nv(i - 1)));
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  // Storage of C
+  Cdiag_.clear();
+  Csub_.assign(static_cast<size_t>(cBandwidth), {});
+  for(int j = 0; j < b; ++j)
+  {
+    Cdiag_.push_back(Eigen::MatrixXd::Zero(nv(j), nbCstr_[static_cast<size_t>(j)]));
+    for(int k = 1; k <= cBandwidth && j + k < b; ++k)
+      Csub_[static_cast<size_t>(k - 1)].push_back(Eigen::MatrixXd::Zero(nv(j + k), nbCstr_[static_cast<size_t>(j)]));
+  }
+
+  // Views. The vectors of matrices are not modified anymore, so that the references
+  // stay valid.
+  if(gType == Type::Banded)
+    G_ = StructuredG(MatrixRef(Gdiag_[0]));
+  else
+  {
+    std::vector<MatrixRef> D(Gdiag_.begin(), Gdiag_.end());
+    std::vector<MatrixRef> S(Goff_.begin(), Goff_.end());
+    G_ = StructuredG(gType, D, S);
+  }
+
+  std::vector<MatrixConstRef> diag(Cdiag_.begin(), Cdiag_.end());
+  switch(cBandwidth)
+  {
+    case 0:
+      C_ = StructuredC(StructuredC::Type::Diagonal, diag, {});
+      break;
+    case 1:
+    {
+      std::vector<MatrixConstRef> offDiag(Csub_[0].begin(), Csub_[0].end());
+      C_ = StructuredC(StructuredC::Type::BlockBidiagonal, diag, offDiag);
+      break;
+    }
+    default:
+    {
+      std::vector<std::vector<MatrixConstRef>> sub;
+      for(const auto & s : Csub_) sub.emplace_back(s.begin(), s.end());
+      C_ = StructuredC(diag, sub);
+      break;
+    }
+  }
+}
+
+void ProblemPattern::setG(const MatrixConstRef & G)
+{
+  using Type = StructuredG::Type;
+  assert(G.rows() == nbVar() && G.cols() == nbVar());
+  // The blocks are overwritten with the new values: a previous decomposition is lost.
+  G_.invalidateDecomposition();
+  const int b = nbBlocks();
+  if(G_.type() == Type::Banded)
+  {
+    auto & band = Gdiag_[0];
+    const int n = nbVar();
+    for(int j = 0; j < n; ++j)
+    {
+      int m = std::min(static_cast<int>(band.rows()), n - j);
+      band.col(j).head(m) = G.col(j).segment(j, m);
+    }
+    return;
+  }
+
+  for(int i = 0; i < b; ++i) Gdiag_[static_cast<size_t>(i)] = G.block(varStart(i), varStart(i), nv(i), nv(i));
+  for(int i = 1; i < b && !Goff_.empty(); ++i)
+  {
+    auto & S = Goff_[static_cast<size_t>(i - 1)];
+    switch(G_.type())
+    {
+      case Type::TriBlockDiagonal:
+        S = G.block(varStart(i), varStart(i - 1), nv(i), nv(i - 1));
+        break;
+      case Type::BlockArrowUp:
+        S = G.block(varStart(i), 0, nv(i), nv(0));
+        break;
+      case Type::BlockArrowDown:
+        S = G.block(varStart(b - 1), varStart(i - 1), nv(b - 1), nv(i - 1));
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void ProblemPattern::setCCol(int k, const VectorConstRef & c)
+{
+  assert(c.size() == nbVar());
+  assert(k >= 0 && k < nbCstr());
+  const int j = toBlock_[static_cast<size_t>(k)];
+  const int l = k - cstrStart(j);
+  Cdiag_[static_cast<size_t>(j)].col(l) = c.segment(varStart(j), nv(j));
+  for(int i = 1; i <= C_.bandwidth() && j + i < nbBlocks(); ++i)
+    Csub_[static_cast<size_t>(i - 1)][static_cast<size_t>(j)].col(l) = c.segment(varStart(j + i), nv(j + i));
+}
+
+void ProblemPattern::setC(const MatrixConstRef & C)
+{
+  assert(C.rows() == nbVar() && C.cols() == nbCstr());
+  for(int k = 0; k < nbCstr(); ++k) setCCol(k, C.col(k));
+}
+} // namespace jrl::qp::structured
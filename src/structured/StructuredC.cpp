@@ -6,21 +6,75 @@ namespace jrl::qp::structured
 {
 StructuredC::StructuredC() {}
 
-StructuredC::StructuredC(std::vector<MatrixConstRef> C) : type_(Type::Diagonal), nbVar_(0), nbCstr_(0)
+StructuredC::StructuredC(std::vector<MatrixConstRef> C) : type_(Type::Diagonal), diag_(std::move(C))
 {
-  for(const auto & Ci : C)
+  init();
+}
+
+StructuredC::StructuredC(Type t,
+                         const std::vector<MatrixConstRef> & diag,
+                         const std::vector<MatrixConstRef> & offDiag)
+: type_(t), diag_(diag)
+{
+  switch(t)
+  {
+    case Type::Diagonal:
+      assert(offDiag.empty());
+      break;
+    case Type::BlockBidiagonal:
+      assert(offDiag.size() + 1 == diag.size());
+      subDiag_.push_back(offDiag);
+      break;
+    default:
+      assert(false && "Use the dedicated constructor for banded matrices.");
+  }
+  init();
+}
+
+StructuredC::StructuredC(const std::vector<MatrixConstRef> & diag,
+                         const std::vector<std::vector<MatrixConstRef>> & subDiag)
+: type_(Type::Banded), diag_(diag), subDiag_(subDiag)
+{
+  init();
+}
+
+void StructuredC::init()
+{
+  // The tables are sized once, instead of being grown block by block.
+  const size_t b = diag_.size();
+  cumulNbVar_.resize(b + 1);
+  cumulNbCstr_.resize(b + 1);
+  cumulNbVar_[0] = 0;
+  cumulNbCstr_[0] = 0;
+  for(size_t i = 0; i < b; ++i)
+  {
+    cumulNbVar_[i + 1] = cumulNbVar_[i] + static_cast<int>(diag_[i].rows());
+    cumulNbCstr_[i + 1] = cumulNbCstr_[i] + static_cast<int>(diag_[i].cols());
+  }
+  nbVar_ = cumulNbVar_[b];
+  nbCstr_ = cumulNbCstr_[b];
+  toBlock_.resize(static_cast<size_t>(nbCstr_));
+  for(size_t i = 0; i < b; ++i)
+    std::fill(toBlock_.begin() + cumulNbCstr_[i], toBlock_.begin() + cumulNbCstr_[i + 1], static_cast<int>(i));
+
+  int maxColSize = 0;
+  for(size_t k = 0; k < subDiag_.size(); ++k)
   {
-    int ni = static_cast<int>(Ci.rows());
-    int mi = static_cast<int>(Ci.cols());
-    cumulNbVar_.push_back(nbVar_);
-    cumulNbCstr_.push_back(nbCstr_);
-    std::fill_n(std::back_inserter(toBlock_), mi, static_cast<int>(diag_.size()));
-    nbVar_ += ni;
-    nbCstr_ += mi;
-    diag_.push_back(Ci);
+    assert(subDiag_[k].size() + k + 1 == diag_.size());
+    for(size_t j = 0; j < subDiag_[k].size(); ++j)
+    {
+      assert(subDiag_[k][j].rows() == diag_[j + k + 1].rows());
+      assert(subDiag_[k][j].cols() == diag_[j].cols());
+    }
   }
-  cumulNbVar_.push_back(nbVar_);
-  cumulNbCstr_.push_back(nbCstr_);
+  if(type_ != Type::Diagonal)
+  {
+    for(int j = 0; j < static_cast<int>(diag_.size()); ++j)
+    {
+      maxColSize = std::max(maxColSize, cumulNbVar_[lastBlockRow(j) + 1] - cumulNbVar_[j]);
+    }
+  }
+  work_col_.resize(maxColSize);
 }
 
 StructuredC & StructuredC::operator=(const StructuredC & other)
@@ -28,11 +82,18 @@ StructuredC & StructuredC::operator=(const StructuredC & other)
   type_ = other.type_;
   diag_.clear();
   std::copy(other.diag_.begin(), other.diag_.end(), std::back_inserter(diag_));
+  subDiag_.resize(other.subDiag_.size());
+  for(size_t k = 0; k < subDiag_.size(); ++k)
+  {
+    subDiag_[k].clear();
+    std::copy(other.subDiag_[k].begin(), other.subDiag_[k].end(), std::back_inserter(subDiag_[k]));
+  }
   cumulNbVar_ = other.cumulNbVar_;
   cumulNbCstr_ = other.cumulNbCstr_;
   toBlock_ = other.toBlock_;
   nbVar_ = other.nbVar_;
   nbCstr_ = other.nbCstr_;
+  work_col_.resize(other.work_col_.size());
   return *this;
 }
 
@@ -40,6 +101,15 @@ const MatrixConstRef & StructuredC::diag(int i) const
 {
   return diag_[i];
 }
+const MatrixConstRef & StructuredC::offDiag(int i) const
+{
+  return subDiag(1, i);
+}
+const MatrixConstRef & StructuredC::subDiag(int k, int i) const
+{
+  assert(k >= 1 && k <= bandwidth());
+  return subDiag_[static_cast<size_t>(k - 1)][static_cast<size_t>(i)];
+}
 int StructuredC::nbVar() const
 {
   return nbVar_;
@@ -57,22 +127,43 @@ int StructuredC::nbCstr(int i) const
   return static_cast<int>(diag_[i].cols());
 }
 internal::SingleNZSegmentVector StructuredC::col(int i) const
+{
+  return col(i, work_col_);
+}
+
+internal::SingleNZSegmentVector StructuredC::col(int i, internal::Workspace<> & work) const
 {
   assert(i < nbCstr_);
   int bi = toBlock_[i];
-  return {diag_[bi].col(i - cumulNbCstr_[bi]), cumulNbVar_[bi], nbVar_};
+  int c = i - cumulNbCstr_[bi];
+  if(type_ == Type::Diagonal) return {diag_[bi].col(c), cumulNbVar_[bi], nbVar_};
+
+  // Gather the column parts of the blocks (bi, bi), (bi+1, bi), ...
+  int n = cumulNbVar_[lastBlockRow(bi) + 1] - cumulNbVar_[bi];
+  work.resize(n);
+  auto v = work.asVector(n, {});
+  v.head(nbVar(bi)) = diag_[bi].col(c);
+  for(int k = 1; bi + k <= lastBlockRow(bi); ++k)
+  {
+    v.segment(cumulNbVar_[bi + k] - cumulNbVar_[bi], nbVar(bi + k)) = subDiag(k, bi).col(c);
+  }
+  return {v, cumulNbVar_[bi], nbVar_};
 }
 
 void StructuredC::transposeMult(VectorRef out, const VectorConstRef & in) const
 {
-  assert(type_ == Type::Diagonal && "other implentations not done");
   assert(in.size() == nbVar_);
   assert(out.size() == nbCstr_);
 
   for(size_t i = 0; i < diag_.size(); ++i)
   {
-    out.segment(cumulNbCstr_[i], diag_[i].cols()).noalias() =
-        diag_[i].transpose() * in.segment(cumulNbVar_[i], diag_[i].rows());
+    auto outi = out.segment(cumulNbCstr_[i], diag_[i].cols());
+    outi.noalias() = diag_[i].transpose() * in.segment(cumulNbVar_[i], diag_[i].rows());
+    for(size_t k = 0; k < subDiag_.size() && i + k + 1 < diag_.size(); ++k)
+    {
+      const auto & B = subDiag_[k][i];
+      outi.noalias() += B.transpose() * in.segment(cumulNbVar_[i + k + 1], B.rows());
+    }
   }
 }
 } // namespace jrl::qp::structured
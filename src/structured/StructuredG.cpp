@@ -1,7 +1,13 @@
 #include <jrl-qp/structured/StructuredG.h>
 
+#include <algorithm>
+
+#include <jrl-qp/decomposition/bandLLT.h>
 #include <jrl-qp/decomposition/blockArrowLLT.h>
+#include <jrl-qp/decomposition/blockDiagLLT.h>
+#include <jrl-qp/decomposition/lowRankLLT.h>
 #include <jrl-qp/decomposition/triBlockDiagLLT.h>
+#include <jrl-qp/internal/blockKernels.h>
 
 jrl::qp::structured::StructuredG::StructuredG(Type t,
                                               const std::vector<MatrixRef> & diag,
@@ -17,28 +23,248 @@ jrl::qp::structured::StructuredG::StructuredG(Type t,
   }
   start_.push_back(nbVar_);
   std::copy(offDiag.begin(), offDiag.end(), std::back_inserter(offDiag_));
+  assert(t != Type::Banded && "Use the dedicated constructor for banded matrices.");
+  assert(t != Type::BlockDiagonal || offDiag_.empty());
+}
+
+jrl::qp::structured::StructuredG::StructuredG(const MatrixRef & band)
+: type_(Type::Banded), nbVar_(static_cast<int>(band.cols()))
+{
+  assert(band.rows() > 0);
+  diag_.push_back(band);
+  start_.push_back(0);
+  start_.push_back(nbVar_);
+}
+
+jrl::qp::structured::StructuredG::StructuredG(const MatrixRef & d, const MatrixRef & U)
+: type_(Type::DiagonalPlusLowRank), nbVar_(static_cast<int>(d.cols()))
+{
+  assert(d.rows() == 1);
+  assert(U.rows() == nbVar_ && U.cols() <= nbVar_);
+  diag_.push_back(d);
+  offDiag_.push_back(U);
+  start_.push_back(0);
+  start_.push_back(nbVar_);
+}
+
+jrl::qp::structured::StructuredG & jrl::qp::structured::StructuredG::operator=(const StructuredG & other)
+{
+  type_ = other.type_;
+  diag_.clear();
+  std::copy(other.diag_.begin(), other.diag_.end(), std::back_inserter(diag_));
+  offDiag_.clear();
+  std::copy(other.offDiag_.begin(), other.offDiag_.end(), std::back_inserter(offDiag_));
+  start_ = other.start_;
+  nbVar_ = other.nbVar_;
+  decomposed_ = other.decomposed_;
+  pool_ = other.pool_;
+  parallel_ = other.parallel_;
+  // The parallel tri-block-diagonal factor is partly stored outside of the blocks.
+  if(parallel_ && decomposed_ && type_ == Type::TriBlockDiagonal) parallelTri_ = other.parallelTri_;
+  keep_ = other.keep_;
+  origDiag_ = other.origDiag_;
+  origOffDiag_ = other.origOffDiag_;
+  changed_ = other.changed_;
+  tipUpdate_ = other.tipUpdate_;
+  // Only meaningful once decomposed. Not copying it otherwise keeps its memory.
+  if(decomposed_ && type_ == Type::DiagonalPlusLowRank) lowRankScale_ = other.lowRankScale_;
+  return *this;
+}
+
+void jrl::qp::structured::StructuredG::keepOriginal(bool keep)
+{
+  keep_ = keep;
+  if(!keep)
+  {
+    origDiag_.clear();
+    origOffDiag_.clear();
+    changed_.clear();
+  }
+}
+
+void jrl::qp::structured::StructuredG::updateDiag(int i, const MatrixConstRef & D)
+{
+  assert(keep_ && origDiag_.size() == diag_.size());
+  assert(D.rows() == diag(i).rows() && D.cols() == diag(i).cols());
+  // For Banded, D is the whole band
+  origDiag_[static_cast<size_t>(i)] = D;
+  changed_[static_cast<size_t>(i)] = true;
+}
+
+void jrl::qp::structured::StructuredG::updateOffDiag(int i, const MatrixConstRef & S)
+{
+  assert(keep_ && origOffDiag_.size() == offDiag_.size());
+  assert(S.rows() == offDiag(i).rows() && S.cols() == offDiag(i).cols());
+  origOffDiag_[static_cast<size_t>(i)] = S;
+  // Off-diagonal block i is used for the decomposition of diagonal block i+1 (row of the
+  // block for TriBlockDiagonal, block it links to the tip for BlockArrowUp) or i (block
+  // it links to the tip for BlockArrowDown, low-rank term for DiagonalPlusLowRank)
+  bool same = type_ == Type::BlockArrowDown || type_ == Type::DiagonalPlusLowRank;
+  changed_[static_cast<size_t>(same ? i : i + 1)] = true;
 }
 
 bool jrl::qp::structured::StructuredG::lltInPlace()
+{
+  if(keep_)
+  {
+    origDiag_.resize(diag_.size());
+    origOffDiag_.resize(offDiag_.size());
+    for(size_t i = 0; i < diag_.size(); ++i) origDiag_[i] = diag_[i];
+    for(size_t i = 0; i < offDiag_.size(); ++i) origOffDiag_[i] = offDiag_[i];
+  }
+  return decompose();
+}
+
+bool jrl::qp::structured::StructuredG::refactorize()
+{
+  assert(keep_ && origDiag_.size() == diag_.size());
+
+  int b = static_cast<int>(diag_.size());
+  int first = static_cast<int>(std::find(changed_.begin(), changed_.end(), true) - changed_.begin());
+  if(decomposed_ && first == b) return true;
+
+  // Cases where everything needs to be recomputed
+  if(!decomposed_ || parallel_ != (pool_ != nullptr) || (parallel_ && type_ == Type::TriBlockDiagonal)
+     || type_ == Type::Banded || type_ == Type::DiagonalPlusLowRank)
+  {
+    for(size_t i = 0; i < diag_.size(); ++i) diag_[i] = origDiag_[i];
+    for(size_t i = 0; i < offDiag_.size(); ++i) offDiag_[i] = origOffDiag_[i];
+    return decompose();
+  }
+
+  bool done = true;
+  if(type_ == Type::TriBlockDiagonal)
+  {
+    // The decomposition of the blocks before first is unchanged.
+    for(int i = first; i < b; ++i) diag_[static_cast<size_t>(i)] = origDiag_[static_cast<size_t>(i)];
+    for(int i = std::max(first - 1, 0); i < b - 1; ++i)
+      offDiag_[static_cast<size_t>(i)] = origOffDiag_[static_cast<size_t>(i)];
+    done = decomposition::triBlockDiagLLT(diag_, offDiag_, first);
+  }
+  else if(type_ == Type::BlockDiagonal)
+  {
+    for(int i = first; i < b && done; ++i)
+    {
+      size_t k = static_cast<size_t>(i);
+      if(!changed_[k]) continue;
+      diag_[k] = origDiag_[k];
+      done = internal::blockLLT(diag_[k]);
+    }
+  }
+  else
+  {
+    bool up = type_ == Type::BlockArrowUp;
+    int tip = up ? 0 : b - 1;
+    for(int i = first; i < b && done; ++i)
+    {
+      size_t k = static_cast<size_t>(i);
+      if(i == tip || !changed_[k]) continue;
+      size_t j = up ? k - 1 : k;
+
+      // Remove the previous contribution B B^T of the block, recompute the block and
+      // add its new contribution. For up = true, offDiag_ contains B^T.
+      if(up)
+        tipUpdate_.selfadjointView<Eigen::Lower>().rankUpdate(offDiag_[j].transpose(), -1.);
+      else
+        tipUpdate_.selfadjointView<Eigen::Lower>().rankUpdate(offDiag_[j], -1.);
+      diag_[k] = origDiag_[k];
+      offDiag_[j] = origOffDiag_[j];
+      done = internal::blockLLT(diag_[k]);
+      if(!done) break;
+      if(up)
+      {
+        internal::blockSolveLLeft(diag_[k], offDiag_[j]);
+        tipUpdate_.selfadjointView<Eigen::Lower>().rankUpdate(offDiag_[j].transpose(), 1.);
+      }
+      else
+      {
+        internal::blockSolveLTransposeRight(diag_[k], offDiag_[j]);
+        tipUpdate_.selfadjointView<Eigen::Lower>().rankUpdate(offDiag_[j], 1.);
+      }
+    }
+
+    if(done)
+    {
+      auto & Dt = diag_[static_cast<size_t>(tip)];
+      Dt = origDiag_[static_cast<size_t>(tip)];
+      Dt.triangularView<Eigen::Lower>() -= tipUpdate_;
+      done = internal::blockLLT(Dt);
+    }
+  }
+
+  decomposed_ = done;
+  if(done) std::fill(changed_.begin(), changed_.end(), false);
+  return done;
+}
+
+bool jrl::qp::structured::StructuredG::decompose()
 {
   bool done;
+  parallel_ = pool_ != nullptr;
   switch(type_)
   {
     case Type::TriBlockDiagonal:
-      done = decomposition::triBlockDiagLLT(diag_, offDiag_);
+      if(parallel_)
+      {
+        parallelTri_.threadPool(*pool_);
+        done = parallelTri_.compute(diag_, offDiag_);
+      }
+      else
+        done = decomposition::triBlockDiagLLT(diag_, offDiag_);
       break;
     case Type::BlockArrowUp:
-      done = decomposition::blockArrowLLT(diag_, offDiag_, true);
+      if(parallel_)
+        done = decomposition::blockArrowLLT(diag_, offDiag_, true, *pool_, work_);
+      else
+        done = decomposition::blockArrowLLT(diag_, offDiag_, true);
       break;
     case Type::BlockArrowDown:
-      done = decomposition::blockArrowLLT(diag_, offDiag_, false);
+      if(parallel_)
+        done = decomposition::blockArrowLLT(diag_, offDiag_, false, *pool_, work_);
+      else
+        done = decomposition::blockArrowLLT(diag_, offDiag_, false);
       break;
+    case Type::BlockDiagonal:
+      if(parallel_)
+        done = decomposition::blockDiagLLT(diag_, *pool_);
+      else
+        done = decomposition::blockDiagLLT(diag_);
+      break;
+    case Type::Banded:
+      // Sequential by nature
+      done = decomposition::bandLLT(diag_[0]);
+      break;
+    case Type::DiagonalPlusLowRank:
+    {
+      // Sequential: the work is in O(nk^2)
+      int k = rank();
+      lowRankScale_.resize(k);
+      // The workspace of the decomposition is also large enough for the solves.
+      done = decomposition::lowRankLLT(diag_[0], offDiag_[0], lowRankScale_, work_);
+      break;
+    }
     default:
       assert(false);
       done = false;
       break;
   }
   decomposed_ = done;
+
+  if(keep_ && done)
+  {
+    changed_.assign(diag_.size(), false);
+    if(type_ == Type::BlockArrowUp || type_ == Type::BlockArrowDown)
+    {
+      // Sum of the contributions to the tip: Dt - Lt Lt^T
+      size_t tip = type_ == Type::BlockArrowUp ? 0 : diag_.size() - 1;
+      int nt = nbVar(static_cast<int>(tip));
+      work_.resize(nt * nt);
+      auto Lt = work_.asMatrix(nt, nt, nt, {});
+      Lt = diag_[tip].triangularView<Eigen::Lower>();
+      tipUpdate_ = origDiag_[tip];
+      tipUpdate_.selfadjointView<Eigen::Lower>().rankUpdate(Lt, -1.);
+    }
+  }
   return done;
 }
 
@@ -50,13 +276,34 @@ void jrl::qp::structured::StructuredG::solveInPlaceLTranspose(VectorRef v) const
   switch(type_)
   {
     case Type::TriBlockDiagonal:
-      decomposition::triBlockDiagLTransposeSolve(diag_, offDiag_, v);
+      if(parallel_)
+        parallelTri_.solveLTranspose(diag_, offDiag_, v);
+      else
+        decomposition::triBlockDiagLTransposeSolve(diag_, offDiag_, v);
       break;
     case Type::BlockArrowUp:
-      decomposition::blockArrowLTransposeSolve(diag_, offDiag_, true, v);
+      if(parallel_)
+        decomposition::blockArrowLTransposeSolve(diag_, offDiag_, true, v, *pool_);
+      else
+        decomposition::blockArrowLTransposeSolve(diag_, offDiag_, true, v);
       break;
     case Type::BlockArrowDown:
-      decomposition::blockArrowLTransposeSolve(diag_, offDiag_, false, v);
+      if(parallel_)
+        decomposition::blockArrowLTransposeSolve(diag_, offDiag_, false, v, *pool_);
+      else
+        decomposition::blockArrowLTransposeSolve(diag_, offDiag_, false, v);
+      break;
+    case Type::BlockDiagonal:
+      if(parallel_)
+        decomposition::blockDiagLTransposeSolve(diag_, v, *pool_);
+      else
+        decomposition::blockDiagLTransposeSolve(diag_, v);
+      break;
+    case Type::Banded:
+      decomposition::bandLTransposeSolve(diag_[0], v);
+      break;
+    case Type::DiagonalPlusLowRank:
+      decomposition::lowRankLTransposeSolve(diag_[0], offDiag_[0], lowRankScale_, v, work_.asMatrix(rank(), 1, rank()));
       break;
     default:
       assert(false);
@@ -74,13 +321,34 @@ void jrl::qp::structured::StructuredG::solveL(VectorRef out, const VectorConstRe
   switch(type_)
   {
     case Type::TriBlockDiagonal:
-      decomposition::triBlockDiagLSolve(diag_, offDiag_, out);
+      if(parallel_)
+        parallelTri_.solveL(diag_, offDiag_, out);
+      else
+        decomposition::triBlockDiagLSolve(diag_, offDiag_, out);
       break;
     case Type::BlockArrowUp:
-      decomposition::blockArrowLSolve(diag_, offDiag_, true, out);
+      if(parallel_)
+        decomposition::blockArrowLSolve(diag_, offDiag_, true, out, *pool_, work_);
+      else
+        decomposition::blockArrowLSolve(diag_, offDiag_, true, out);
       break;
     case Type::BlockArrowDown:
-      decomposition::blockArrowLSolve(diag_, offDiag_, false, out);
+      if(parallel_)
+        decomposition::blockArrowLSolve(diag_, offDiag_, false, out, *pool_, work_);
+      else
+        decomposition::blockArrowLSolve(diag_, offDiag_, false, out);
+      break;
+    case Type::BlockDiagonal:
+      if(parallel_)
+        decomposition::blockDiagLSolve(diag_, out, *pool_);
+      else
+        decomposition::blockDiagLSolve(diag_, out);
+      break;
+    case Type::Banded:
+      decomposition::bandLSolve(diag_[0], out);
+      break;
+    case Type::DiagonalPlusLowRank:
+      decomposition::lowRankLSolve(diag_[0], offDiag_[0], lowRankScale_, out, work_.asMatrix(rank(), 1, rank()));
       break;
     default:
       assert(false);
@@ -98,13 +366,36 @@ void jrl::qp::structured::StructuredG::solveL(VectorRef out, const internal::Sin
   switch(type_)
   {
     case Type::TriBlockDiagonal:
-      decomposition::triBlockDiagLSolve(diag_, offDiag_, out, in.start());
+      if(parallel_)
+        parallelTri_.solveL(diag_, offDiag_, out, in.start());
+      else
+        decomposition::triBlockDiagLSolve(diag_, offDiag_, out, in.start());
       break;
     case Type::BlockArrowUp:
-      decomposition::blockArrowLSolve(diag_, offDiag_, true, out, in.start(), in.end());
+      if(parallel_)
+        decomposition::blockArrowLSolve(diag_, offDiag_, true, out, *pool_, work_, in.start(), in.end());
+      else
+        decomposition::blockArrowLSolve(diag_, offDiag_, true, out, in.start(), in.end());
       break;
     case Type::BlockArrowDown:
-      decomposition::blockArrowLSolve(diag_, offDiag_, false, out, in.start(), in.end());
+      if(parallel_)
+        decomposition::blockArrowLSolve(diag_, offDiag_, false, out, *pool_, work_, in.start(), in.end());
+      else
+        decomposition::blockArrowLSolve(diag_, offDiag_, false, out, in.start(), in.end());
+      break;
+    case Type::BlockDiagonal:
+      // Only the blocks intersecting the non-zero segment are non-zero in the result.
+      if(parallel_)
+        decomposition::blockDiagLSolve(diag_, out, *pool_, in.start(), in.end());
+      else
+        decomposition::blockDiagLSolve(diag_, out, in.start(), in.end());
+      break;
+    case Type::Banded:
+      decomposition::bandLSolve(diag_[0], out, in.start());
+      break;
+    case Type::DiagonalPlusLowRank:
+      // The low-rank term fills the whole result.
+      decomposition::lowRankLSolve(diag_[0], offDiag_[0], lowRankScale_, out, work_.asMatrix(rank(), 1, rank()));
       break;
     default:
       assert(false);
@@ -33,10 +33,11 @@ void StructuredJ::premultByJ2(VectorRef out, const VectorConstRef & in) const
 {
   assert(out.size() == nbVar_);
   assert(in.size() == Q_.m2());
-  // [OPTIM] The 3 next line are emulating out = Q2 * in by performing out = Q * [0;in]. This can be optimized.
+  // out = Q2 * in = Q * [0;in]. The zero head is only touched once an element of Q
+  // reaches it.
   out.tail(Q_.m2()) = in;
   out.head(Q_.m1()).setZero();
-  Q_.Q().applyToTheLeft(out);
+  Q_.Q().applyToTheLeft(out, Q_.m1(), Q_.m2());
   L_->solveInPlaceLTranspose(out);
 }
 
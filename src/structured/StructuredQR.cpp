@@ -13,6 +13,8 @@ void StructuredQR::adjustLdR(int q) const
   if(q > ldR_)
   {
     int newLdR = std::min(2 * ldR_, nbVar_);
+    // The storage of R grows with the number of active constraints, not with nbVar_.
+    work_R_.conservativeResize(newLdR * newLdR);
     work_R_.changeLd(q_, q_, ldR_, newLdR);
     ldR_ = newLdR;
   }
@@ -43,12 +45,28 @@ void StructuredQR::reset()
 
 void StructuredQR::resize(int nbVar)
 {
+  nbVar_ = nbVar;
+  ldR_ = std::max(1, std::min(10, static_cast<int>(std::sqrt(nbVar)))); // TODO Ability to change this heuristics.
+  // R and the arena of Q_ are preallocated for m active constraints. Beyond, they grow
+  // with the number of active constraints, and keep their memory for the next solves.
+  int m = reserveHint_ < 0 ? nbVar : std::min(std::max(reserveHint_, ldR_), nbVar);
   Q_.resize(nbVar);
-  work_R_.resize(nbVar, nbVar);
+  // Each addition or removal of a constraint adds an element to Q_. We preallocate for
+  // a reasonable number of active set changes, to avoid allocations during the solve.
+  Q_.reserve(2 * m);
+  work_R_.resize(m * m);
   work_tmp_.resize(nbVar);
   work_essential_.resize(nbVar);
-  nbVar_ = nbVar;
-  ldR_ = std::min(10, static_cast<int>(std::sqrt(nbVar))); // TODO Ability to change this heuristics.
+}
+
+void StructuredQR::reserveHint(int nbActive)
+{
+  reserveHint_ = nbActive;
+}
+
+void StructuredQR::compactionRatio(double r)
+{
+  Q_.compactionRatio(r);
 }
 
 internal::PartitionnedQ StructuredQR::getPartitionnedQ() const
@@ -67,9 +85,20 @@ void StructuredQR::RSolve(VectorRef out, const VectorConstRef & in) const
   assert(out.size() == q_);
   out = getUpperTriangularR(q_).solve(in);
 }
+
+void StructuredQR::RTransposeSolve(VectorRef out, const VectorConstRef & in) const
+{
+  assert(in.size() == q_);
+  assert(out.size() == q_);
+  out = getUpperTriangularR(q_).transpose().solve(in);
+}
+
 bool StructuredQR::add(const VectorConstRef & d)
 {
   assert(d.size() == nbVar_);
+  // d.tail(nbVar_ - q_) is the part of the new column orthogonal to the current ones.
+  if(!(d.tail(nbVar_ - q_).norm() > 1e-12 * d.norm())) return false; //[NUMERIC] better criterion
+
   double beta, tau;
   WVector e = work_essential_.asVector(nbVar_ - q_ - 1);
   d.tail(nbVar_ - q_).makeHouseholder(e, tau, beta);
@@ -80,7 +109,7 @@ bool StructuredQR::add(const VectorConstRef & d)
   Q_.add(q_, e, tau);
   ++q_;
 
-  return true; //[NUMERIC]: add test on dependency
+  return true;
 }
 
 bool StructuredQR::remove(int l)
@@ -88,8 +117,26 @@ bool StructuredQR::remove(int l)
   --q_;
   auto R = getR(q_ + 1);
 
-  Q_.prepare(internal::OSeqType::Givens, q_ - l + 1, q_ - l);
-  for(int i = l; i < q_; ++i)
+  // As long as R(i,i+1) = 0, the Givens rotation zeroing R(i+1,i+1) is a mere swap of
+  // the rows i and i+1. We record these swaps as a permutation, which is much cheaper
+  // to apply to a vector than a rotation.
+  int i = l;
+  for(; i < q_ && R(i, i + 1) == 0; ++i)
+  {
+    R.col(i).head(i) = R.col(i + 1).head(i);
+    R(i, i) = R(i + 1, i + 1);
+    JRLQP_DEBUG_ONLY(R(i + 1, i + 1) = 0);
+    R.rightCols(q_ - i - 1).row(i).swap(R.rightCols(q_ - i - 1).row(i + 1));
+  }
+  if(i > l)
+  {
+    Q_.prepare(internal::OSeqType::Permutation, i - l + 1, i - l);
+    for(int j = 0; j < i - l; ++j) Q_.add(l, j, j + 1);
+  }
+  if(i == q_) return false;
+
+  Q_.prepare(internal::OSeqType::Givens, q_ - i + 1, q_ - i);
+  for(; i < q_; ++i)
   {
     Givens Qi;
     R.col(i).head(i) = R.col(i + 1).head(i);
@@ -0,0 +1,115 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <jrl-qp/test/optimalControlProblems.h>
+
+namespace jrl::qp::test
+{
+QPProblem<> OptimalControlProblem::toDense() const
+{
+  int ns = nx + nu;
+  int nbVar = N * ns + nx;
+  int m = static_cast<int>(bl.size());
+  int nbCstr = nx + N * nx + m;
+
+  QPProblem<> pb;
+  pb.G = Eigen::MatrixXd::Zero(nbVar, nbVar);
+  pb.a = a;
+  pb.C = Eigen::MatrixXd::Zero(nbVar, nbCstr);
+  pb.l.resize(nbCstr);
+  pb.u.resize(nbCstr);
+  pb.xl = xl;
+  pb.xu = xu;
+  pb.transposedMat = true;
+
+  // x_0 = x0
+  pb.C.topLeftCorner(nx, nx).setIdentity();
+  pb.l.head(nx) = x0;
+  pb.u.head(nx) = x0;
+  int c0 = nx;
+  for(int k = 0; k <= N; ++k)
+  {
+    int nk = k < N ? ns : nx;
+    pb.G.block(k * ns, k * ns, nk, nk) = H[static_cast<size_t>(k)];
+    if(k < N)
+    {
+      // x_{k+1} - F_k y_k = c_k
+      pb.C.block(k * ns, c0, ns, nx) = -F[static_cast<size_t>(k)].transpose();
+      pb.C.block((k + 1) * ns, c0, nx, nx).setIdentity();
+      pb.l.segment(c0, nx) = c.segment(k * nx, nx);
+      pb.u.segment(c0, nx) = c.segment(k * nx, nx);
+      c0 += nx;
+    }
+  }
+  int r = 0;
+  for(int k = 0; k <= N; ++k)
+  {
+    const auto & Ck = C[static_cast<size_t>(k)];
+    int mk = static_cast<int>(Ck.cols());
+    pb.C.block(k * ns, c0 + r, Ck.rows(), mk) = Ck;
+    r += mk;
+  }
+  pb.l.tail(m) = bl;
+  pb.u.tail(m) = bu;
+
+  return pb;
+}
+
+OptimalControlProblem randomOptimalControlProblem(int nx, int nu, int N, int m, bool useBounds)
+{
+  int ns = nx + nu;
+  int nbVar = N * ns + nx;
+
+  OptimalControlProblem pb;
+  pb.nx = nx;
+  pb.nu = nu;
+  pb.N = N;
+  pb.x0 = Eigen::VectorXd::Random(nx);
+  pb.c = 0.1 * Eigen::VectorXd::Random(N * nx);
+  pb.a = Eigen::VectorXd::Random(nbVar);
+
+  // Reference trajectory around which the constraints are built, so that the problem
+  // is feasible.
+  Eigen::VectorXd y(nbVar);
+  y.head(nx) = pb.x0;
+  for(int k = 0; k <= N; ++k)
+  {
+    int nk = k < N ? ns : nx;
+    Eigen::MatrixXd R = Eigen::MatrixXd::Random(nk, nk);
+    pb.H.push_back(R.transpose() * R + Eigen::MatrixXd::Identity(nk, nk));
+    pb.C.push_back(Eigen::MatrixXd::Random(nk, m));
+    if(k < N)
+    {
+      // Contractive A_k so that the trajectories stay bounded for long horizons
+      Eigen::MatrixXd F = Eigen::MatrixXd::Random(nx, ns);
+      F.leftCols(nx) *= 0.95 / F.leftCols(nx).cwiseAbs().rowwise().sum().maxCoeff();
+      pb.F.push_back(F);
+      y.segment(k * ns + nx, nu).setRandom();
+      y.segment((k + 1) * ns, nx) = F * y.segment(k * ns, ns) + pb.c.segment(k * nx, nx);
+    }
+  }
+
+  pb.bl.resize((N + 1) * m);
+  pb.bu.resize((N + 1) * m);
+  for(int k = 0; k <= N; ++k)
+  {
+    const auto & Ck = pb.C[static_cast<size_t>(k)];
+    Eigen::VectorXd cy = Ck.transpose() * y.segment(k * ns, Ck.rows());
+    pb.bl.segment(k * m, m) = cy - Eigen::VectorXd::Random(m).cwiseAbs() - Eigen::VectorXd::Constant(m, 0.1);
+    pb.bu.segment(k * m, m) = cy + Eigen::VectorXd::Random(m).cwiseAbs() + Eigen::VectorXd::Constant(m, 0.1);
+  }
+
+  if(useBounds)
+  {
+    pb.xl = y - Eigen::VectorXd::Random(nbVar).cwiseAbs() - Eigen::VectorXd::Constant(nbVar, 0.1);
+    pb.xu = y + Eigen::VectorXd::Random(nbVar).cwiseAbs() + Eigen::VectorXd::Constant(nbVar, 0.1);
+  }
+  else
+  {
+    pb.xl.resize(0);
+    pb.xu.resize(0);
+  }
+  pb.a *= 10;
+
+  return pb;
+}
+} // namespace jrl::qp::test
@@ -53,14 +53,25 @@ SeparatedFeasibilityConstraints::SeparatedFeasibilityConstraints(const Feasibili
   int nineq = 0;
   for(int i = 0; i < feas.l.size(); ++i)
   {
-    if(l[i] == u[i]) ++neq;
+    if(feas.l[i] == feas.u[i]) ++neq;
   }
-
-  neq = 0;
+  f.resize(neq);
+  l.resize(feas.l.size() - neq);
+  u.resize(feas.u.size() - neq);
   if(transposedMat)
   {
     C.resize(feas.C.rows(), feas.C.cols() - neq);
     E.resize(feas.C.rows(), neq);
+  }
+  else
+  {
+    C.resize(feas.C.rows() - neq, feas.C.cols());
+    E.resize(neq, feas.C.cols());
+  }
+
+  neq = 0;
+  if(transposedMat)
+  {
     for(int i = 0; i < feas.l.size(); ++i)
     {
       if(feas.l[i] == feas.u[i])
@@ -80,8 +91,6 @@ SeparatedFeasibilityConstraints::SeparatedFeasibilityConstraints(const Feasibili
   }
   else
   {
-    C.resize(feas.C.rows() - neq, feas.C.cols());
-    E.resize(neq, feas.C.cols());
     for(int i = 0; i < feas.l.size(); ++i)
     {
       if(feas.l[i] == feas.u[i])
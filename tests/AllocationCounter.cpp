@@ -0,0 +1,96 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+namespace
+{
+std::atomic<long long> nbAllocations{0};
+} // namespace
+
+#if defined(__GLIBC__)
+// With glibc, we can interpose malloc and friends. This catches the allocations
+// done by Eigen, which calls std::malloc directly. operator new relies on malloc
+// so that its allocations are counted here.
+#  define JRLQP_COUNT_IN_NEW false
+extern "C"
+{
+  void * __libc_malloc(std::size_t size);
+  void * __libc_calloc(std::size_t n, std::size_t size);
+  void * __libc_realloc(void * ptr, std::size_t size);
+
+  void * malloc(std::size_t size)
+  {
+    ++nbAllocations;
+    return __libc_malloc(size);
+  }
+
+  void * calloc(std::size_t n, std::size_t size)
+  {
+    ++nbAllocations;
+    return __libc_calloc(n, size);
+  }
+
+  void * realloc(void * ptr, std::size_t size)
+  {
+    ++nbAllocations;
+    return __libc_realloc(ptr, size);
+  }
+}
+#else
+#  define JRLQP_COUNT_IN_NEW true
+#endif
+
+void * operator new(std::size_t size)
+{
+  if(JRLQP_COUNT_IN_NEW) ++nbAllocations;
+  if(void * p = std::malloc(size > 0 ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size)
+{
+  return ::operator new(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  if(JRLQP_COUNT_IN_NEW) ++nbAllocations;
+  return std::malloc(size > 0 ? size : 1);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t & tag) noexcept
+{
+  return ::operator new(size, tag);
+}
+
+void operator delete(void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace jrl::qp::test
+{
+long long allocationCount()
+{
+  return nbAllocations.load(std::memory_order_relaxed);
+}
+} // namespace jrl::qp::test
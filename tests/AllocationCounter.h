@@ -0,0 +1,38 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#pragma once
+
+namespace jrl::qp::test
+{
+/** Number of heap allocations performed by the program since its start.
+ *
+ * The count is obtained by replacing the global operator new (and, with glibc,
+ * malloc, calloc and realloc so that the allocations made by Eigen are counted as
+ * well). Linking AllocationCounter.cpp into a target is enough to enable it.
+ */
+long long allocationCount();
+
+/** Count the heap allocations made between the construction of the object and
+ * the call to count().
+ */
+class AllocationCounter
+{
+public:
+  AllocationCounter() : start_(allocationCount()) {}
+
+  /** Number of allocations since the construction or the last call to reset().*/
+  long long count() const
+  {
+    return allocationCount() - start_;
+  }
+
+  /** Restart the count from 0.*/
+  void reset()
+  {
+    start_ = allocationCount();
+  }
+
+private:
+  long long start_;
+};
+} // namespace jrl::qp::test
@@ -0,0 +1,333 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <limits>
+#include <vector>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include "doctest/doctest.h"
+
+#include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/AutoSolver.h>
+#include <jrl-qp/experimental/BlockGISolver.h>
+#include <jrl-qp/experimental/BoxAndSingleConstraintSolver.h>
+#include <jrl-qp/experimental/DiagonalHessianSolver.h>
+#include <jrl-qp/experimental/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/structured/ProblemPattern.h>
+#include <jrl-qp/test/randomProblems.h>
+
+#include "AllocationCounter.h"
+
+using namespace Eigen;
+using namespace jrl::qp;
+using namespace jrl::qp::test;
+
+namespace
+{
+/** Problem data copied beforehand, so that calling the solver does not require any
+ * conversion (e.g. transposing C).
+ */
+struct DenseProblem
+{
+  DenseProblem(const RandomLeastSquare & pb) : bounds(pb.bounds)
+  {
+    QPProblem qpp(pb);
+    G = qpp.G;
+    a = qpp.a;
+    C = qpp.C.transpose();
+    l = qpp.l;
+    u = qpp.u;
+    xl = qpp.xl;
+    xu = qpp.xu;
+  }
+
+  MatrixXd G;
+  VectorXd a;
+  MatrixXd C;
+  VectorXd l;
+  VectorXd u;
+  VectorXd xl;
+  VectorXd xu;
+  bool bounds;
+};
+
+std::vector<DenseProblem> denseProblems()
+{
+  std::vector<DenseProblem> problems;
+  // All problems have 8 variables, and are padded with inactive constraints to have
+  // 10 general constraints and bounds.
+  std::vector pbs = {randomProblem(ProblemCharacteristics(8, 8).nIneq(10).bounds(true)),
+                     randomProblem(ProblemCharacteristics(8, 8).nIneq(10).nStrongActIneq(4).bounds(true)),
+                     randomProblem(ProblemCharacteristics(8, 8, 3, 7).nStrongActIneq(3).bounds(true)),
+                     randomProblem(ProblemCharacteristics(8, 8, 2, 8).nStrongActIneq(2).bounds(true).nStrongActBounds(2))};
+  for(const auto & pb : pbs) problems.emplace_back(pb);
+  return problems;
+}
+} // namespace
+
+TEST_CASE_TEMPLATE("Dense solvers", T, GoldfarbIdnaniSolver, experimental::GoldfarbIdnaniSolver)
+{
+  auto problems = denseProblems();
+  MatrixXd G(8, 8);
+  T solver(8, 10, true);
+
+  // First round: the solver may allocate memory.
+  for(const auto & pb : problems)
+  {
+    G = pb.G;
+    FAST_CHECK_EQ(solver.solve(G, pb.a, pb.C, pb.l, pb.u, pb.xl, pb.xu), TerminationStatus::SUCCESS);
+  }
+
+  // Next rounds: no allocation should occur, with or without warm start.
+  for(bool warmStart : {false, true})
+  {
+    SolverOptions opt;
+    opt.warmStart(warmStart);
+    solver.options(opt);
+    for(const auto & pb : problems)
+    {
+      G = pb.G;
+      AllocationCounter counter;
+      auto ret = solver.solve(G, pb.a, pb.C, pb.l, pb.u, pb.xl, pb.xu);
+      auto n = counter.count();
+      FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+      FAST_CHECK_EQ(n, 0);
+      counter.reset();
+      solver.multipliers();
+      FAST_CHECK_EQ(counter.count(), 0);
+    }
+  }
+}
+
+TEST_CASE("BoxAndSingleConstraintSolver")
+{
+  const int nbVar = 10;
+  experimental::BoxAndSingleConstraintSolver solver(nbVar);
+  std::vector<LeastSquareProblem<>> problems;
+  for(int i = 0; i < 5; ++i)
+  {
+    problems.push_back(generateBoxAndSingleConstraintProblem(nbVar, i % 2));
+  }
+
+  for(const auto & pb : problems)
+  {
+    solver.solve(pb.b, pb.C, pb.l[0], pb.xl, pb.xu);
+  }
+
+  for(const auto & pb : problems)
+  {
+    AllocationCounter counter;
+    auto ret = solver.solve(pb.b, pb.C, pb.l[0], pb.xl, pb.xu);
+    auto n = counter.count();
+    FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+    FAST_CHECK_EQ(n, 0);
+  }
+}
+
+TEST_CASE("AutoSolver with a box and a single constraint")
+{
+  const int nbVar = 10;
+  VectorXd d = VectorXd::Random(nbVar).array() + 1.5;
+  MatrixXd G = d.asDiagonal();
+  MatrixXd C = MatrixXd::Random(nbVar, 1);
+  VectorXd l = VectorXd::Constant(1, -1);
+  VectorXd u = VectorXd::Constant(1, std::numeric_limits<double>::infinity());
+  VectorXd xl = VectorXd::Constant(nbVar, -2);
+  VectorXd xu = VectorXd::Constant(nbVar, 2);
+
+  std::vector<VectorXd> as;
+  for(int i = 0; i < 5; ++i) as.push_back(10 * VectorXd::Random(nbVar));
+
+  // The structure is analyzed at the first solve, and kept for the next ones.
+  experimental::AutoSolver solver;
+  for(const auto & a : as) solver.solve(G, a, C, l, u, xl, xu);
+  FAST_CHECK_EQ(solver.structure().backend, experimental::AutoSolver::Backend::BoxAndSingleConstraint);
+
+  for(const auto & a : as)
+  {
+    AllocationCounter counter;
+    auto ret = solver.solve(G, a, C, l, u, xl, xu);
+    auto nAlloc = counter.count();
+    FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+    FAST_CHECK_EQ(nAlloc, 0);
+  }
+}
+
+TEST_CASE("BlockGISolver")
+{
+  // Tri-block-diagonal objective, with diagonal-block constraints and bounds.
+  std::vector n = {3, 5, 2, 3};
+  std::vector mi = {3, 3, 3, 3};
+  const int nbVar = 13;
+  const int nbCstr = 12;
+
+  MatrixXd A = MatrixXd::Zero(nbVar, nbVar);
+  int k = 0;
+  for(size_t i = 0; i < n.size(); ++i)
+  {
+    A.block(k, k, n[i], n[i]).setRandom();
+    if(i + 1 < n.size()) A.block(k + n[i], k, n[i + 1], n[i]).setRandom();
+    k += n[i];
+  }
+  const MatrixXd G0 = A * A.transpose() + MatrixXd::Identity(nbVar, nbVar);
+  MatrixXd GDense = G0;
+  std::vector<MatrixRef> D = {GDense.block(0, 0, 3, 3), GDense.block(3, 3, 5, 5), GDense.block(8, 8, 2, 2),
+                              GDense.block(10, 10, 3, 3)};
+  std::vector<MatrixRef> S = {GDense.block(3, 0, 5, 3), GDense.block(8, 3, 2, 5), GDense.block(10, 8, 3, 2)};
+  structured::StructuredG G(structured::StructuredG::Type::TriBlockDiagonal, D, S);
+
+  MatrixXd C0 = MatrixXd::Zero(nbVar, nbCstr);
+  std::vector<MatrixConstRef> Cs;
+  int r = 0;
+  int c = 0;
+  for(size_t i = 0; i < n.size(); ++i)
+  {
+    C0.block(r, c, n[i], mi[i]).setRandom();
+    Cs.push_back(C0.block(r, c, n[i], mi[i]));
+    r += n[i];
+    c += mi[i];
+  }
+  structured::StructuredC C(Cs);
+  VectorXd l = VectorXd::Constant(nbCstr, -1);
+  VectorXd u = VectorXd::Constant(nbCstr, 1);
+  VectorXd xl = VectorXd::Constant(nbVar, -2);
+  VectorXd xu = VectorXd::Constant(nbVar, 2);
+
+  std::vector<VectorXd> as;
+  for(int i = 0; i < 5; ++i) as.push_back(10 * VectorXd::Random(nbVar));
+
+  experimental::BlockGISolver solver(nbVar, nbCstr, true);
+  for(const auto & a : as)
+  {
+    GDense = G0;
+    solver.solve(G, a, C, l, u, xl, xu);
+  }
+
+  for(const auto & a : as)
+  {
+    GDense = G0;
+    AllocationCounter counter;
+    auto ret = solver.solve(G, a, C, l, u, xl, xu);
+    auto nAlloc = counter.count();
+    FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+    FAST_CHECK_EQ(nAlloc, 0);
+  }
+}
+
+TEST_CASE("BlockGISolver with ProblemPattern")
+{
+  // The pattern is built once. Writing the values of a new problem and solving it does
+  // not allocate.
+  std::vector n = {3, 5, 2, 3};
+  std::vector m = {3, 3, 3, 3};
+  const int nbVar = 13;
+  const int nbCstr = 12;
+  structured::ProblemPattern pattern(structured::StructuredG::Type::BlockDiagonal, n, m, 1);
+
+  std::vector<MatrixXd> Gs;
+  std::vector<MatrixXd> Cs;
+  for(int i = 0; i < 5; ++i)
+  {
+    MatrixXd A = MatrixXd::Zero(nbVar, nbVar);
+    MatrixXd C = MatrixXd::Zero(nbVar, nbCstr);
+    for(int j = 0, r = 0, c = 0; j < 4; r += n[j], c += m[j], ++j)
+    {
+      A.block(r, r, n[j], n[j]).setRandom();
+      C.block(r, c, n[j], m[j]).setRandom();
+      if(j < 3) C.block(r + n[j], c, n[j + 1], m[j]).setRandom();
+    }
+    Gs.push_back(A * A.transpose() + MatrixXd::Identity(nbVar, nbVar));
+    Cs.push_back(C);
+  }
+  VectorXd a = VectorXd::Random(nbVar);
+  VectorXd l = VectorXd::Constant(nbCstr, -1);
+  VectorXd u = VectorXd::Constant(nbCstr, 1);
+  VectorXd xl = VectorXd::Constant(nbVar, -2);
+  VectorXd xu = VectorXd::Constant(nbVar, 2);
+
+  experimental::BlockGISolver solver(pattern.nbVar(), pattern.nbCstr(), true);
+  for(size_t i = 0; i < Gs.size(); ++i)
+  {
+    pattern.setG(Gs[i]);
+    pattern.setC(Cs[i]);
+    solver.solve(pattern.G(), a, pattern.C(), l, u, xl, xu);
+  }
+
+  for(size_t i = 0; i < Gs.size(); ++i)
+  {
+    AllocationCounter counter;
+    pattern.setG(Gs[i]);
+    pattern.setC(Cs[i]);
+    auto ret = solver.solve(pattern.G(), a, pattern.C(), l, u, xl, xu);
+    auto nAlloc = counter.count();
+    FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+    FAST_CHECK_EQ(nAlloc, 0);
+  }
+}
+
+TEST_CASE("DiagonalHessianSolver")
+{
+  const int nbVar = 20;
+  const int nbCstr = 8;
+  VectorXd g = VectorXd::Random(nbVar).array() + 1.5;
+  MatrixXd C = MatrixXd::Random(nbVar, nbCstr);
+  VectorXd l = VectorXd::Constant(nbCstr, -1);
+  VectorXd u = VectorXd::Constant(nbCstr, 1);
+  VectorXd xl = VectorXd::Constant(nbVar, -2);
+  VectorXd xu = VectorXd::Constant(nbVar, 2);
+
+  std::vector<VectorXd> as;
+  for(int i = 0; i < 5; ++i) as.push_back(10 * VectorXd::Random(nbVar));
+
+  experimental::DiagonalHessianSolver solver(nbVar, nbCstr, true);
+  for(const auto & a : as) solver.solve(g, a, C, l, u, xl, xu);
+
+  for(const auto & a : as)
+  {
+    AllocationCounter counter;
+    auto ret = solver.solve(g, a, C, l, u, xl, xu);
+    auto nAlloc = counter.count();
+    FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+    FAST_CHECK_EQ(nAlloc, 0);
+  }
+}
+
+TEST_CASE("BlockGISolver with a diagonal plus low-rank objective")
+{
+  const int nbVar = 20;
+  const int nbCstr = 8;
+  const int k = 3;
+  const MatrixXd d0 = MatrixXd::Random(1, nbVar).array() + 1.5;
+  const MatrixXd U0 = MatrixXd::Random(nbVar, k);
+  MatrixXd d = d0;
+  MatrixXd U = U0;
+  structured::StructuredG G(d, U);
+  MatrixXd C0 = MatrixXd::Random(nbVar, nbCstr);
+  structured::StructuredC C({C0});
+  VectorXd l = VectorXd::Constant(nbCstr, -1);
+  VectorXd u = VectorXd::Constant(nbCstr, 1);
+  VectorXd xl = VectorXd::Constant(nbVar, -2);
+  VectorXd xu = VectorXd::Constant(nbVar, 2);
+
+  std::vector<VectorXd> as;
+  for(int i = 0; i < 5; ++i) as.push_back(10 * VectorXd::Random(nbVar));
+
+  experimental::BlockGISolver solver(nbVar, nbCstr, true);
+  for(const auto & a : as)
+  {
+    d = d0;
+    U = U0;
+    solver.solve(G, a, C, l, u, xl, xu);
+  }
+
+  for(const auto & a : as)
+  {
+    d = d0;
+    U = U0;
+    AllocationCounter counter;
+    auto ret = solver.solve(G, a, C, l, u, xl, xu);
+    auto nAlloc = counter.count();
+    FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+    FAST_CHECK_EQ(nAlloc, 0);
+  }
+}
@@ -0,0 +1,268 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include "doctest/doctest.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/AutoSolver.h>
+
+using namespace Eigen;
+using namespace jrl::qp;
+using namespace jrl::qp::experimental;
+using GType = jrl::qp::structured::StructuredG::Type;
+
+namespace
+{
+struct Problem
+{
+  MatrixXd G;
+  VectorXd a;
+  MatrixXd C;
+  VectorXd l;
+  VectorXd u;
+  VectorXd xl;
+  VectorXd xu;
+};
+
+/** Random symmetric positive definite matrix with the pattern given by the lower
+ * triangular part of \p mask, made diagonally dominant.
+ */
+MatrixXd randomG(const Matrix<bool, Dynamic, Dynamic> & mask)
+{
+  const int n = static_cast<int>(mask.rows());
+  MatrixXd G = MatrixXd::Zero(n, n);
+  for(int j = 0; j < n; ++j)
+  {
+    for(int i = j + 1; i < n; ++i)
+    {
+      if(mask(i, j)) G(i, j) = G(j, i) = Eigen::internal::random<double>();
+    }
+  }
+  for(int i = 0; i < n; ++i) G(i, i) = G.row(i).cwiseAbs().sum() + 1;
+  return G;
+}
+
+/** Random feasible problem with the pattern \p mask for G and where constraint k acts
+ * on the variables [rows[k].first, rows[k].second). The constraints are shuffled.
+ */
+Problem randomProblem(const Matrix<bool, Dynamic, Dynamic> & mask,
+                      std::vector<std::pair<int, int>> rows,
+                      bool useBounds)
+{
+  const int n = static_cast<int>(mask.rows());
+  const int m = static_cast<int>(rows.size());
+  static std::mt19937 gen(42);
+  std::shuffle(rows.begin(), rows.end(), gen);
+  Problem pb;
+  pb.G = randomG(mask);
+  pb.a = 10 * VectorXd::Random(n);
+  pb.C = MatrixXd::Zero(n, m);
+  for(int k = 0; k < m; ++k)
+  {
+    int r0 = rows[static_cast<size_t>(k)].first;
+    int r1 = rows[static_cast<size_t>(k)].second;
+    pb.C.col(k).segment(r0, r1 - r0).setRandom();
+  }
+  VectorXd x = VectorXd::Random(n);
+  VectorXd cx = pb.C.transpose() * x;
+  pb.l = cx - VectorXd::Random(m).cwiseAbs() - VectorXd::Constant(m, 0.1);
+  pb.u = cx + VectorXd::Random(m).cwiseAbs() + VectorXd::Constant(m, 0.1);
+  if(useBounds)
+  {
+    pb.xl = x - VectorXd::Random(n).cwiseAbs() - VectorXd::Constant(n, 0.1);
+    pb.xu = x + VectorXd::Random(n).cwiseAbs() + VectorXd::Constant(n, 0.1);
+  }
+  return pb;
+}
+
+using Mask = Matrix<bool, Dynamic, Dynamic>;
+
+Mask blockMask(const std::vector<int> & blocks, bool tri)
+{
+  int n = std::accumulate(blocks.begin(), blocks.end(), 0);
+  Mask mask = Mask::Constant(n, n, false);
+  for(int i = 0, r = 0; i < static_cast<int>(blocks.size()); r += blocks[static_cast<size_t>(i)], ++i)
+  {
+    int ni = blocks[static_cast<size_t>(i)];
+    mask.block(r, r, ni, ni).setConstant(true);
+    if(tri && i > 0)
+    {
+      int nj = blocks[static_cast<size_t>(i - 1)];
+      mask.block(r, r - nj, ni, nj).setConstant(true);
+    }
+  }
+  return mask;
+}
+
+/** m constraints on each block, or on each pair of consecutive blocks if tri is true.*/
+std::vector<std::pair<int, int>> blockConstraints(const std::vector<int> & blocks, int m, bool tri)
+{
+  std::vector<std::pair<int, int>> rows;
+  for(int i = 0, r = 0; i < static_cast<int>(blocks.size()); r += blocks[static_cast<size_t>(i)], ++i)
+  {
+    int end = r + blocks[static_cast<size_t>(i)];
+    if(tri && i + 1 < static_cast<int>(blocks.size())) end += blocks[static_cast<size_t>(i + 1)];
+    for(int k = 0; k < m; ++k) rows.emplace_back(r, end);
+  }
+  return rows;
+}
+
+/** Solve with AutoSolver and with the dense solver, and compare.*/
+void compare(AutoSolver & solver, const Problem & pb)
+{
+  MatrixXd G = pb.G;
+  GoldfarbIdnaniSolver dense(static_cast<int>(G.rows()), static_cast<int>(pb.C.cols()), pb.xl.size() > 0);
+  auto retD = dense.solve(G, pb.a, pb.C, pb.l, pb.u, pb.xl, pb.xu);
+  auto ret = solver.solve(pb.G, pb.a, pb.C, pb.l, pb.u, pb.xl, pb.xu);
+  FAST_CHECK_EQ(retD, TerminationStatus::SUCCESS);
+  FAST_CHECK_EQ(ret, retD);
+  FAST_CHECK_UNARY(solver.solution().isApprox(dense.solution(), 1e-8));
+  FAST_CHECK_EQ(solver.objectiveValue(), doctest::Approx(dense.objectiveValue()));
+  FAST_CHECK_UNARY(solver.activeSet() == dense.activeSet());
+}
+} // namespace
+
+TEST_CASE("Block structures")
+{
+  std::vector<int> blocks = {15, 12, 15, 14, 15, 16, 13, 15, 14, 15, 12, 15};
+  for(bool useBounds : {false, true})
+  {
+    AutoSolver solver;
+    auto pb = randomProblem(blockMask(blocks, false), blockConstraints(blocks, 4, false), useBounds);
+    compare(solver, pb);
+    FAST_CHECK_EQ(solver.structure().backend, AutoSolver::Backend::Block);
+    FAST_CHECK_EQ(solver.structure().gType, GType::BlockDiagonal);
+    FAST_CHECK_UNARY(solver.structure().blocks == blocks);
+    FAST_CHECK_EQ(solver.structure().cBandwidth, 0);
+
+    AutoSolver solver2;
+    pb = randomProblem(blockMask(blocks, true), blockConstraints(blocks, 4, false), useBounds);
+    compare(solver2, pb);
+    FAST_CHECK_EQ(solver2.structure().backend, AutoSolver::Backend::Block);
+    FAST_CHECK_EQ(solver2.structure().gType, GType::TriBlockDiagonal);
+  }
+}
+
+TEST_CASE("Arrows")
+{
+  std::vector<int> leaves = {15, 12, 15, 14, 15};
+  const int t = 5;
+  const int n = std::accumulate(leaves.begin(), leaves.end(), 0) + t;
+  for(bool down : {false, true})
+  {
+    std::vector<int> blocks = leaves;
+    if(down)
+      blocks.push_back(t);
+    else
+      blocks.insert(blocks.begin(), t);
+    Mask mask = blockMask(blocks, false);
+    if(down)
+      mask.bottomRows(t).setConstant(true);
+    else
+      mask.leftCols(t).setConstant(true);
+    auto cstr = blockConstraints(blocks, 3, false);
+
+    AutoSolver solver;
+    auto pb = randomProblem(mask, cstr, true);
+    compare(solver, pb);
+    FAST_CHECK_EQ(solver.structure().backend, AutoSolver::Backend::Block);
+    FAST_CHECK_EQ(solver.structure().gType, down ? GType::BlockArrowDown : GType::BlockArrowUp);
+    FAST_CHECK_UNARY(solver.structure().blocks == blocks);
+    FAST_CHECK_EQ(n, static_cast<int>(pb.G.rows()));
+  }
+}
+
+TEST_CASE("Banded and diagonal")
+{
+  const int n = 100;
+  for(int k : {0, 2})
+  {
+    Mask mask = Mask::Constant(n, n, false);
+    for(int j = 0; j < n; ++j)
+      for(int i = j; i <= std::min(j + k, n - 1); ++i) mask(i, j) = true;
+    std::vector<std::pair<int, int>> cstr;
+    for(int i = 0; i + 3 <= n; i += 3) cstr.emplace_back(i, i + 3);
+
+    AutoSolver solver;
+    auto pb = randomProblem(mask, cstr, true);
+    compare(solver, pb);
+    FAST_CHECK_EQ(solver.structure().backend, AutoSolver::Backend::Block);
+    FAST_CHECK_EQ(solver.structure().gType, GType::Banded);
+    FAST_CHECK_EQ(solver.structure().bandwidth, k);
+  }
+
+  // Diagonal G with a single one-sided constraint
+  for(bool lower : {false, true})
+  {
+    Mask mask = Mask::Identity(n, n);
+    AutoSolver solver;
+    auto pb = randomProblem(mask, {{0, n}}, true);
+    if(lower)
+      pb.u[0] = std::numeric_limits<double>::infinity();
+    else
+      pb.l[0] = -std::numeric_limits<double>::infinity();
+    // Make the constraint active
+    pb.a = -pb.G * (lower ? pb.xl : pb.xu);
+    compare(solver, pb);
+    FAST_CHECK_EQ(solver.structure().backend, AutoSolver::Backend::BoxAndSingleConstraint);
+  }
+}
+
+TEST_CASE("Dense and cache")
+{
+  const int n = 20;
+  AutoSolver solver;
+  std::vector<std::pair<int, int>> cstr(8, {0, n});
+  auto pb = randomProblem(Mask::Constant(n, n, true), cstr, true);
+  compare(solver, pb);
+  FAST_CHECK_EQ(solver.structure().backend, AutoSolver::Backend::Dense);
+  FAST_CHECK_EQ(solver.nbAnalyses(), 1);
+
+  // Same pattern: no new analysis
+  std::vector<int> blocks = {15, 12, 15, 14, 15, 16};
+  AutoSolver solver2;
+  auto pb1 = randomProblem(blockMask(blocks, false), blockConstraints(blocks, 4, false), true);
+  compare(solver2, pb1);
+  auto pb2 = pb1;
+  pb2.G = randomG(blockMask(blocks, false));
+  pb2.a.setRandom();
+  compare(solver2, pb2);
+  FAST_CHECK_EQ(solver2.nbAnalyses(), 1);
+
+  // Sparser pattern: no new analysis
+  pb2.G.block(5, 0, 10, 5).setZero();
+  pb2.G.block(0, 5, 5, 10).setZero();
+  pb2.C.col(0).setZero();
+  pb2.l[0] = -1;
+  pb2.u[0] = 1;
+  compare(solver2, pb2);
+  FAST_CHECK_EQ(solver2.nbAnalyses(), 1);
+
+  // Coupling between blocks: new analysis
+  pb2.G(20, 5) = pb2.G(5, 20) = 0.1;
+  compare(solver2, pb2);
+  FAST_CHECK_EQ(solver2.nbAnalyses(), 2);
+
+  // Different order of the constraints: new analysis
+  AutoSolver solver3;
+  compare(solver3, pb1);
+  auto pb3 = randomProblem(blockMask(blocks, false), blockConstraints(blocks, 4, false), true);
+  compare(solver3, pb3);
+  FAST_CHECK_EQ(solver3.nbAnalyses(), 2);
+
+  // Sparse input
+  SparseMatrix<double> Gs = pb1.G.sparseView();
+  SparseMatrix<double> Cs = pb1.C.sparseView();
+  AutoSolver solver4;
+  auto ret = solver4.solve(Gs, pb1.a, Cs, pb1.l, pb1.u, pb1.xl, pb1.xu);
+  FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+  FAST_CHECK_EQ(solver4.structure().gType, GType::BlockDiagonal);
+  solver2.solve(pb1.G, pb1.a, pb1.C, pb1.l, pb1.u, pb1.xl, pb1.xu);
+  FAST_CHECK_UNARY(solver4.solution().isApprox(solver2.solution(), 1e-8));
+}
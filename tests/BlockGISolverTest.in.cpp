@@ -8,6 +8,7 @@
 
 #include <jrl-qp/GoldfarbIdnaniSolver.h>
 #include <jrl-qp/experimental/BlockGISolver.h>
+#include <jrl-qp/experimental/DiagonalHessianSolver.h>
 #include <jrl-qp/test/randomMatrices.h>
 #include <jrl-qp/test/randomProblems.h>
 
@@ -118,6 +119,309 @@ TEST_CASE("Small problem tridiag obj, ineq only")
   FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
 }
 
+TEST_CASE("Small problem tridiag obj, coupled constraints")
+{
+  // Constraints of block j act on x_j and x_{j+1} (and x_{j+2} in the banded case), as
+  // for the dynamics of a MPC problem.
+  std::vector n = {3, 5, 2, 3};
+  std::vector mi = {3, 3, 3, 3};
+  MatrixXd A = biBlockDiagRandom(n);
+  MatrixXd GDense = A * A.transpose() + MatrixXd::Identity(13, 13);
+  MatrixXd G0 = GDense;
+  std::vector<MatrixRef> D = {GDense.block(0, 0, 3, 3), GDense.block(3, 3, 5, 5), GDense.block(8, 8, 2, 2),
+                              GDense.block(10, 10, 3, 3)};
+  std::vector<MatrixRef> S = {GDense.block(3, 0, 5, 3), GDense.block(8, 3, 2, 5), GDense.block(10, 8, 3, 2)};
+  StructuredG G(StructuredG::Type::TriBlockDiagonal, D, S);
+
+  VectorXd a = 10 * VectorXd::Random(13);
+  VectorXd l = -VectorXd::Random(12).cwiseAbs() - VectorXd::Constant(12, 0.1);
+  VectorXd u = VectorXd::Random(12).cwiseAbs() + VectorXd::Constant(12, 0.1);
+  VectorXd xl = VectorXd::Constant(13, -2);
+  VectorXd xu = VectorXd::Constant(13, 2);
+
+  for(int bw : {1, 2})
+  {
+    MatrixXd C0 = MatrixXd::Zero(13, 12);
+    std::vector<MatrixConstRef> Cs;
+    std::vector<std::vector<MatrixConstRef>> Sub(static_cast<size_t>(bw));
+    std::vector<int> r = {0, 3, 8, 10, 13};
+    for(int i = 0; i < 4; ++i)
+    {
+      C0.block(r[i], 3 * i, n[i], mi[i]).setRandom();
+      Cs.push_back(C0.block(r[i], 3 * i, n[i], mi[i]));
+      for(int k = 1; k <= bw && i + k < 4; ++k)
+      {
+        C0.block(r[i + k], 3 * i, n[i + k], mi[i]).setRandom();
+        Sub[k - 1].push_back(C0.block(r[i + k], 3 * i, n[i + k], mi[i]));
+      }
+    }
+    StructuredC C = bw == 1 ? StructuredC(StructuredC::Type::BlockBidiagonal, Cs, Sub[0]) : StructuredC(Cs, Sub);
+
+    for(bool useBounds : {false, true})
+    {
+      VectorXd xl0 = useBounds ? xl : VectorXd(0);
+      VectorXd xu0 = useBounds ? xu : VectorXd(0);
+      GoldfarbIdnaniSolver solverD(13, 12, useBounds);
+      MatrixXd Gd = G0;
+      auto retD = solverD.solve(Gd, a, C0, l, u, xl0, xu0);
+
+      GDense = G0;
+      BlockGISolver solverB(13, 12, useBounds);
+      auto retB = solverB.solve(G, a, C, l, u, xl0, xu0);
+
+      FAST_CHECK_EQ(retD, TerminationStatus::SUCCESS);
+      FAST_CHECK_EQ(retB, retD);
+      FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+    }
+  }
+}
+
+TEST_CASE("Small problem tridiag obj, warm start and equalities")
+{
+  std::vector n = {3, 5, 2, 3};
+  std::vector mi = {3, 3, 3, 3};
+  MatrixXd A = biBlockDiagRandom(n);
+  MatrixXd GDense = A * A.transpose() + MatrixXd::Identity(13, 13);
+  MatrixXd G0 = GDense;
+  std::vector<MatrixRef> D = {GDense.block(0, 0, 3, 3), GDense.block(3, 3, 5, 5), GDense.block(8, 8, 2, 2),
+                              GDense.block(10, 10, 3, 3)};
+  std::vector<MatrixRef> S = {GDense.block(3, 0, 5, 3), GDense.block(8, 3, 2, 5), GDense.block(10, 8, 3, 2)};
+  StructuredG G(StructuredG::Type::TriBlockDiagonal, D, S);
+
+  MatrixXd C0 = MatrixXd::Zero(13, 12);
+  std::vector<MatrixConstRef> Cs;
+  std::vector<MatrixConstRef> Sub;
+  std::vector<int> r = {0, 3, 8, 10, 13};
+  for(int i = 0; i < 4; ++i)
+  {
+    C0.block(r[i], 3 * i, n[i], mi[i]).setRandom();
+    Cs.push_back(C0.block(r[i], 3 * i, n[i], mi[i]));
+    if(i < 3)
+    {
+      C0.block(r[i + 1], 3 * i, n[i + 1], mi[i]).setRandom();
+      Sub.push_back(C0.block(r[i + 1], 3 * i, n[i + 1], mi[i]));
+    }
+  }
+  StructuredC C(StructuredC::Type::BlockBidiagonal, Cs, Sub);
+
+  VectorXd a = 10 * VectorXd::Random(13);
+  VectorXd l = -VectorXd::Random(12).cwiseAbs() - VectorXd::Constant(12, 0.1);
+  VectorXd u = VectorXd::Random(12).cwiseAbs() + VectorXd::Constant(12, 0.1);
+  // Some equality constraints and a fixed variable
+  l[1] = u[1] = 0.2;
+  l[7] = u[7] = -0.1;
+  VectorXd xl = VectorXd::Constant(13, -2);
+  VectorXd xu = VectorXd::Constant(13, 2);
+  xl[4] = xu[4] = 0.5;
+
+  GoldfarbIdnaniSolver solverD(13, 12, true);
+  MatrixXd Gd = G0;
+  auto retD = solverD.solve(Gd, a, C0, l, u, xl, xu);
+  FAST_CHECK_EQ(retD, TerminationStatus::SUCCESS);
+
+  BlockGISolver solverB(13, 12, true);
+  GDense = G0;
+  auto retB = solverB.solve(G, a, C, l, u, xl, xu);
+  FAST_CHECK_EQ(retB, retD);
+  FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+
+  // Warm start with the optimal active set: no iteration needed
+  SolverOptions opt;
+  opt.warmStart(true);
+  solverB.options(opt);
+  std::vector<ActivationStatus> as = solverB.activeSet();
+  GDense = G0;
+  retB = solverB.solve(G, a, C, l, u, xl, xu, as);
+  FAST_CHECK_EQ(retB, TerminationStatus::SUCCESS);
+  FAST_CHECK_EQ(solverB.iterations(), 0);
+  FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+
+  // Warm start on a perturbed problem, compared to a cold start of the dense solver
+  VectorXd a2 = a + VectorXd::Random(13);
+  Gd = G0;
+  retD = solverD.solve(Gd, a2, C0, l, u, xl, xu);
+  GDense = G0;
+  retB = solverB.solve(G, a2, C, l, u, xl, xu, as);
+  FAST_CHECK_EQ(retB, retD);
+  FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+
+  // Warm start with an active set containing constraints with negative multipliers
+  std::vector<ActivationStatus> as2(25, ActivationStatus::INACTIVE);
+  for(int i : {0, 3, 5, 9}) as2[i] = ActivationStatus::LOWER;
+  for(int i : {2, 10}) as2[i] = ActivationStatus::UPPER;
+  as2[12 + 0] = ActivationStatus::UPPER_BOUND;
+  as2[12 + 8] = ActivationStatus::LOWER_BOUND;
+  GDense = G0;
+  retB = solverB.solve(G, a2, C, l, u, xl, xu, as2);
+  FAST_CHECK_EQ(retB, retD);
+  FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+
+  // Warm start with the equality status of a constraint that is not an equality anymore.
+  // One of its bounds is kept. For one of the two choices, the multiplier of the
+  // constraint has the wrong sign, and the constraint must not be kept active.
+  for(bool keepLower : {true, false})
+  {
+    VectorXd l2 = l;
+    VectorXd u2 = u;
+    if(keepLower)
+      u2[1] = 5;
+    else
+      l2[1] = -5;
+    Gd = G0;
+    retD = solverD.solve(Gd, a, C0, l2, u2, xl, xu);
+    GDense = G0;
+    retB = solverB.solve(G, a, C, l2, u2, xl, xu, as);
+    FAST_CHECK_EQ(retB, retD);
+    FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+  }
+}
+
+TEST_CASE("Small problem tridiag obj, linearly dependent warm start")
+{
+  std::vector n = {3, 5, 2, 3};
+  std::vector mi = {3, 3, 3, 3};
+  MatrixXd A = biBlockDiagRandom(n);
+  MatrixXd GDense = A * A.transpose() + MatrixXd::Identity(13, 13);
+  MatrixXd G0 = GDense;
+  std::vector<MatrixRef> D = {GDense.block(0, 0, 3, 3), GDense.block(3, 3, 5, 5), GDense.block(8, 8, 2, 2),
+                              GDense.block(10, 10, 3, 3)};
+  std::vector<MatrixRef> S = {GDense.block(3, 0, 5, 3), GDense.block(8, 3, 2, 5), GDense.block(10, 8, 3, 2)};
+  StructuredG G(StructuredG::Type::TriBlockDiagonal, D, S);
+
+  MatrixXd C0 = MatrixXd::Zero(13, 12);
+  std::vector<MatrixConstRef> Cs;
+  std::vector<MatrixConstRef> Sub;
+  std::vector<int> r = {0, 3, 8, 10, 13};
+  for(int i = 0; i < 4; ++i)
+  {
+    C0.block(r[i], 3 * i, n[i], mi[i]).setRandom();
+    Cs.push_back(C0.block(r[i], 3 * i, n[i], mi[i]));
+    if(i < 3)
+    {
+      C0.block(r[i + 1], 3 * i, n[i + 1], mi[i]).setRandom();
+      Sub.push_back(C0.block(r[i + 1], 3 * i, n[i + 1], mi[i]));
+    }
+  }
+  // Constraint 5 is a combination of constraints 3 and 4.
+  C0.col(5) = C0.col(3) - 2 * C0.col(4);
+  StructuredC C(StructuredC::Type::BlockBidiagonal, Cs, Sub);
+
+  VectorXd a = 10 * VectorXd::Random(13);
+  VectorXd l = -VectorXd::Random(12).cwiseAbs() - VectorXd::Constant(12, 0.1);
+  VectorXd u = VectorXd::Random(12).cwiseAbs() + VectorXd::Constant(12, 0.1);
+  VectorXd xl = VectorXd::Constant(13, -2);
+  VectorXd xu = VectorXd::Constant(13, 2);
+
+  GoldfarbIdnaniSolver solverD(13, 12, true);
+  MatrixXd Gd = G0;
+  auto retD = solverD.solve(Gd, a, C0, l, u, xl, xu);
+  FAST_CHECK_EQ(retD, TerminationStatus::SUCCESS);
+
+  // The dependent inequality constraint is dropped from the warm-start active set.
+  BlockGISolver solverB(13, 12, true);
+  SolverOptions opt;
+  opt.warmStart(true);
+  solverB.options(opt);
+  std::vector<ActivationStatus> as(25, ActivationStatus::INACTIVE);
+  for(int i : {3, 4, 5}) as[i] = ActivationStatus::LOWER;
+  GDense = G0;
+  auto retB = solverB.solve(G, a, C, l, u, xl, xu, as);
+  FAST_CHECK_EQ(retB, retD);
+  FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+
+  // Dependent equality constraints cannot be dropped.
+  l[3] = u[3] = 0.1;
+  l[4] = u[4] = 0.2;
+  l[5] = u[5] = -0.3;
+  GDense = G0;
+  retB = solverB.solve(G, a, C, l, u, xl, xu, as);
+  FAST_CHECK_EQ(retB, TerminationStatus::LINEAR_DEPENDENCY_DETECTED);
+}
+
+TEST_CASE("Receding horizon shift")
+{
+  // Stages of n variables and m constraints acting on the variables of the stage and
+  // of the next one, with the same matrices for all stages. The problem at tick t
+  // uses the stages t to t+T-1 of longer trajectories for the linear term and bounds.
+  const int n = 4;
+  const int m = 3;
+  const int T = 10;
+  const int ticks = 6;
+  const int nv = n * T;
+  const int nc = m * T;
+
+  MatrixXd Rd = MatrixXd::Random(n, n);
+  MatrixXd Rs = MatrixXd::Random(n, n);
+  MatrixXd R = MatrixXd::Zero(nv, nv);
+  for(int i = 0; i < T; ++i)
+  {
+    R.block(i * n, i * n, n, n) = Rd;
+    if(i > 0) R.block(i * n, (i - 1) * n, n, n) = Rs;
+  }
+  MatrixXd G0 = R * R.transpose() + MatrixXd::Identity(nv, nv);
+  MatrixXd GDense = G0;
+  std::vector<MatrixRef> D, S;
+  for(int i = 0; i < T; ++i)
+  {
+    D.push_back(GDense.block(i * n, i * n, n, n));
+    if(i > 0) S.push_back(GDense.block(i * n, (i - 1) * n, n, n));
+  }
+  StructuredG G(StructuredG::Type::TriBlockDiagonal, D, S);
+
+  MatrixXd Cd = MatrixXd::Random(n, m);
+  MatrixXd Cs = MatrixXd::Random(n, m);
+  MatrixXd C0 = MatrixXd::Zero(nv, nc);
+  std::vector<MatrixConstRef> Cdiag, Csub;
+  for(int i = 0; i < T; ++i)
+  {
+    C0.block(i * n, i * m, n, m) = Cd;
+    Cdiag.push_back(C0.block(i * n, i * m, n, m));
+    if(i < T - 1)
+    {
+      C0.block((i + 1) * n, i * m, n, m) = Cs;
+      Csub.push_back(C0.block((i + 1) * n, i * m, n, m));
+    }
+  }
+  StructuredC C(StructuredC::Type::BlockBidiagonal, Cdiag, Csub);
+
+  VectorXd aTraj = 10 * VectorXd::Random(n * (T + ticks));
+  VectorXd lTraj = -VectorXd::Random(m * (T + ticks)).cwiseAbs() - VectorXd::Constant(m * (T + ticks), 0.1);
+  VectorXd uTraj = VectorXd::Random(m * (T + ticks)).cwiseAbs() + VectorXd::Constant(m * (T + ticks), 0.1);
+  VectorXd xl = VectorXd::Constant(nv, -1);
+  VectorXd xu = VectorXd::Constant(nv, 1);
+
+  GoldfarbIdnaniSolver solverD(nv, nc, true);
+  BlockGISolver solverB(nv, nc, true);
+  SolverOptions opt;
+  opt.warmStart(true);
+  solverB.options(opt);
+
+  int itCold = 0;
+  int itWarm = 0;
+  for(int t = 0; t < ticks; ++t)
+  {
+    VectorXd a = aTraj.segment(t * n, nv);
+    VectorXd l = lTraj.segment(t * m, nc);
+    VectorXd u = uTraj.segment(t * m, nc);
+
+    MatrixXd Gd = G0;
+    auto retD = solverD.solve(Gd, a, C0, l, u, xl, xu);
+    FAST_CHECK_EQ(retD, TerminationStatus::SUCCESS);
+
+    if(t > 0) solverB.shift(1);
+    GDense = G0;
+    auto retB = solverB.solve(G, a, C, l, u, xl, xu);
+    FAST_CHECK_EQ(retB, retD);
+    FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+    if(t > 0)
+    {
+      itCold += solverD.iterations();
+      itWarm += solverB.iterations();
+    }
+  }
+  FAST_CHECK_LT(itWarm, itCold);
+}
+
 TEST_CASE("Small problem arrow up obj, ineq only")
 {
   std::vector n = {3, 5, 2, 3};
@@ -169,6 +473,137 @@ TEST_CASE("Small problem arrow up obj, ineq only")
   FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
 }
 
+TEST_CASE("Block updates of the obj between solves")
+{
+  std::vector n = {3, 5, 2, 3};
+  std::vector mi = {3, 3, 3, 3};
+  MatrixXd A = blockDiagAndOneColDiagRandom(n, true);
+  MatrixXd G0 = A.transpose() * A;
+  MatrixXd GDense = G0;
+  std::vector<MatrixRef> D = {GDense.block(0, 0, 3, 3), GDense.block(3, 3, 5, 5), GDense.block(8, 8, 2, 2),
+                              GDense.block(10, 10, 3, 3)};
+  std::vector<MatrixRef> S = {GDense.block(3, 0, 5, 3), GDense.block(8, 0, 2, 3), GDense.block(10, 0, 3, 3)};
+  StructuredG G(StructuredG::Type::BlockArrowUp, D, S);
+  G.keepOriginal(true);
+  REQUIRE(G.lltInPlace());
+
+  VectorXd a = VectorXd::Random(13);
+  MatrixXd C0 = MatrixXd::Zero(13, 12);
+  std::vector<MatrixConstRef> Cs;
+  VectorXd l(12), u(12);
+  VectorXd xl(0), xu(0);
+  int r = 0;
+  int c = 0;
+  for(int i = 0; i < 4; ++i)
+  {
+    auto pb = randomProblem(ProblemCharacteristics(n[i], 0, 0, mi[i]).doubleSidedIneq(true));
+    C0.block(r, c, n[i], mi[i]) = pb.C.transpose();
+    Cs.push_back(C0.block(r, c, n[i], mi[i]));
+    l.segment(c, mi[i]) = pb.l;
+    u.segment(c, mi[i]) = pb.u;
+    r += n[i];
+    c += mi[i];
+  }
+  StructuredC C(Cs);
+
+  GoldfarbIdnaniSolver solverD(13, 12, false);
+  BlockGISolver solverB(13, 12, false);
+  solverB.reuseDecomposition(true);
+  for(int k = 0; k < 3; ++k)
+  {
+    MatrixXd G1 = G0;
+    auto retD = solverD.solve(G1, a, C0, l, u, xl, xu);
+    auto retB = solverB.solve(G, a, C, l, u, xl, xu);
+    FAST_CHECK_EQ(retB, retD);
+    FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+
+    // Change the block row 2 of A, which changes the diagonal blocks 0 and 2 and the
+    // off-diagonal block 1 of G.
+    A.block(8, 0, 2, 3).setRandom();
+    A.block(8, 8, 2, 2).setRandom();
+    G0 = A.transpose() * A;
+    G.updateDiag(0, G0.block(0, 0, 3, 3));
+    G.updateDiag(2, G0.block(8, 8, 2, 2));
+    G.updateOffDiag(1, G0.block(8, 0, 2, 3));
+    REQUIRE(G.refactorize());
+  }
+
+  // New values written directly into the blocks
+  A.block(3, 3, 5, 5).setRandom();
+  G0 = A.transpose() * A;
+  GDense = G0;
+  G.invalidateDecomposition();
+  MatrixXd G1 = G0;
+  auto retD = solverD.solve(G1, a, C0, l, u, xl, xu);
+  auto retB = solverB.solve(G, a, C, l, u, xl, xu);
+  FAST_CHECK_EQ(retB, retD);
+  FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+}
+
+TEST_CASE("Diagonal plus low-rank obj")
+{
+  const int n = 200;
+  const int k = 10;
+  const int m = 30;
+  MatrixXd d = MatrixXd::Random(1, n).array() + 1.5;
+  MatrixXd U = MatrixXd::Random(n, k);
+  MatrixXd G0 = MatrixXd(d.row(0).asDiagonal()) + U * U.transpose();
+  StructuredG G(d, U);
+
+  VectorXd a = 10 * VectorXd::Random(n);
+  MatrixXd C0 = MatrixXd::Random(n, m);
+  StructuredC C({C0});
+  VectorXd l = VectorXd::Constant(m, -1);
+  VectorXd u = VectorXd::Constant(m, 1);
+  l[0] = u[0] = 0.5;
+  VectorXd xl = VectorXd::Constant(n, -1);
+  VectorXd xu = VectorXd::Constant(n, 1);
+
+  GoldfarbIdnaniSolver solverD(n, m, true);
+  auto retD = solverD.solve(G0, a, C0, l, u, xl, xu);
+
+  BlockGISolver solverB(n, m, true);
+  auto retB = solverB.solve(G, a, C, l, u, xl, xu);
+
+  FAST_CHECK_EQ(retD, TerminationStatus::SUCCESS);
+  FAST_CHECK_EQ(retB, retD);
+  FAST_CHECK_UNARY(solverB.solution().isApprox(solverD.solution(), 1e-8));
+}
+
+TEST_CASE("Diagonal obj")
+{
+  const int n = 200;
+  const int m = 30;
+  VectorXd g = VectorXd::Random(n).array() + 1.5;
+  MatrixXd G0 = g.asDiagonal();
+  VectorXd a = 10 * VectorXd::Random(n);
+  MatrixXd C = MatrixXd::Random(n, m);
+  VectorXd l = VectorXd::Constant(m, -1);
+  VectorXd u = VectorXd::Constant(m, 1);
+  l[0] = u[0] = 0.5;
+  VectorXd xl = VectorXd::Constant(n, -1);
+  VectorXd xu = VectorXd::Constant(n, 1);
+  const VectorXd g0 = g;
+
+  GoldfarbIdnaniSolver solverD(n, m, true);
+  DiagonalHessianSolver solver(n, m, true);
+  for(int i = 0; i < 3; ++i)
+  {
+    MatrixXd G = G0;
+    auto retD = solverD.solve(G, a, C, l, u, xl, xu);
+    auto ret = solver.solve(g, a, C, l, u, xl, xu);
+
+    FAST_CHECK_EQ(retD, TerminationStatus::SUCCESS);
+    FAST_CHECK_EQ(ret, retD);
+    FAST_CHECK_UNARY(solver.solution().isApprox(solverD.solution(), 1e-8));
+    FAST_CHECK_UNARY(g == g0);
+
+    // Same storage for C, new values
+    C.col(i).setRandom();
+    a.setRandom();
+  }
+}
+
 TEST_CASE("Sequential IK")
 {
   const std::string dir = "@CMAKE_CURRENT_BINARY_DIR@";
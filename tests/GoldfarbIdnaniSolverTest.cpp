@@ -1,5 +1,6 @@
 /* Copyright 2020 CNRS-AIST JRL */
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <vector>
@@ -11,6 +12,7 @@
 #include "QPSProblems.h"
 #include "QPSReader.h"
 #include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/GoldfarbIdnaniModel.h>
 #include <jrl-qp/experimental/GoldfarbIdnaniSolver.h>
 #include <jrl-qp/internal/memoryChecks.h>
 #include <jrl-qp/test/kkt.h>
@@ -218,6 +220,110 @@ TEST_CASE("Warm-start")
   FAST_REQUIRE_LT(n_failed, n_allowed_to_fail);
 }
 
+TEST_CASE("GoldfarbIdnaniModel")
+{
+  const int n = 8;
+  const int m = 10;
+  for(int k = 0; k < 10; ++k)
+  {
+    MatrixXd A = MatrixXd::Random(n, n);
+    MatrixXd G = A * A.transpose() + MatrixXd::Identity(n, n);
+    VectorXd a = 10 * VectorXd::Random(n);
+    MatrixXd C = MatrixXd::Random(n, m);
+    VectorXd l = VectorXd::Constant(m, -1);
+    VectorXd u = VectorXd::Constant(m, 1);
+    l[0] = u[0] = 0.2;
+    l[1] = u[1] = -0.3;
+    VectorXd xl = VectorXd::Constant(n, -2);
+    VectorXd xu = VectorXd::Constant(n, 2);
+
+    experimental::GoldfarbIdnaniModel model;
+    model.setProblem(G, a, C, l, u, xl, xu);
+
+    // Compare the model with a cold-started solver on the current data.
+    experimental::GoldfarbIdnaniSolver ref(n, m, true);
+    auto check = [&]()
+    {
+      MatrixXd Gr = G;
+      FAST_REQUIRE_EQ(ref.solve(Gr, a, C, l, u, xl, xu), TerminationStatus::SUCCESS);
+      FAST_REQUIRE_EQ(model.solve(), TerminationStatus::SUCCESS);
+      FAST_CHECK_UNARY(model.solution().isApprox(ref.solution(), 1e-6));
+      FAST_CHECK_UNARY(test::testKKT(model.solution(), model.multipliers(), G, a, C, l, u, xl, xu, true));
+    };
+
+    check();
+
+    // Small change of the linear term: the previous active set is still optimal.
+    a += 1e-6 * VectorXd::Random(n);
+    model.updateLinearTerm(a);
+    check();
+    FAST_CHECK_EQ(model.iterations(), 0);
+
+    // Changes of the bounds, keeping the same equality constraints.
+    l.tail(m - 2).array() -= 0.1;
+    u.tail(m - 2).array() += 0.2;
+    model.updateBounds(l, u);
+    check();
+    xl.array() -= 0.2;
+    model.updateVarBounds(xl, xu);
+    check();
+
+    // Changes of active and inactive columns of C.
+    std::vector<int> idx = {0};
+    const auto & as = model.activeSet();
+    auto isActive = [](ActivationStatus s) { return s != ActivationStatus::INACTIVE; };
+    auto active = std::find_if(as.begin() + 2, as.begin() + m, isActive);
+    auto inactive = std::find_if_not(as.begin() + 2, as.begin() + m, isActive);
+    if(active != as.begin() + m) idx.push_back(static_cast<int>(active - as.begin()));
+    if(inactive != as.begin() + m) idx.push_back(static_cast<int>(inactive - as.begin()));
+    MatrixXd cols(n, static_cast<int>(idx.size()));
+    for(size_t j = 0; j < idx.size(); ++j)
+    {
+      C.col(idx[j]) += 0.01 * VectorXd::Random(n);
+      cols.col(static_cast<int>(j)) = C.col(idx[j]);
+    }
+    model.updateConstraintColumns(idx, cols);
+    check();
+
+    // Same with a full refactorization of the active set.
+    model.maxColumnUpdates(0);
+    for(size_t j = 0; j < idx.size(); ++j)
+    {
+      C.col(idx[j]) += 0.01 * VectorXd::Random(n);
+      cols.col(static_cast<int>(j)) = C.col(idx[j]);
+    }
+    model.updateConstraintColumns(idx, cols);
+    check();
+    model.maxColumnUpdates(-1);
+
+    // Low-rank modifications of G, keeping it positive definite.
+    MatrixXd U = MatrixXd::Random(n, 2);
+    Vector2d s(0.5, -0.1);
+    G += U * s.asDiagonal() * U.transpose();
+    model.updateHessian(U, s);
+    check();
+
+    // G not positive definite anymore, then back to positive definite.
+    VectorXd s1 = VectorXd::Constant(1, -100);
+    model.updateHessian(U.leftCols(1), s1);
+    FAST_CHECK_EQ(model.solve(), TerminationStatus::NON_POS_HESSIAN);
+    s1[0] = 100;
+    model.updateHessian(U.leftCols(1), s1);
+    check();
+
+    // Change of the equality constraints, requiring to rebuild the factorization of the
+    // active set.
+    l[0] -= 1;
+    model.updateBounds(l, u);
+    check();
+
+    // A new problem
+    a.setRandom();
+    model.setProblem(G, a, C, l, u, xl, xu);
+    check();
+  }
+}
+
 #ifdef QPS_TESTS_DIR
 template<typename Solver>
 struct ExcludePb
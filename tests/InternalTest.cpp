@@ -5,9 +5,11 @@
 #include "doctest/doctest.h"
 
 #include <jrl-qp/internal/OrthonormalSequence.h>
+#include <jrl-qp/internal/blockKernels.h>
 #include <jrl-qp/internal/SingleNZSegmentVector.h>
 #include <jrl-qp/internal/Workspace.h>
 
+#include <Eigen/Cholesky>
 #include <Eigen/LU>
 
 using namespace Eigen;
@@ -97,6 +99,26 @@ TEST_CASE("ElemOrthonormalSequence Householder")
         }
       }
     }
+
+    // Apply to vectors whose non-zero part is exactly the window, anywhere in the vector
+    {
+      MatrixXd Q = H.toDense();
+      for(int start = 0; start < 8; ++start)
+      {
+        for(int size = 1; start + size <= 8; ++size)
+        {
+          VectorXd v = VectorXd::Zero(8);
+          v.segment(start, size).setRandom();
+          VectorXd u = v;
+          H.applyToTheLeft(u, start, size);
+          FAST_CHECK_UNARY(u.isApprox(Q * v, 1e-8));
+
+          u = v;
+          H.applyTransposeToTheLeft(u, start, size);
+          FAST_CHECK_UNARY(u.isApprox(Q.transpose() * v, 1e-8));
+        }
+      }
+    }
   }
 
   // Single householder transform
@@ -221,6 +243,32 @@ TEST_CASE("ElemOrthonormalSequence Givens")
   }
 }
 
+TEST_CASE("ElemOrthonormalSequence Permutation")
+{
+  ElemOrthonormalSequence H(OSeqType::Permutation, 6, 4);
+  H.add(0, 1);
+  H.add(1, 2);
+  H.add(4, 2);
+  H.add(5, 0);
+
+  // Permutation matrix (swaps are applied on the left, the last one first)
+  MatrixXd P = MatrixXd::Identity(6, 6);
+  P.row(5).swap(P.row(0));
+  P.row(4).swap(P.row(2));
+  P.row(1).swap(P.row(2));
+  P.row(0).swap(P.row(1));
+
+  VectorXd u = VectorXd::Random(6);
+  VectorXd v = u;
+  H.applyToTheLeft(u, 0, 6);
+  FAST_CHECK_UNARY(u.isApprox(P * v, 1e-15));
+  FAST_CHECK_UNARY(H.toDense().isApprox(P, 1e-15));
+
+  u = v;
+  H.applyTransposeToTheLeft(u, 0, 6);
+  FAST_CHECK_UNARY(u.isApprox(P.transpose() * v, 1e-15));
+}
+
 TEST_CASE("OrthonormalSequence")
 {
   OrthonormalSequence H(16);
@@ -320,4 +368,191 @@ TEST_CASE("OrthonormalSequence")
       FAST_CHECK_EQ(w.norm(), doctest::Approx(v.norm()));
     }
   }
+
+  // Test on vectors with a zero head, as for the product with the second part of a
+  // partitionned Q
+  {
+    for(int m1 = 0; m1 <= 16; ++m1)
+    {
+      VectorXd v = VectorXd::Zero(16);
+      v.tail(16 - m1).setRandom();
+      VectorXd w = v;
+      H.applyToTheLeft(w, m1, 16 - m1);
+      FAST_CHECK_UNARY(w.isApprox(Q * v, 1e-8));
+
+      w = v;
+      H.applyTransposeToTheLeft(w, m1, 16 - m1);
+      FAST_CHECK_UNARY(w.isApprox(Q.transpose() * v, 1e-8));
+    }
+  }
+}
+
+TEST_CASE("OrthonormalSequence reuse")
+{
+  // The arena is not preallocated, so that it needs to grow (and move) while adding
+  // elements. After clear(), the memory is reused.
+  const int n = 10;
+  OrthonormalSequence H(n);
+  for(int round = 0; round < 3; ++round)
+  {
+    H.clear();
+    MatrixXd Q = MatrixXd::Identity(n, n);
+    for(int k = 0; k < 5 + 5 * round; ++k)
+    {
+      int start = k % 4;
+      int m = n - start - k % 3;
+      if(k % 3 == 2)
+      {
+        H.prepare(OSeqType::Permutation, m, m - 1);
+        ElemOrthonormalSequence Hk(OSeqType::Permutation, m, m - 1);
+        for(int i = 0; i < m - 1; ++i)
+        {
+          int j = (i + 3) % m;
+          H.add(start, i, j);
+          Hk.add(i, j);
+        }
+        Q.middleCols(start, m) *= Hk.toDense();
+      }
+      else if(k % 2 == 0)
+      {
+        VectorXd v = VectorXd::Random(m);
+        double tau, beta;
+        v.makeHouseholderInPlace(tau, beta);
+        H.prepare(OSeqType::Householder, m, 1);
+        H.add(start, v.tail(m - 1), tau);
+        ElemOrthonormalSequence Hk(OSeqType::Householder, m, 1);
+        Hk.add(v.tail(m - 1), tau);
+        Q.middleCols(start, m) *= Hk.toDense();
+      }
+      else
+      {
+        H.prepare(OSeqType::Givens, m, m - 1);
+        ElemOrthonormalSequence Hk(OSeqType::Givens, m, m - 1);
+        for(int i = 0; i < m - 1; ++i)
+        {
+          Givens G;
+          G.makeGivens(Eigen::internal::random<double>(), Eigen::internal::random<double>());
+          H.add(start + i, G);
+          Hk.add(G);
+        }
+        Q.middleCols(start, m) *= Hk.toDense();
+      }
+    }
+
+    VectorXd u = VectorXd::Random(n);
+    VectorXd v = u;
+    H.applyToTheLeft(u);
+    FAST_CHECK_UNARY(u.isApprox(Q * v, 1e-8));
+    u = v;
+    H.applyTransposeToTheLeft(u);
+    FAST_CHECK_UNARY(u.isApprox(Q.transpose() * v, 1e-8));
+  }
+}
+
+TEST_CASE("OrthonormalSequence compaction")
+{
+  // A low compaction ratio triggers several compactions while adding the elements, so
+  // that the result mixes a dense part and a sequence of elements.
+  const int n = 12;
+  OrthonormalSequence H(n);
+  OrthonormalSequence Href(n);
+  H.compactionRatio(0.3);
+  Href.compactionRatio(0);
+  H.reserve(2 * n);
+  MatrixXd Q = MatrixXd::Identity(n, n);
+  for(int k = 0; k < 2 * n; ++k)
+  {
+    int start = k % 5;
+    int m = n - start - k % 4;
+    VectorXd v = VectorXd::Random(m);
+    double tau, beta;
+    v.makeHouseholderInPlace(tau, beta);
+    H.prepare(OSeqType::Householder, m, 1);
+    H.add(start, v.tail(m - 1), tau);
+    Href.prepare(OSeqType::Householder, m, 1);
+    Href.add(start, v.tail(m - 1), tau);
+    ElemOrthonormalSequence Hk(OSeqType::Householder, m, 1);
+    Hk.add(v.tail(m - 1), tau);
+    Q.middleCols(start, m) *= Hk.toDense();
+
+    VectorXd u = VectorXd::Random(n);
+    VectorXd w = u;
+    VectorXd wref = u;
+    H.applyToTheLeft(w);
+    Href.applyToTheLeft(wref);
+    FAST_CHECK_UNARY(w.isApprox(Q * u, 1e-8));
+    FAST_CHECK_UNARY(wref.isApprox(Q * u, 1e-8));
+    w = u;
+    H.applyTransposeToTheLeft(w);
+    FAST_CHECK_UNARY(w.isApprox(Q.transpose() * u, 1e-8));
+  }
+
+  VectorXd r = VectorXd::Random(3);
+  for(int i = 0; i <= n - 3; ++i)
+  {
+    SingleNZSegmentVector u(r, i, n);
+    VectorXd v(n);
+    u.toFullVector(v);
+    VectorXd w(n);
+
+    H.applyToTheLeft(w, u);
+    FAST_CHECK_UNARY(w.isApprox(Q * v, 1e-8));
+
+    H.applyTransposeToTheLeft(w, u);
+    FAST_CHECK_UNARY(w.isApprox(Q.transpose() * v, 1e-8));
+  }
+
+  // Explicit compaction, then no element left
+  H.compact();
+  VectorXd u = VectorXd::Random(n);
+  VectorXd w = u;
+  H.applyToTheLeft(w);
+  FAST_CHECK_UNARY(w.isApprox(Q * u, 1e-8));
+}
+
+TEST_CASE("Block kernels")
+{
+  // Sizes with and without fixed-size kernels
+  for(int n : {5, 6, 12})
+  {
+    for(int m : {6, 7, 12})
+    {
+      MatrixXd A = MatrixXd::Random(n, n);
+      MatrixXd H = A * A.transpose() + MatrixXd::Identity(n, n);
+      MatrixXd L = H.llt().matrixL();
+
+      // Upper part must be left untouched
+      MatrixXd H1 = H;
+      H1.triangularView<StrictlyUpper>().setConstant(42);
+      FAST_CHECK_UNARY(blockLLT(H1));
+      FAST_CHECK_UNARY(H1.triangularView<Lower>().toDenseMatrix().isApprox(L, 1e-10));
+      FAST_CHECK_UNARY((H1.triangularView<StrictlyUpper>().toDenseMatrix().array() == 42).count()
+                       == n * (n - 1) / 2);
+      MatrixXd H2 = -H;
+      FAST_CHECK_UNARY_FALSE(blockLLT(H2));
+
+      MatrixXd X = MatrixXd::Random(m, n);
+      MatrixXd X1 = X;
+      blockSolveLTransposeRight(H1, X1);
+      FAST_CHECK_UNARY((X1 * L.transpose()).isApprox(X, 1e-10));
+
+      MatrixXd Y = MatrixXd::Random(n, m);
+      MatrixXd Y1 = Y;
+      blockSolveLLeft(H1, Y1);
+      FAST_CHECK_UNARY((L * Y1).isApprox(Y, 1e-10));
+
+      MatrixXd D = MatrixXd::Random(m, m);
+      MatrixXd D1 = D;
+      blockRankUpdate(D1, X);
+      MatrixXd D0 = D - X * X.transpose();
+      FAST_CHECK_UNARY(D1.triangularView<Lower>().toDenseMatrix().isApprox(D0.triangularView<Lower>().toDenseMatrix(), 1e-10));
+      FAST_CHECK_UNARY(D1.triangularView<StrictlyUpper>().toDenseMatrix()
+                       == D.triangularView<StrictlyUpper>().toDenseMatrix());
+
+      D1 = D;
+      blockRankUpdateTranspose(D1, Y);
+      D0 = D - Y.transpose() * Y;
+      FAST_CHECK_UNARY(D1.triangularView<Lower>().toDenseMatrix().isApprox(D0.triangularView<Lower>().toDenseMatrix(), 1e-10));
+    }
+  }
 }
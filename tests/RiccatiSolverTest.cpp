@@ -0,0 +1,146 @@
+/* Copyright 2020-2021 CNRS-AIST JRL */
+
+#include <iostream>
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include "doctest/doctest.h"
+
+#include <jrl-qp/GoldfarbIdnaniSolver.h>
+#include <jrl-qp/experimental/RiccatiSolver.h>
+#include <jrl-qp/test/optimalControlProblems.h>
+
+using namespace Eigen;
+using namespace jrl::qp;
+using namespace jrl::qp::test;
+
+namespace
+{
+template<typename T>
+std::vector<MatrixConstRef> toRefs(const std::vector<T> & M)
+{
+  return {M.begin(), M.end()};
+}
+
+void compareWithDense(int nx, int nu, int N, int m, bool useBounds)
+{
+  auto pb = randomOptimalControlProblem(nx, nu, N, m, useBounds);
+  auto qpp = pb.toDense();
+
+  GoldfarbIdnaniSolver solverD(qpp.G.rows(), qpp.C.cols(), useBounds);
+  auto retD = solverD.solve(qpp.G, qpp.a, qpp.C, qpp.l, qpp.u, qpp.xl, qpp.xu);
+  FAST_CHECK_EQ(retD, TerminationStatus::SUCCESS);
+
+  experimental::RiccatiSolver solverR(nx, nu, N, static_cast<int>(pb.bl.size()), useBounds);
+  auto retR = solverR.solve(toRefs(pb.H), pb.a, toRefs(pb.F), pb.c, pb.x0, toRefs(pb.C), pb.bl, pb.bu, pb.xl, pb.xu);
+  FAST_CHECK_EQ(retR, TerminationStatus::SUCCESS);
+
+  FAST_CHECK_UNARY(solverR.solution().isApprox(solverD.solution(), 1e-7));
+  FAST_CHECK_EQ(solverR.objectiveValue(), doctest::Approx(solverD.objectiveValue()));
+}
+} // namespace
+
+TEST_CASE("Unconstrained problem")
+{
+  int nx = 4, nu = 2, N = 10;
+  auto pb = randomOptimalControlProblem(nx, nu, N, 0, false);
+  auto qpp = pb.toDense();
+
+  GoldfarbIdnaniSolver solverD(qpp.G.rows(), qpp.C.cols(), false);
+  solverD.solve(qpp.G, qpp.a, qpp.C, qpp.l, qpp.u, qpp.xl, qpp.xu);
+
+  experimental::RiccatiSolver solverR(nx, nu, N, 0, false);
+  auto retR = solverR.solve(toRefs(pb.H), pb.a, toRefs(pb.F), pb.c, pb.x0, toRefs(pb.C), pb.bl, pb.bu, pb.xl, pb.xu);
+  FAST_CHECK_EQ(retR, TerminationStatus::SUCCESS);
+  FAST_CHECK_EQ(solverR.iterations(), 0);
+  FAST_CHECK_UNARY(solverR.solution().isApprox(solverD.solution(), 1e-8));
+}
+
+TEST_CASE("Compare with dense solver")
+{
+  for(int i = 0; i < 10; ++i)
+  {
+    compareWithDense(4, 2, 10, 3, false);
+    compareWithDense(4, 2, 10, 3, true);
+    compareWithDense(6, 3, 25, 4, true);
+    compareWithDense(3, 1, 5, 2, true);
+  }
+}
+
+TEST_CASE("Warm start")
+{
+  int nx = 4, nu = 2, N = 15, m = 3;
+  auto pb = randomOptimalControlProblem(nx, nu, N, m, true);
+  auto H = toRefs(pb.H);
+  auto F = toRefs(pb.F);
+  auto C = toRefs(pb.C);
+
+  experimental::RiccatiSolver solver(nx, nu, N, (N + 1) * m, true);
+  auto ret = solver.solve(H, pb.a, F, pb.c, pb.x0, C, pb.bl, pb.bu, pb.xl, pb.xu);
+  FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+  VectorXd x = solver.solution();
+  auto as = solver.activeSet();
+
+  SolverOptions opt;
+  opt.warmStart(true);
+  solver.options(opt);
+  ret = solver.solve(H, pb.a, F, pb.c, pb.x0, C, pb.bl, pb.bu, pb.xl, pb.xu, as);
+  FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+  FAST_CHECK_EQ(solver.iterations(), 0);
+  FAST_CHECK_UNARY(solver.solution().isApprox(x, 1e-8));
+}
+
+TEST_CASE("Constraints on the initial state")
+{
+  int nx = 4, nu = 2, N = 10, m = 3;
+  auto pb = randomOptimalControlProblem(nx, nu, N, m, true);
+  // The first constraint acts on x_0 only
+  pb.C[0].col(0).tail(nu).setZero();
+  double v = pb.C[0].col(0).head(nx).dot(pb.x0);
+  pb.bl[0] = v - 1;
+  pb.bu[0] = v + 1;
+  auto H = toRefs(pb.H);
+  auto F = toRefs(pb.F);
+  auto C = toRefs(pb.C);
+
+  experimental::RiccatiSolver solver(nx, nu, N, (N + 1) * m, true);
+  auto ret = solver.solve(H, pb.a, F, pb.c, pb.x0, C, pb.bl, pb.bu, pb.xl, pb.xu);
+  FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+  VectorXd x = solver.solution();
+  auto as = solver.activeSet();
+
+  // Pinning x_0 with its bounds or with the first constraint does not change the
+  // solution, with or without warm start.
+  VectorXd bl = pb.bl;
+  VectorXd bu = pb.bu;
+  VectorXd xl = pb.xl;
+  VectorXd xu = pb.xu;
+  bl[0] = bu[0] = v;
+  xl.head(nx) = xu.head(nx) = pb.x0;
+  for(bool warmStart : {false, true})
+  {
+    SolverOptions opt;
+    opt.warmStart(warmStart);
+    solver.options(opt);
+    if(warmStart)
+    {
+      as[0] = ActivationStatus::EQUALITY;
+      for(int i = 0; i < nx; ++i) as[static_cast<size_t>(bl.size() + i)] = ActivationStatus::FIXED;
+      ret = solver.solve(H, pb.a, F, pb.c, pb.x0, C, bl, bu, xl, xu, as);
+    }
+    else
+      ret = solver.solve(H, pb.a, F, pb.c, pb.x0, C, bl, bu, xl, xu);
+    FAST_CHECK_EQ(ret, TerminationStatus::SUCCESS);
+    FAST_CHECK_UNARY(solver.solution().isApprox(x, 1e-8));
+  }
+
+  // Constraints on x_0 violated by x0
+  solver.options(SolverOptions());
+  bl[0] = bu[0] = v + 0.1;
+  ret = solver.solve(H, pb.a, F, pb.c, pb.x0, C, bl, bu, xl, xu);
+  FAST_CHECK_EQ(ret, TerminationStatus::INFEASIBLE);
+  bl[0] = bu[0] = v;
+  xl[1] = xu[1] = pb.x0[1] + 0.1;
+  ret = solver.solve(H, pb.a, F, pb.c, pb.x0, C, bl, bu, xl, xu);
+  FAST_CHECK_EQ(ret, TerminationStatus::INFEASIBLE);
+}
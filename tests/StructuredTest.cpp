@@ -3,3 +3,527 @@
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
 #include "doctest/doctest.h"
+
+#include <vector>
+
+#include <Eigen/Cholesky>
+
+#include <jrl-qp/decomposition/bandLLT.h>
+#include <jrl-qp/internal/ThreadPool.h>
+#include <jrl-qp/structured/ProblemPattern.h>
+#include <jrl-qp/structured/StructuredC.h>
+#include <jrl-qp/structured/StructuredG.h>
+#include <jrl-qp/structured/StructuredQR.h>
+
+using namespace Eigen;
+using namespace jrl::qp;
+using namespace jrl::qp::structured;
+
+namespace
+{
+/** Check that Q^T [d_0 ... d_{q-1}] = [R; 0] for the vectors d of \p D.*/
+void checkQR(const StructuredQR & qr, const std::vector<VectorXd> & D)
+{
+  const int q = static_cast<int>(D.size());
+  const auto & Q = qr.getPartitionnedQ().Q();
+  for(int j = 0; j < q; ++j)
+  {
+    VectorXd v = D[static_cast<size_t>(j)];
+    Q.applyTransposeToTheLeft(v);
+    FAST_CHECK_LE(v.tail(v.size() - q).norm(), 1e-12);
+    VectorXd r(q);
+    qr.RSolve(r, v.head(q));
+    FAST_CHECK_UNARY(r.isApprox(VectorXd::Unit(q, j), 1e-10));
+  }
+}
+
+/** Add the vector d to the decomposition (StructuredQR::add expects Q^T d).*/
+void add(StructuredQR & qr, const VectorXd & d)
+{
+  VectorXd v = d;
+  qr.getPartitionnedQ().Q().applyTransposeToTheLeft(v);
+  qr.add(v);
+}
+
+/** Randomize the block row i of the factor R of a structured positive definite matrix
+ * (see structuredMatrix). Block i has size n[i] and starts at r[i].
+ */
+void randomizeBlockRow(MatrixXd & R,
+                       StructuredG::Type t,
+                       const std::vector<int> & n,
+                       const std::vector<int> & r,
+                       int i)
+{
+  const int b = static_cast<int>(n.size());
+  R.block(r[i], r[i], n[i], n[i]).setRandom();
+  if(t == StructuredG::Type::TriBlockDiagonal && i > 0)
+    R.block(r[i], r[i - 1], n[i], n[i - 1]).setRandom();
+  else if(t == StructuredG::Type::BlockArrowUp)
+    R.block(r[i], 0, n[i], n[0]).setRandom();
+  else if(t == StructuredG::Type::BlockArrowDown)
+    R.block(r[i], r[b - 1], n[i], n[b - 1]).setRandom();
+}
+
+/** Positive definite matrix with the structure given by t: I + R R^T with R lower
+ * block bidiagonal, or I + R^T R with R block diagonal, plus the first or last block
+ * column for the arrows.
+ */
+MatrixXd structuredMatrix(StructuredG::Type t, const MatrixXd & R)
+{
+  MatrixXd H = MatrixXd::Identity(R.rows(), R.cols());
+  if(t == StructuredG::Type::TriBlockDiagonal)
+    H += R * R.transpose();
+  else
+    H += R.transpose() * R;
+  return H;
+}
+
+/** Get the blocks of H used by StructuredG.*/
+void structuredBlocks(MatrixXd & H,
+                      StructuredG::Type t,
+                      const std::vector<int> & n,
+                      const std::vector<int> & r,
+                      std::vector<MatrixRef> & D,
+                      std::vector<MatrixRef> & S)
+{
+  const int b = static_cast<int>(n.size());
+  for(int i = 0; i < b; ++i)
+  {
+    D.push_back(H.block(r[i], r[i], n[i], n[i]));
+    if(t == StructuredG::Type::TriBlockDiagonal && i > 0) S.push_back(H.block(r[i], r[i - 1], n[i], n[i - 1]));
+    if(t == StructuredG::Type::BlockArrowUp && i > 0) S.push_back(H.block(r[i], 0, n[i], n[0]));
+    if(t == StructuredG::Type::BlockArrowDown && i < b - 1) S.push_back(H.block(r[b - 1], r[i], n[b - 1], n[i]));
+  }
+}
+} // namespace
+
+TEST_CASE("StructuredQR remove")
+{
+  const int n = 20;
+  const int m = 6;
+  // Decoupled vectors (disjoint supports outside of the first m entries) give a
+  // diagonal R: removals only involve swaps. Coupled (random) vectors require Givens
+  // rotations. The mixed case has a leading run of swaps, followed by rotations.
+  std::vector<VectorXd> decoupled, coupled, mixed;
+  for(int j = 0; j < m; ++j)
+  {
+    VectorXd d = VectorXd::Zero(n);
+    d.segment(m + 2 * j, 2).setRandom();
+    decoupled.push_back(d);
+    coupled.push_back(VectorXd::Random(n));
+    mixed.push_back(j < m / 2 ? d : VectorXd::Random(n));
+  }
+
+  for(const auto & D0 : {decoupled, coupled, mixed})
+  {
+    for(int l : {0, 2, m - 1})
+    {
+      StructuredQR qr;
+      qr.resize(n);
+      std::vector<VectorXd> D = D0;
+      for(const auto & d : D) add(qr, d);
+      checkQR(qr, D);
+
+      qr.remove(l);
+      D.erase(D.begin() + l);
+      checkQR(qr, D);
+
+      // Remove until empty, then add again.
+      while(!D.empty())
+      {
+        qr.remove(0);
+        D.erase(D.begin());
+        checkQR(qr, D);
+      }
+      for(const auto & d : D0)
+      {
+        add(qr, d);
+        D.push_back(d);
+      }
+      checkQR(qr, D);
+    }
+  }
+}
+
+TEST_CASE("StructuredC")
+{
+  std::vector<int> n = {3, 5, 2, 4};
+  std::vector<int> m = {2, 0, 3, 2};
+  std::vector<int> r = {0, 3, 8, 10, 14};
+  std::vector<int> c = {0, 2, 2, 5, 7};
+
+  for(int bw : {0, 1, 2, 3})
+  {
+    MatrixXd C0 = MatrixXd::Zero(14, 7);
+    std::vector<MatrixConstRef> D;
+    std::vector<std::vector<MatrixConstRef>> Sub(static_cast<size_t>(bw));
+    for(int i = 0; i < 4; ++i)
+    {
+      C0.block(r[i], c[i], n[i], m[i]).setRandom();
+      D.push_back(C0.block(r[i], c[i], n[i], m[i]));
+      for(int k = 1; k <= bw && i + k < 4; ++k)
+      {
+        C0.block(r[i + k], c[i], n[i + k], m[i]).setRandom();
+        Sub[k - 1].push_back(C0.block(r[i + k], c[i], n[i + k], m[i]));
+      }
+    }
+
+    StructuredC C;
+    if(bw == 0)
+      C = StructuredC(D);
+    else if(bw == 1)
+      C = StructuredC(StructuredC::Type::BlockBidiagonal, D, Sub[0]);
+    else
+      C = StructuredC(D, Sub);
+    FAST_CHECK_EQ(C.nbVar(), 14);
+    FAST_CHECK_EQ(C.nbCstr(), 7);
+    FAST_CHECK_EQ(C.bandwidth(), bw);
+
+    VectorXd v(14);
+    for(int j = 0; j < 7; ++j)
+    {
+      C.col(j).toFullVector(v);
+      FAST_CHECK_UNARY(v == C0.col(j));
+    }
+    // With caller-provided buffers, several columns can be used at the same time.
+    jrl::qp::internal::Workspace<> w1, w2;
+    auto c1 = C.col(1, w1);
+    auto c5 = C.col(5, w2);
+    VectorXd v1(14), v5(14);
+    c1.toFullVector(v1);
+    c5.toFullVector(v5);
+    FAST_CHECK_UNARY(v1 == C0.col(1));
+    FAST_CHECK_UNARY(v5 == C0.col(5));
+
+    VectorXd x = VectorXd::Random(14);
+    VectorXd y(7);
+    C.transposeMult(y, x);
+    FAST_CHECK_UNARY(y.isApprox(C0.transpose() * x));
+  }
+}
+
+TEST_CASE("StructuredG parallel")
+{
+  jrl::qp::internal::ThreadPool pool(3);
+  std::vector<int> n = {4, 3, 5, 2, 3, 4, 1, 3, 2};
+  std::vector<int> r = {0};
+  for(auto ni : n) r.push_back(r.back() + ni);
+  const int s = r.back();
+  const int b = static_cast<int>(n.size());
+
+  for(auto t : {StructuredG::Type::TriBlockDiagonal, StructuredG::Type::BlockArrowUp,
+                StructuredG::Type::BlockArrowDown, StructuredG::Type::BlockDiagonal})
+  {
+    MatrixXd R = MatrixXd::Zero(s, s);
+    for(int i = 0; i < b; ++i) randomizeBlockRow(R, t, n, r, i);
+    MatrixXd H0 = structuredMatrix(t, R);
+    MatrixXd H1 = H0;
+    MatrixXd H2 = H0;
+    std::vector<MatrixRef> D1, S1, D2, S2;
+    structuredBlocks(H1, t, n, r, D1, S1);
+    structuredBlocks(H2, t, n, r, D2, S2);
+
+    StructuredG G1(t, D1, S1);
+    StructuredG G2(t, D2, S2);
+    G2.threadPool(&pool);
+    FAST_CHECK_UNARY(G1.lltInPlace());
+    FAST_CHECK_UNARY(G2.lltInPlace());
+
+    // L^-T L^-1 = H0^-1
+    VectorXd x = VectorXd::Random(s);
+    VectorXd y1(s), y2(s);
+    G1.solveL(y1, x);
+    G1.solveInPlaceLTranspose(y1);
+    G2.solveL(y2, x);
+    G2.solveInPlaceLTranspose(y2);
+    FAST_CHECK_UNARY((H0 * y1).isApprox(x, 1e-8));
+    FAST_CHECK_UNARY(y2.isApprox(y1, 1e-8));
+
+    // Same norms for L^-1 x
+    G1.solveL(y1, x);
+    G2.solveL(y2, x);
+    FAST_CHECK_EQ(y1.norm(), doctest::Approx(y2.norm()));
+
+    // Sparse right-hand sides
+    for(int start : {0, 5, 11, s - 3})
+    {
+      VectorXd e = VectorXd::Random(3);
+      VectorXd full = VectorXd::Zero(s);
+      full.segment(start, 3) = e;
+      G2.solveL(y1, full);
+      G2.solveL(y2, jrl::qp::internal::SingleNZSegmentVector(e, start, s));
+      FAST_CHECK_UNARY(y2.isApprox(y1, 1e-8));
+    }
+
+    // A copy of a decomposed matrix can be used for the solves.
+    StructuredG G3;
+    G3 = G2;
+    G3.solveL(y1, x);
+    G2.solveL(y2, x);
+    FAST_CHECK_UNARY(y2.isApprox(y1, 1e-12));
+  }
+}
+
+TEST_CASE("StructuredG refactorize")
+{
+  jrl::qp::internal::ThreadPool pool(3);
+  std::vector<int> n = {4, 3, 5, 2, 3, 4, 1, 3, 2};
+  std::vector<int> r = {0};
+  for(auto ni : n) r.push_back(r.back() + ni);
+  const int s = r.back();
+  const int b = static_cast<int>(n.size());
+
+  for(auto t : {StructuredG::Type::TriBlockDiagonal, StructuredG::Type::BlockArrowUp,
+                StructuredG::Type::BlockArrowDown, StructuredG::Type::BlockDiagonal})
+  {
+    for(bool parallel : {false, true})
+    {
+      MatrixXd R = MatrixXd::Zero(s, s);
+      for(int i = 0; i < b; ++i) randomizeBlockRow(R, t, n, r, i);
+      MatrixXd H0 = structuredMatrix(t, R);
+      MatrixXd H = H0;
+      std::vector<MatrixRef> D, S, D0, S0;
+      structuredBlocks(H, t, n, r, D, S);
+
+      StructuredG G(t, D, S);
+      if(parallel) G.threadPool(&pool);
+      G.keepOriginal(true);
+      FAST_CHECK_UNARY(G.lltInPlace());
+      FAST_CHECK_UNARY(G.refactorize());
+
+      // Change some block rows of R, and pass the blocks of H0 that changed to G.
+      for(std::vector<int> rows : {std::vector<int>{5}, std::vector<int>{2, 7}, std::vector<int>{0}})
+      {
+        for(int i : rows) randomizeBlockRow(R, t, n, r, i);
+        MatrixXd H1 = structuredMatrix(t, R);
+        std::vector<MatrixRef> D1, S1;
+        D0.clear();
+        S0.clear();
+        structuredBlocks(H0, t, n, r, D0, S0);
+        structuredBlocks(H1, t, n, r, D1, S1);
+        for(int i = 0; i < b; ++i)
+        {
+          if(D1[i] != D0[i]) G.updateDiag(i, D1[i]);
+          if(i < static_cast<int>(S1.size()) && S1[i] != S0[i]) G.updateOffDiag(i, S1[i]);
+        }
+        H0 = H1;
+        FAST_CHECK_UNARY(G.refactorize());
+
+        // L^-T L^-1 = H0^-1
+        VectorXd x = VectorXd::Random(s);
+        VectorXd y(s);
+        G.solveL(y, x);
+        G.solveInPlaceLTranspose(y);
+        FAST_CHECK_UNARY((H0 * y).isApprox(x, 1e-8));
+      }
+
+      // Failure, then recovery
+      G.updateDiag(3, -MatrixXd::Identity(n[3], n[3]));
+      FAST_CHECK_UNARY_FALSE(G.refactorize());
+      G.updateDiag(3, H0.block(r[3], r[3], n[3], n[3]));
+      FAST_CHECK_UNARY(G.refactorize());
+      VectorXd x = VectorXd::Random(s);
+      VectorXd y(s);
+      G.solveL(y, x);
+      G.solveInPlaceLTranspose(y);
+      FAST_CHECK_UNARY((H0 * y).isApprox(x, 1e-8));
+    }
+  }
+}
+
+TEST_CASE("StructuredG banded")
+{
+  const int s = 30;
+  for(int k : {0, 1, 3})
+  {
+    // (k+1) I + R R^T with R lower triangular of bandwidth k/2 has bandwidth at most k.
+    // Small random elements are added on the k-th sub-diagonal.
+    MatrixXd R = MatrixXd::Zero(s, s);
+    for(int j = 0; j < s; ++j)
+      for(int i = j; i <= std::min(s - 1, j + k / 2); ++i) R(i, j) = Eigen::internal::random<double>();
+    MatrixXd H0 = MatrixXd::Identity(s, s) * (k + 1) + R * R.transpose();
+    for(int j = 0; j + k < s && k > 0; ++j) H0(j + k, j) = H0(j, j + k) = 0.5 * Eigen::internal::random<double>();
+
+    // Lower band storage
+    MatrixXd band = MatrixXd::Zero(k + 1, s);
+    for(int j = 0; j < s; ++j)
+      for(int i = 0; i <= k && i + j < s; ++i) band(i, j) = H0(i + j, j);
+    const MatrixXd band0 = band;
+
+    StructuredG G(band);
+    FAST_CHECK_EQ(G.type(), StructuredG::Type::Banded);
+    FAST_CHECK_EQ(G.bandwidth(), k);
+    FAST_CHECK_EQ(G.nbVar(), s);
+    G.keepOriginal(true);
+    FAST_CHECK_UNARY(G.lltInPlace());
+
+    // Same factor as the dense decomposition
+    MatrixXd L = H0.llt().matrixL();
+    for(int j = 0; j < s; ++j)
+      for(int i = 0; i <= k && i + j < s; ++i) FAST_CHECK_EQ(band(i, j), doctest::Approx(L(i + j, j)));
+
+    // L^-T L^-1 = H0^-1
+    VectorXd x = VectorXd::Random(s);
+    VectorXd y(s);
+    G.solveL(y, x);
+    G.solveInPlaceLTranspose(y);
+    FAST_CHECK_UNARY((H0 * y).isApprox(x, 1e-8));
+
+    // Sparse right-hand sides
+    for(int start : {0, 5, 11, s - 3})
+    {
+      VectorXd e = VectorXd::Random(3);
+      VectorXd full = VectorXd::Zero(s);
+      full.segment(start, 3) = e;
+      VectorXd y1(s), y2(s);
+      G.solveL(y1, full);
+      G.solveL(y2, jrl::qp::internal::SingleNZSegmentVector(e, start, s));
+      FAST_CHECK_UNARY(y2.isApprox(y1, 1e-12));
+      FAST_CHECK_UNARY(y2.head(start).isZero());
+    }
+
+    // Resuming the decomposition after changing the last columns
+    MatrixXd band1 = band;
+    band1.rightCols(10) = band0.rightCols(10);
+    band1.row(0).tail(10).array() += 1;
+    MatrixXd band2 = band0;
+    band2.row(0).tail(10).array() += 1;
+    FAST_CHECK_UNARY(jrl::qp::decomposition::bandLLT(band1, s - 10));
+    FAST_CHECK_UNARY(jrl::qp::decomposition::bandLLT(band2));
+    FAST_CHECK_UNARY(band1.isApprox(band2, 1e-12));
+
+    // Refactorization with a new band
+    band2 = band0;
+    band2.row(0).array() += 1;
+    G.updateDiag(0, band2);
+    FAST_CHECK_UNARY(G.refactorize());
+    G.solveL(y, x);
+    G.solveInPlaceLTranspose(y);
+    FAST_CHECK_UNARY(((H0 + MatrixXd::Identity(s, s)) * y).isApprox(x, 1e-8));
+  }
+}
+
+TEST_CASE("StructuredG diagonal plus low rank")
+{
+  const int n = 40;
+  for(int k : {0, 1, 5})
+  {
+    MatrixXd d = MatrixXd::Random(1, n).array() + 1.5;
+    MatrixXd U = MatrixXd::Random(n, k);
+    if(k > 1) U.col(k - 1) = U.col(0); // Rank deficient U
+    const MatrixXd H0 = MatrixXd(d.row(0).asDiagonal()) + U * U.transpose();
+    const MatrixXd d0 = d;
+    const MatrixXd U0 = U;
+
+    StructuredG G(d, U);
+    FAST_CHECK_EQ(G.type(), StructuredG::Type::DiagonalPlusLowRank);
+    FAST_CHECK_EQ(G.nbVar(), n);
+    FAST_CHECK_EQ(G.rank(), k);
+    G.keepOriginal(true);
+    FAST_CHECK_UNARY(G.lltInPlace());
+
+    // L^-T L^-1 = H0^-1, and the factor verifies L L^T = H0
+    VectorXd x = VectorXd::Random(n);
+    VectorXd y(n);
+    G.solveL(y, x);
+    G.solveInPlaceLTranspose(y);
+    FAST_CHECK_UNARY((H0 * y).isApprox(x, 1e-10));
+    MatrixXd Linv(n, n);
+    for(int j = 0; j < n; ++j) G.solveL(Linv.col(j), VectorXd::Unit(n, j));
+    FAST_CHECK_UNARY((Linv * H0 * Linv.transpose()).isIdentity(1e-10));
+
+    // Sparse right-hand side
+    VectorXd e = VectorXd::Random(3);
+    VectorXd full = VectorXd::Zero(n);
+    full.segment(7, 3) = e;
+    VectorXd y1(n), y2(n);
+    G.solveL(y1, full);
+    G.solveL(y2, jrl::qp::internal::SingleNZSegmentVector(e, 7, n));
+    FAST_CHECK_UNARY(y2.isApprox(y1, 1e-12));
+
+    // Refactorization with a new low-rank term
+    MatrixXd U1 = 2 * U0;
+    G.updateOffDiag(0, U1);
+    FAST_CHECK_UNARY(G.refactorize());
+    G.solveL(y, x);
+    G.solveInPlaceLTranspose(y);
+    FAST_CHECK_UNARY(((H0 + 3 * U0 * U0.transpose()) * y).isApprox(x, 1e-10));
+
+    // Non positive diagonal
+    MatrixXd d1 = d0;
+    d1(0, 3) = -1;
+    G.updateDiag(0, d1);
+    FAST_CHECK_UNARY_FALSE(G.refactorize());
+  }
+}
+
+TEST_CASE("ProblemPattern")
+{
+  std::vector<int> n = {4, 3, 5, 2, 3};
+  std::vector<int> m = {2, 0, 3, 2, 1};
+  std::vector<int> r = {0};
+  std::vector<int> c = {0};
+  for(size_t i = 0; i < n.size(); ++i)
+  {
+    r.push_back(r.back() + n[i]);
+    c.push_back(c.back() + m[i]);
+  }
+  const int s = r.back();
+  const int b = static_cast<int>(n.size());
+
+  for(auto t : {StructuredG::Type::TriBlockDiagonal, StructuredG::Type::BlockArrowUp,
+                StructuredG::Type::BlockArrowDown, StructuredG::Type::BlockDiagonal, StructuredG::Type::Banded})
+  {
+    for(int bw : {0, 1, 2})
+    {
+      MatrixXd H;
+      int k = 0;
+      if(t == StructuredG::Type::Banded)
+      {
+        k = 2;
+        MatrixXd R = MatrixXd::Zero(s, s);
+        for(int j = 0; j < s; ++j) R.col(j).segment(j, std::min(2, s - j)).setRandom();
+        H = MatrixXd::Identity(s, s) + R * R.transpose();
+      }
+      else
+      {
+        MatrixXd R = MatrixXd::Zero(s, s);
+        for(int i = 0; i < b; ++i) randomizeBlockRow(R, t, n, r, i);
+        H = structuredMatrix(t, R);
+      }
+      MatrixXd C0 = MatrixXd::Zero(s, c.back());
+      for(int i = 0; i < b; ++i)
+        for(int l = 0; l <= bw && i + l < b; ++l) C0.block(r[i + l], c[i], n[i + l], m[i]).setRandom();
+
+      ProblemPattern pattern(t, n, m, bw, k);
+      FAST_CHECK_EQ(pattern.nbVar(), s);
+      FAST_CHECK_EQ(pattern.nbCstr(), c.back());
+      FAST_CHECK_EQ(pattern.C().bandwidth(), bw);
+      FAST_CHECK_EQ(pattern.G().type(), t);
+
+      // The values can be changed several times, the views always refer to the same storage.
+      for(int rep = 0; rep < 2; ++rep)
+      {
+        C0 *= 2;
+        pattern.setC(C0);
+        VectorXd v(s);
+        for(int j = 0; j < c.back(); ++j)
+        {
+          pattern.C().col(j).toFullVector(v);
+          FAST_CHECK_UNARY(v == C0.col(j));
+        }
+
+        pattern.setG(H);
+        StructuredG G;
+        G = pattern.G();
+        FAST_CHECK_UNARY(G.lltInPlace());
+        VectorXd x = VectorXd::Random(s);
+        VectorXd y(s);
+        G.solveL(y, x);
+        G.solveInPlaceLTranspose(y);
+        FAST_CHECK_UNARY((H * y).isApprox(x, 1e-8));
+        FAST_CHECK_UNARY(pattern.G().decomposed() == false);
+      }
+    }
+  }
+}
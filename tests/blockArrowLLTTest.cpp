@@ -6,6 +6,7 @@
 #include <Eigen/Cholesky>
 
 #include <jrl-qp/decomposition/blockArrowLLT.h>
+#include <jrl-qp/internal/ThreadPool.h>
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
@@ -174,3 +175,75 @@ TEST_CASE("Block up arrow LLT")
     }
   }
 }
+
+TEST_CASE("Parallel block arrow LLT")
+{
+  // Different sizes for the first and last blocks, so that both arrow tips differ.
+  std::vector<int> n = {4, 5, 2, 3, 1, 3, 2};
+  const int s = 20;
+  jrl::qp::internal::ThreadPool pool(3);
+  jrl::qp::internal::Workspace<> work;
+
+  for(bool up : {false, true})
+  {
+    MatrixXd A = blockDiagAndOneColDiagRandom(n, up);
+    MatrixXd H0 = A.transpose() * A + MatrixXd::Identity(s, s);
+    MatrixXd H1 = H0;
+    MatrixXd H2 = H0;
+
+    auto blocks = [&](MatrixXd & H, std::vector<MatrixRef> & D, std::vector<MatrixRef> & S) {
+      int k = 0;
+      for(size_t i = 0; i < n.size(); ++i)
+      {
+        D.push_back(H.block(k, k, n[i], n[i]));
+        if(up && i > 0) S.push_back(H.block(k, 0, n[i], n[0]));
+        if(!up && i + 1 < n.size()) S.push_back(H.block(s - n.back(), k, n.back(), n[i]));
+        k += n[i];
+      }
+    };
+    std::vector<MatrixRef> D1, S1, D2, S2;
+    blocks(H1, D1, S1);
+    blocks(H2, D2, S2);
+
+    FAST_CHECK_UNARY(decomposition::blockArrowLLT(D1, S1, up));
+    FAST_CHECK_UNARY(decomposition::blockArrowLLT(D2, S2, up, pool, work));
+    FAST_CHECK_UNARY(H2.isApprox(H1, 1e-8));
+
+    for(int i = 0; i < s; i += 3)
+    {
+      for(int j = i + 1; j <= s; j += 4)
+      {
+        MatrixXd B = MatrixXd::Zero(s, 5);
+        B.middleRows(i, j - i).setRandom();
+
+        MatrixXd B1 = B;
+        decomposition::blockArrowLSolve(D1, S1, up, B1);
+        MatrixXd B2 = B;
+        decomposition::blockArrowLSolve(D2, S2, up, B2, pool, work, i, j);
+        FAST_CHECK_UNARY(B2.isApprox(B1, 1e-8));
+
+        B1 = B;
+        decomposition::blockArrowLTransposeSolve(D1, S1, up, B1);
+        B2 = B;
+        decomposition::blockArrowLTransposeSolve(D2, S2, up, B2, pool, i, j);
+        FAST_CHECK_UNARY(B2.isApprox(B1, 1e-8));
+      }
+    }
+  }
+
+  // Non positive definite matrix
+  {
+    MatrixXd A = blockDiagAndOneColDiagRandom(n, false);
+    MatrixXd H = A.transpose() * A;
+    H(4, 4) = -1;
+    std::vector<MatrixRef> D, S;
+    int k = 0;
+    for(size_t i = 0; i < n.size(); ++i)
+    {
+      D.push_back(H.block(k, k, n[i], n[i]));
+      if(i + 1 < n.size()) S.push_back(H.block(s - n.back(), k, n.back(), n[i]));
+      k += n[i];
+    }
+    FAST_CHECK_UNARY_FALSE(decomposition::blockArrowLLT(D, S, false, pool, work));
+  }
+}
@@ -1,10 +1,12 @@
 /* Copyright 2020-2021 CNRS-AIST JRL */
 
+#include <algorithm>
 #include <numeric>
 
 #include <Eigen/Cholesky>
 
 #include <jrl-qp/decomposition/triBlockDiagLLT.h>
+#include <jrl-qp/internal/ThreadPool.h>
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
@@ -85,3 +87,108 @@ TEST_CASE("Block tri-diagonal LLT")
     FAST_CHECK_UNARY(B2.isApprox(B0, 1e-8));
   }
 }
+
+TEST_CASE("ThreadPool")
+{
+  for(int t : {1, 2, 4})
+  {
+    jrl::qp::internal::ThreadPool pool(t);
+    FAST_CHECK_EQ(pool.size(), t);
+    for(int n : {0, 1, 3, 100})
+    {
+      std::vector<int> count(static_cast<size_t>(n), 0);
+      for(int k = 0; k < 3; ++k) pool.parallelFor(n, [&](int i) { ++count[static_cast<size_t>(i)]; });
+      FAST_CHECK_EQ(std::count(count.begin(), count.end(), 3), n);
+    }
+  }
+}
+
+TEST_CASE("Parallel block tri-diagonal LLT")
+{
+  jrl::qp::internal::ThreadPool pool(3);
+  std::vector<int> n = {3, 5, 2, 3, 4, 1, 3, 2, 5, 3, 2};
+  int s = std::accumulate(n.begin(), n.end(), 0);
+  MatrixXd A = biBlockDiagRandom(n);
+  MatrixXd H0 = A * A.transpose() + MatrixXd::Identity(s, s);
+
+  for(int p : {1, 2, 3, 4, 5, 20})
+  {
+    MatrixXd H = H0;
+    std::vector<MatrixRef> D, S;
+    int k = 0;
+    for(size_t i = 0; i < n.size(); ++i)
+    {
+      D.push_back(H.block(k, k, n[i], n[i]));
+      if(i + 1 < n.size()) S.push_back(H.block(k + n[i], k, n[i + 1], n[i]));
+      k += n[i];
+    }
+
+    decomposition::ParallelTriBlockDiagLLT llt(pool, p);
+    FAST_CHECK_UNARY(llt.compute(D, S));
+    FAST_CHECK_EQ(llt.nbChunks(), std::min(p, static_cast<int>(n.size()) / 2));
+
+    // X = L^-1 and Y = L^-T must be such that X^T X = Y Y^T = H0^-1
+    MatrixXd X = MatrixXd::Identity(s, s);
+    llt.solveL(D, S, X);
+    MatrixXd Y = MatrixXd::Identity(s, s);
+    llt.solveLTranspose(D, S, Y);
+    FAST_CHECK_UNARY(Y.isApprox(X.transpose(), 1e-8));
+    FAST_CHECK_UNARY((X.transpose() * X * H0).isIdentity(1e-8));
+
+    // Solve with leading zeros
+    MatrixXd B = MatrixXd::Zero(s, 4);
+    B.bottomRows(s - 12).setRandom();
+    MatrixXd B0 = X * B;
+    MatrixXd B1 = B;
+    llt.solveL(D, S, B1, 12);
+    FAST_CHECK_UNARY(B1.isApprox(B0, 1e-8));
+
+    // Full solve
+    VectorXd b = VectorXd::Random(s);
+    VectorXd x = b;
+    llt.solveL(D, S, x);
+    llt.solveLTranspose(D, S, x);
+    FAST_CHECK_UNARY((H0 * x).isApprox(b, 1e-8));
+  }
+
+  // Non positive definite matrix
+  {
+    MatrixXd H = H0;
+    H(s - 2, s - 2) = -1;
+    std::vector<MatrixRef> D, S;
+    int k = 0;
+    for(size_t i = 0; i < n.size(); ++i)
+    {
+      D.push_back(H.block(k, k, n[i], n[i]));
+      if(i + 1 < n.size()) S.push_back(H.block(k + n[i], k, n[i + 1], n[i]));
+      k += n[i];
+    }
+    decomposition::ParallelTriBlockDiagLLT llt(pool);
+    FAST_CHECK_UNARY_FALSE(llt.compute(D, S));
+  }
+}
+
+TEST_CASE("Block tri-diagonal LLT with fixed-size blocks")
+{
+  // Uniform sizes with a fixed-size kernel, and mixed sizes
+  for(std::vector<int> n : {std::vector<int>(8, 6), std::vector<int>(5, 12), std::vector<int>{6, 12, 12, 5, 6, 6}})
+  {
+    int s = std::accumulate(n.begin(), n.end(), 0);
+    MatrixXd A = biBlockDiagRandom(n);
+    MatrixXd H1 = A * A.transpose() + MatrixXd::Identity(s, s);
+    MatrixXd H2 = H1;
+
+    std::vector<MatrixRef> D, S;
+    int k = 0;
+    for(size_t i = 0; i < n.size(); ++i)
+    {
+      D.push_back(H1.block(k, k, n[i], n[i]));
+      if(i + 1 < n.size()) S.push_back(H1.block(k + n[i], k, n[i + 1], n[i]));
+      k += n[i];
+    }
+
+    FAST_CHECK_UNARY(decomposition::triBlockDiagLLT(D, S));
+    Eigen::internal::llt_inplace<double, Eigen::Lower>::blocked(H2);
+    FAST_CHECK_UNARY(H1.isApprox(H2, 1e-8));
+  }
+}